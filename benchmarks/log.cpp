@@ -0,0 +1,827 @@
+#include <benchmark/benchmark.h>
+#include <pride/pride.hpp>
+#include <support/log/flag_formatter.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !defined(PRIDE_OS_WINDOWS)
+#    include <sys/socket.h>
+#    include <sys/un.h>
+#    include <unistd.h>
+#endif
+
+//
+// ─── ALLOCATION COUNTING ────────────────────────────────────────────────────────
+//
+
+static std::atomic<size_t> allocations{ 0 };
+
+void* operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+// gcc pairs the inlined free with operator new, not seeing that it is malloc here
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#    pragma GCC diagnostic push
+#    pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#    pragma GCC diagnostic pop
+#endif
+
+// Reports the heap allocations done inside the timed loop per logged record
+class allocation_counter_t
+{
+public:
+    explicit allocation_counter_t(benchmark::State& state)
+        : _state(state)
+        , _start(allocations.load(std::memory_order_relaxed))
+    {}
+
+    ~allocation_counter_t()
+    {
+        auto count = allocations.load(std::memory_order_relaxed) - _start;
+        _state.counters["allocs_per_record"] = static_cast<double>(count) / static_cast<double>(_state.iterations());
+    }
+
+private:
+    benchmark::State& _state;
+    size_t _start;
+};
+
+//
+// ─── LOGGERS ────────────────────────────────────────────────────────────────────
+//
+
+using namespace pride::log;
+
+static const std::string long_message(2048, 'x');
+
+static logger_t::ptr make_sync_logger(const char* name)
+{
+    auto logger = logger_t::make_new(name);
+    logger->add_channel<channels::null_st>().set_pattern("[%Y-%m-%d %T.%e] [%l] %v");
+    return logger;
+}
+
+static async_logger_t::ptr make_async_logger(const char* name)
+{
+    auto logger = async_logger_t::ptr(new async_logger_t(name, 1024));
+    logger->add_channel<channels::null_mt>().set_pattern("[%Y-%m-%d %T.%e] [%l] %v");
+    return logger;
+}
+
+static deferred_logger_t::ptr make_deferred_logger(const char* name)
+{
+    auto logger = deferred_logger_t::ptr(new deferred_logger_t(name));
+    logger->add_channel<channels::null_mt>().set_pattern("[%Y-%m-%d %T.%e] [%l] %v");
+    return logger;
+}
+
+static void sync_short_message(benchmark::State& state)
+{
+    auto logger = make_sync_logger("sync-short");
+    logger->info("warm up {}", 0);
+
+    allocation_counter_t counter(state);
+    while (state.KeepRunning())
+        logger->info("short message {} {}", 42, "str");
+}
+BENCHMARK(sync_short_message)->Unit(benchmark::kNanosecond);
+
+// Per record cost of each clock a record can be stamped with
+static void sync_clock_source(benchmark::State& state, clock_source_t source)
+{
+    if (!clock_source(source))
+    {
+        state.SkipWithError("clock source not available");
+        return;
+    }
+
+    auto logger = make_sync_logger("sync-clock");
+    logger->info("warm up {}", 0);
+    while (state.KeepRunning())
+        logger->info("short message {} {}", 42, "str");
+    clock_source(clock_source_t::precise);
+}
+BENCHMARK_CAPTURE(sync_clock_source, precise, clock_source_t::precise)->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(sync_clock_source, coarse, clock_source_t::coarse)->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(sync_clock_source, tsc, clock_source_t::tsc)->Unit(benchmark::kNanosecond);
+
+static void clock_read(benchmark::State& state, clock_source_t source)
+{
+    if (!clock_source(source))
+    {
+        state.SkipWithError("clock source not available");
+        return;
+    }
+
+    while (state.KeepRunning())
+        benchmark::DoNotOptimize(internal::now());
+    clock_source(clock_source_t::precise);
+}
+BENCHMARK_CAPTURE(clock_read, precise, clock_source_t::precise)->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(clock_read, coarse, clock_source_t::coarse)->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(clock_read, tsc, clock_source_t::tsc)->Unit(benchmark::kNanosecond);
+
+static void sync_ct_format_message(benchmark::State& state)
+{
+    auto logger = make_sync_logger("sync-ct-format");
+    logger->info(PRIDE_FMT("warm up {}"), 0);
+
+    allocation_counter_t counter(state);
+    while (state.KeepRunning())
+        logger->info(PRIDE_FMT("short message {} {}"), 42, "str");
+}
+BENCHMARK(sync_ct_format_message)->Unit(benchmark::kNanosecond);
+
+static void sync_three_channels(benchmark::State& state)
+{
+    auto logger = make_sync_logger("sync-three-channels");
+    logger->add_channel<channels::null_st>().add_channel<channels::null_st>().set_pattern("[%Y-%m-%d %T.%e] [%l] %v");
+    logger->info("warm up {}", 0);
+
+    allocation_counter_t counter(state);
+    while (state.KeepRunning())
+        logger->info("short message {} {}", 42, "str");
+}
+BENCHMARK(sync_three_channels)->Unit(benchmark::kNanosecond);
+
+static void sync_file_channel(benchmark::State& state)
+{
+    auto logger = logger_t::make_new("sync-file");
+    logger->add_channel<channels::basic_file_st>("/dev/null").set_pattern("[%Y-%m-%d %T.%e] [%l] %v");
+
+    while (state.KeepRunning())
+        logger->info("short message {} {}", 42, "str");
+}
+BENCHMARK(sync_file_channel)->Unit(benchmark::kNanosecond);
+
+static void sync_buffered_file_channel(benchmark::State& state)
+{
+    auto channel = std::make_shared<channels::buffered_file_st>("/dev/null");
+    auto logger = logger_t::make_new("sync-buffered-file");
+    logger->add_channel(channel).set_pattern("[%Y-%m-%d %T.%e] [%l] %v");
+
+    while (state.KeepRunning())
+        logger->info("short message {} {}", 42, "str");
+    state.counters["writes_per_record"] = static_cast<double>(channel->submissions()) / static_cast<double>(state.iterations());
+}
+BENCHMARK(sync_buffered_file_channel)->Unit(benchmark::kNanosecond);
+
+static void sync_mapped_file_channel(benchmark::State& state)
+{
+    const char* path = "bench-mapped.log";
+    {
+        auto channel = std::make_shared<channels::mapped_file_st>(path, true);
+        auto logger = logger_t::make_new("sync-mapped-file");
+        logger->add_channel(channel).set_pattern("[%Y-%m-%d %T.%e] [%l] %v");
+
+        while (state.KeepRunning())
+            logger->info("short message {} {}", 42, "str");
+        state.counters["stalls"] = static_cast<double>(channel->stalls());
+    }
+    std::remove(path);
+}
+BENCHMARK(sync_mapped_file_channel)->Unit(benchmark::kNanosecond);
+
+static void sync_binary_file_channel(benchmark::State& state)
+{
+    const std::string path = "bench-binary.plog";
+    {
+        auto logger = logger_t::make_new("sync-binary-file");
+        logger->add_channel<channels::binary_file_st>(path);
+
+        while (state.KeepRunning())
+            logger->info("short message {} {}", 42, "str");
+    }
+    for (auto& segment : binary_reader_t(path).segments())
+        std::remove(segment.c_str());
+}
+BENCHMARK(sync_binary_file_channel)->Unit(benchmark::kNanosecond);
+
+// A thread of the benchmark plays the collector process
+static void shm_ring_channel(benchmark::State& state)
+{
+    const std::string name = "/pride-bench-ring";
+    auto channel = std::make_shared<channels::shm_ring_st>(name);
+    auto logger = logger_t::make_new("shm-ring");
+    logger->add_channel(channel);
+
+    std::atomic<bool> done{ false };
+    std::thread collector([&] {
+        shm_reader_t reader(name);
+        internal::backoff_t backoff;
+        while (!done.load(std::memory_order_relaxed) || reader.pending() > 0)
+        {
+            if (reader.drain([](const message_t& msg) { benchmark::DoNotOptimize(msg.raw.size()); }) > 0)
+                backoff.reset();
+            else
+                backoff.pause();
+        }
+    });
+
+    while (state.KeepRunning())
+        logger->info("short message {} {}", 42, "str");
+
+    done = true;
+    collector.join();
+    state.counters["dropped"] = static_cast<double>(channel->dropped());
+    channels::shm_ring_st::remove(name);
+}
+BENCHMARK(shm_ring_channel)->Unit(benchmark::kNanosecond);
+
+#if !defined(PRIDE_OS_WINDOWS)
+// A unix stream listener drained by a thread stands in for the local collector.
+// batch_size 0 sends every record on its own, like syslog_t does.
+static void socket_channel(benchmark::State& state)
+{
+    const std::string path = "/tmp/pride-bench.sock";
+    ::unlink(path.c_str());
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.data(), path.size());
+    ::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    ::listen(listener, 1);
+
+    std::thread collector([&] {
+        int peer = ::accept(listener, nullptr, nullptr);
+        char buffer[65536];
+        while (::recv(peer, buffer, sizeof(buffer), 0) > 0)
+            ;
+        ::close(peer);
+    });
+
+    auto channel = std::make_shared<channels::socket_st>(pride::os::socket_endpoint_t::unix_stream(path));
+    channel->batch_size(static_cast<size_t>(state.range(0)));
+    auto logger = logger_t::make_new("socket");
+    logger->add_channel(channel);
+
+    while (state.KeepRunning())
+        logger->info("short message {} {}", 42, "str");
+    logger->flush();
+
+    state.counters["dropped"] = static_cast<double>(channel->dropped());
+    state.counters["batches"] = static_cast<double>(channel->batches());
+    logger.reset();
+    channel.reset();
+    collector.join();
+    ::close(listener);
+    ::unlink(path.c_str());
+}
+BENCHMARK(socket_channel)->Arg(0)->Arg(64 * 1024)->Unit(benchmark::kNanosecond);
+#endif
+
+static void isolated_channel(benchmark::State& state)
+{
+    auto channel = std::make_shared<channels::isolated>(std::make_shared<channels::null_st>(), 8192, overflow_policy_t::block);
+    auto logger = logger_t::make_new("isolated");
+    logger->add_channel(channel).set_pattern("[%Y-%m-%d %T.%e] [%l] %v");
+
+    while (state.KeepRunning())
+        logger->info("short message {} {}", 42, "str");
+    logger->flush();
+    state.counters["max_latency_ns"] = static_cast<double>(channel->stats().max_latency.count());
+}
+BENCHMARK(isolated_channel)->Unit(benchmark::kNanosecond);
+
+// Stands in for stdout piped to /dev/null so the benchmark output stays readable
+struct dev_null_stream
+{
+    static FILE* stream()
+    {
+        static FILE* file = std::fopen("/dev/null", "w");
+        return file;
+    }
+};
+
+static void console_channel(benchmark::State& state, channels::console_mode_t mode)
+{
+    auto channel = std::make_shared<channels::internal::console<dev_null_stream, std::mutex>>();
+    channel->mode(mode).pattern("[%Y-%m-%d %T.%e] [%l] %v");
+    auto logger = logger_t::make_new("console");
+    logger->add_channel(channel);
+
+    while (state.KeepRunning())
+        logger->info("short message {} {}", 42, "str");
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_CAPTURE(console_channel, unbuffered, channels::console_mode_t::unbuffered)->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(console_channel, buffered, channels::console_mode_t::buffered)->Unit(benchmark::kNanosecond);
+
+static void deferred_short_message(benchmark::State& state)
+{
+    auto logger = make_deferred_logger("deferred-short");
+    PRIDE_LOG_DEFERRED(*logger, sevarity_t::warn, "warm up {}", 0);
+    logger->flush();
+
+    // only the producer is measured, the backend drains the ring while the
+    // timer is paused so a record never waits for room
+    size_t pending = 0;
+    {
+        allocation_counter_t counter(state);
+        while (state.KeepRunning())
+        {
+            PRIDE_LOG_DEFERRED(*logger, sevarity_t::warn, "short message {} {} {}", 42, 3.14, 'c');
+            if (++pending == 4096)
+            {
+                state.PauseTiming();
+                logger->flush();
+                pending = 0;
+                state.ResumeTiming();
+            }
+        }
+        logger->flush();
+    }
+}
+BENCHMARK(deferred_short_message)->Unit(benchmark::kNanosecond);
+
+static void format_runtime_string(benchmark::State& state)
+{
+    fmt::memory_buffer buffer;
+    while (state.KeepRunning())
+    {
+        buffer.resize(0);
+        fmt::format_to(buffer, "request {} from {} took {}us", 1234, "10.0.0.1", 56);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+}
+BENCHMARK(format_runtime_string)->Unit(benchmark::kNanosecond);
+
+static void format_ct_string(benchmark::State& state)
+{
+    fmt::memory_buffer buffer;
+    constexpr auto format = PRIDE_FMT("request {} from {} took {}us");
+    while (state.KeepRunning())
+    {
+        buffer.resize(0);
+        decltype(format)::format(buffer, 1234, "10.0.0.1", 56);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+}
+BENCHMARK(format_ct_string)->Unit(benchmark::kNanosecond);
+
+static void format_with(benchmark::State& state, formatter_t& formatter)
+{
+    const std::string name = "pattern";
+    message_t msg(&name, sevarity_t::info);
+    fmt::format_to(msg.raw, "request {} from {} took {}us", 1234, "10.0.0.1", 56);
+
+    fmt::memory_buffer buffer;
+    while (state.KeepRunning())
+    {
+        msg.time = internal::now();
+        buffer.resize(0);
+        formatter.format(msg, buffer);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+}
+
+static void format_pattern(benchmark::State& state, const char* pattern)
+{
+    pattern_formatter_t formatter(pattern);
+    format_with(state, formatter);
+}
+BENCHMARK_CAPTURE(format_pattern, full, "%+")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, date_time, "[%Y-%m-%d %H:%M:%S.%e] [%l] %v")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, source, "%T.%f %L %n %s:%# %v")->Unit(benchmark::kNanosecond);
+
+// The patterns above as one virtual flag object per flag, the way they were
+// formatted before they were compiled
+static void format_flag_objects(benchmark::State& state, const char* pattern)
+{
+    internal::flag_pattern_formatter_t formatter(pattern);
+    format_with(state, formatter);
+}
+BENCHMARK_CAPTURE(format_flag_objects, full, "%+")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_flag_objects, date_time, "[%Y-%m-%d %H:%M:%S.%e] [%l] %v")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_flag_objects, source, "%T.%f %L %n %s:%# %v")->Unit(benchmark::kNanosecond);
+
+// and compiled at compile time
+static void format_static_pattern_full(benchmark::State& state)
+{
+    static_pattern_formatter_t formatter(PRIDE_PATTERN("%+"));
+    format_with(state, formatter);
+}
+BENCHMARK(format_static_pattern_full)->Unit(benchmark::kNanosecond);
+
+static void format_static_pattern_date_time(benchmark::State& state)
+{
+    static_pattern_formatter_t formatter(PRIDE_PATTERN("[%Y-%m-%d %H:%M:%S.%e] [%l] %v"));
+    format_with(state, formatter);
+}
+BENCHMARK(format_static_pattern_date_time)->Unit(benchmark::kNanosecond);
+
+static void format_static_pattern_source(benchmark::State& state)
+{
+    static_pattern_formatter_t formatter(PRIDE_PATTERN("%T.%f %L %n %s:%# %v"));
+    format_with(state, formatter);
+}
+BENCHMARK(format_static_pattern_source)->Unit(benchmark::kNanosecond);
+
+// every flag on its own, `empty` is the cost of the end of line alone
+BENCHMARK_CAPTURE(format_pattern, empty, "")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_n, "%n")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_l, "%l")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_L, "%L")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_t, "%t")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_P, "%P")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_i, "%i")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_v, "%v")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_source, "%@")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_g, "%g")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_s, "%s")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_line, "%#")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_function, "%!")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_a, "%a")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_A, "%A")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_b, "%b")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_B, "%B")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_c, "%c")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_C, "%C")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_Y, "%Y")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_D, "%D")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_m, "%m")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_d, "%d")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_H, "%H")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_I, "%I")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_M, "%M")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_S, "%S")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_e, "%e")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_f, "%f")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_F, "%F")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_E, "%E")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_p, "%p")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_r, "%r")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_R, "%R")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_T, "%T")->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(format_pattern, flag_z, "%z")->Unit(benchmark::kNanosecond);
+
+template<typename Formatter>
+static void format_structured(benchmark::State& state)
+{
+    const std::string name = "structured";
+    message_t msg(&name, sevarity_t::info);
+    fmt::format_to(msg.raw, "request {} from {} took {}us", 1234, "10.0.0.1", 56);
+    if (state.range(0) != 0)
+        msg.fields.add({ { "request", 1234 }, { "peer", "10.0.0.1" }, { "took", 56u } });
+
+    Formatter formatter;
+    fmt::memory_buffer buffer;
+    while (state.KeepRunning())
+    {
+        msg.time = internal::now();
+        buffer.resize(0);
+        formatter.format(msg, buffer);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+}
+BENCHMARK_TEMPLATE(format_structured, json_formatter_t)->Arg(0)->Arg(1)->Unit(benchmark::kNanosecond);
+BENCHMARK_TEMPLATE(format_structured, logfmt_formatter_t)->Arg(0)->Arg(1)->Unit(benchmark::kNanosecond);
+
+static void sync_long_message(benchmark::State& state)
+{
+    auto logger = make_sync_logger("sync-long");
+    logger->info("{}", long_message);
+
+    allocation_counter_t counter(state);
+    while (state.KeepRunning())
+        logger->info("{}", long_message);
+}
+BENCHMARK(sync_long_message)->Unit(benchmark::kNanosecond);
+
+static void async_long_message(benchmark::State& state)
+{
+    auto logger = make_async_logger("async-long");
+    for (int i = 0; i < 2048; ++i)
+        logger->info("{}", long_message);
+    logger->flush();
+
+    {
+        allocation_counter_t counter(state);
+        while (state.KeepRunning())
+            logger->info("{}", long_message);
+        logger->flush();
+    }
+}
+BENCHMARK(async_long_message)->Unit(benchmark::kNanosecond);
+
+static void filtered_method(benchmark::State& state)
+{
+    auto logger = make_sync_logger("filtered_method");
+    while (state.KeepRunning())
+        logger->debug("value {}", std::to_string(state.iterations()));
+}
+BENCHMARK(filtered_method)->Unit(benchmark::kNanosecond);
+
+static void filtered_macro(benchmark::State& state)
+{
+    auto logger = make_sync_logger("filtered_macro");
+    while (state.KeepRunning())
+        PRIDE_LOG_DEBUG(*logger, "value {}", std::to_string(state.iterations()));
+}
+BENCHMARK(filtered_macro)->Unit(benchmark::kNanosecond);
+
+static void sync_macro_message(benchmark::State& state)
+{
+    auto logger = make_sync_logger("sync_macro_message");
+    logger->set_pattern("[%Y-%m-%d %T.%e] [%l] [%s:%#] %v");
+    while (state.KeepRunning())
+        PRIDE_LOG_INFO(*logger, "short message {}", 42);
+}
+BENCHMARK(sync_macro_message)->Unit(benchmark::kNanosecond);
+
+static void backtrace_store(benchmark::State& state)
+{
+    auto logger = make_sync_logger("backtrace_store");
+    logger->enable_backtrace(1024);
+
+    allocation_counter_t counter(state);
+    while (state.KeepRunning())
+        logger->debug("short message {} {}", 42, "str");
+}
+BENCHMARK(backtrace_store)->Unit(benchmark::kNanosecond);
+
+static void rate_limited_message(benchmark::State& state)
+{
+    auto logger = make_sync_logger("rate_limited_message");
+    limits_t limits;
+    limits.rate = 100;
+    limits.burst = 10;
+    logger->limits(limits);
+
+    allocation_counter_t counter(state);
+    while (state.KeepRunning())
+        logger->info("short message {} {}", 42, "str");
+}
+BENCHMARK(rate_limited_message)->Unit(benchmark::kNanosecond);
+
+static void registry_lookup_name(benchmark::State& state)
+{
+    for (int i = 0; i < 100; ++i)
+        logger_t::create("bench.registry." + std::to_string(i));
+    const std::string name = "bench.registry.42";
+
+    while (state.KeepRunning())
+        benchmark::DoNotOptimize(logger_t::get(name));
+}
+BENCHMARK(registry_lookup_name)->Unit(benchmark::kNanosecond);
+
+static void registry_lookup_key(benchmark::State& state)
+{
+    for (int i = 0; i < 100; ++i)
+        logger_t::create("bench.registry." + std::to_string(i));
+
+    while (state.KeepRunning())
+        benchmark::DoNotOptimize(PRIDE_LOGGER("bench.registry.42"));
+}
+BENCHMARK(registry_lookup_key)->Unit(benchmark::kNanosecond);
+
+//
+// ─── THROUGHPUT ─────────────────────────────────────────────────────────────────
+//
+
+// Swallows everything written to it, the ostream channel pays for the stream
+// machinery without the cost of a device
+class null_buffer_t : public std::streambuf
+{
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+};
+
+template<typename Channel>
+static std::shared_ptr<Channel> make_channel()
+{
+    return std::make_shared<Channel>();
+}
+
+template<>
+std::shared_ptr<channels::basic_file_mt> make_channel()
+{
+    return std::make_shared<channels::basic_file_mt>("/dev/null");
+}
+
+template<>
+std::shared_ptr<channels::ostream_mt> make_channel()
+{
+    static null_buffer_t buffer;
+    static std::ostream stream(&buffer);
+    return std::make_shared<channels::ostream_mt>(stream);
+}
+
+using stdout_dev_null = channels::internal::console<dev_null_stream, std::mutex>;
+
+// Every thread of a run logs through the same logger, items_per_second is the
+// rate of the whole process
+template<typename Channel>
+static void throughput(benchmark::State& state)
+{
+    static auto logger = [] {
+        auto instance = logger_t::make_new("throughput");
+        instance->add_channel(make_channel<Channel>()).set_pattern("[%Y-%m-%d %T.%e] [%l] %v");
+        return instance;
+    }();
+
+    while (state.KeepRunning())
+        logger->info("short message {} {}", 42, "str");
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(throughput, channels::null_mt)->ThreadRange(1, 8)->UseRealTime()->Unit(benchmark::kNanosecond);
+BENCHMARK_TEMPLATE(throughput, channels::basic_file_mt)->ThreadRange(1, 8)->UseRealTime()->Unit(benchmark::kNanosecond);
+BENCHMARK_TEMPLATE(throughput, channels::ostream_mt)->ThreadRange(1, 8)->UseRealTime()->Unit(benchmark::kNanosecond);
+BENCHMARK_TEMPLATE(throughput, stdout_dev_null)->ThreadRange(1, 8)->UseRealTime()->Unit(benchmark::kNanosecond);
+
+//
+// ─── WORKLOADS ──────────────────────────────────────────────────────────────────
+//
+
+enum class workload_t
+{
+    literal, // nothing to format
+    small,   // a few short arguments
+    large    // one 2 KiB argument
+};
+
+static void log_workload(logger_t& logger, workload_t workload)
+{
+    switch (workload)
+    {
+    case workload_t::literal: logger.info("connection accepted"); break;
+    case workload_t::small: logger.info("request {} from {} took {}us", 1234, "10.0.0.1", 56); break;
+    case workload_t::large: logger.info("{}", long_message); break;
+    }
+}
+
+static logger_t::ptr sync_logger()
+{
+    return make_sync_logger("sync");
+}
+
+static logger_t::ptr async_logger()
+{
+    auto logger = make_async_logger("async");
+    logger->overflow_policy(overflow_policy_t::block);
+    return logger;
+}
+
+static logger_t::ptr isolated_logger()
+{
+    auto logger = logger_t::make_new("isolated");
+    logger->add_channel<channels::isolated>(std::make_shared<channels::null_st>(), 1024, overflow_policy_t::block).set_pattern("[%Y-%m-%d %T.%e] [%l] %v");
+    return logger;
+}
+
+static void workload(benchmark::State& state, logger_t::ptr (*make_logger)(), workload_t kind)
+{
+    auto logger = make_logger();
+    {
+        allocation_counter_t counter(state);
+        while (state.KeepRunning())
+            log_workload(*logger, kind);
+        logger->flush();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_CAPTURE(workload, sync_literal, &sync_logger, workload_t::literal)->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(workload, sync_small, &sync_logger, workload_t::small)->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(workload, sync_large, &sync_logger, workload_t::large)->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(workload, async_literal, &async_logger, workload_t::literal)->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(workload, async_small, &async_logger, workload_t::small)->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(workload, async_large, &async_logger, workload_t::large)->Unit(benchmark::kNanosecond);
+
+//
+// ─── LATENCY ────────────────────────────────────────────────────────────────────
+//
+
+// Times every record on its own and reports percentiles of the samples in
+// nanoseconds. Reading the clock twice is part of every sample, the `clock`
+// run measures that floor.
+class latency_recorder_t
+{
+public:
+    static constexpr size_t max_samples = 1 << 20;
+
+    explicit latency_recorder_t(benchmark::State& state)
+        : _state(state)
+    {
+        _samples.reserve(max_samples);
+    }
+
+    ~latency_recorder_t()
+    {
+        if (_samples.empty())
+            return;
+
+        std::sort(_samples.begin(), _samples.end());
+        auto percentile = [this](double p) { return static_cast<double>(_samples[static_cast<size_t>(p * static_cast<double>(_samples.size() - 1))]); };
+        _state.counters["p50_ns"] = percentile(0.5);
+        _state.counters["p99_ns"] = percentile(0.99);
+        _state.counters["p999_ns"] = percentile(0.999);
+        _state.counters["max_ns"] = static_cast<double>(_samples.back());
+    }
+
+    template<typename Fn>
+    void measure(Fn&& fn)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        if (_samples.size() < max_samples)
+            _samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+private:
+    benchmark::State& _state;
+    std::vector<int64_t> _samples;
+};
+
+static void latency(benchmark::State& state, logger_t::ptr (*make_logger)())
+{
+    auto logger = make_logger ? make_logger() : nullptr;
+    {
+        latency_recorder_t recorder(state);
+        while (state.KeepRunning())
+        {
+            if (logger)
+                recorder.measure([&] { logger->info("request {} from {} took {}us", 1234, "10.0.0.1", 56); });
+            else
+                recorder.measure([] {});
+        }
+    }
+    if (logger)
+        logger->flush();
+}
+BENCHMARK_CAPTURE(latency, clock, nullptr)->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(latency, sync, &sync_logger)->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(latency, async, &async_logger)->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(latency, isolated, &isolated_logger)->Unit(benchmark::kNanosecond);
+
+// File channels writing to a real file, the buffered one writes on the
+// logging thread when its buffer fills, the io_uring one hands it off
+static const char* latency_file = "bench-latency.log";
+
+static logger_t::ptr buffered_file_logger()
+{
+    auto logger = logger_t::make_new("buffered-file");
+    logger->add_channel<channels::buffered_file_st>(latency_file, true).set_pattern("[%Y-%m-%d %T.%e] [%l] %v");
+    return logger;
+}
+
+static logger_t::ptr uring_file_logger()
+{
+    auto logger = logger_t::make_new("uring-file");
+    logger->add_channel<channels::uring_file_st>(latency_file, true).set_pattern("[%Y-%m-%d %T.%e] [%l] %v");
+    return logger;
+}
+
+static logger_t::ptr uring_fallback_file_logger()
+{
+    auto logger = logger_t::make_new("uring-fallback-file");
+    logger->add_channel<channels::uring_file_st>(latency_file, true, channels::uring_file_st::default_buffer_size, channels::uring_file_st::default_buffer_count, false)
+        .set_pattern("[%Y-%m-%d %T.%e] [%l] %v");
+    return logger;
+}
+
+static logger_t::ptr mapped_file_logger()
+{
+    auto logger = logger_t::make_new("mapped-file");
+    logger->add_channel<channels::mapped_file_st>(latency_file, true).set_pattern("[%Y-%m-%d %T.%e] [%l] %v");
+    return logger;
+}
+
+static void file_latency(benchmark::State& state, logger_t::ptr (*make_logger)())
+{
+    latency(state, make_logger);
+    std::remove(latency_file);
+}
+BENCHMARK_CAPTURE(file_latency, buffered_file, &buffered_file_logger)->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(file_latency, uring_file, &uring_file_logger)->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(file_latency, uring_fallback_file, &uring_fallback_file_logger)->Unit(benchmark::kNanosecond);
+BENCHMARK_CAPTURE(file_latency, mapped_file, &mapped_file_logger)->Unit(benchmark::kNanosecond);
+
+BENCHMARK_MAIN();
@@ -59,15 +59,35 @@ namespace internal::fnv1a
         return !*key ? h : compute64(key + 1, mulu64(h ^ *key, constant<hash64_t>::prime));
     }
 
+    // Hashes exactly `len` characters so the input does not have to be null
+    // terminated, used for string views at run time
+    template<typename Char>
+    constexpr hash32_t compute32_len(const Char* key, size_t len)
+    {
+        hash32_t h = constant<hash32_t>::offset;
+        for (size_t i = 0; i < len; ++i)
+            h = static_cast<hash32_t>(1ULL * (h ^ key[i]) * constant<hash32_t>::prime);
+        return h;
+    }
+
+    template<typename Char>
+    constexpr hash64_t compute64_len(const Char* key, size_t len)
+    {
+        hash64_t h = constant<hash64_t>::offset;
+        for (size_t i = 0; i < len; ++i)
+            h = (h ^ key[i]) * constant<hash64_t>::prime;
+        return h;
+    }
+
     template<typename Hash, typename Char>
     constexpr Hash fnv1a(const Char* input, size_t len)
     {
         static_assert(std::is_same<Char, char>() || std::is_same<Char, wchar_t>(), "Input type is not supported");
         static_assert(std::is_same<Hash, hash64_t>() || std::is_same<Hash, hash32_t>(), "Hash type is not supported");
         if constexpr (std::is_same<Hash, hash64_t>::value)
-            return compute64(input);
+            return compute64_len(input, len);
         else
-            return compute32(input);
+            return compute32_len(input, len);
     }
 } // namespace internal::fnv1a
 
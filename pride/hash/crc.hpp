@@ -73,15 +73,35 @@ namespace internal::crc
     };
 
 #define DO1(buf) crc = crc_table[((int)crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
-#define DO2(buf) \
-    DO1(buf);    \
-    DO1(buf);
-#define DO4(buf) \
-    DO2(buf);    \
-    DO2(buf);
-#define DO8(buf) \
-    DO4(buf);    \
-    DO4(buf);
+
+    // Tables for slicing by 8, slice[n][b] is the crc of byte b followed by n
+    // zero bytes. Eight bytes are folded in with eight lookups instead of
+    // eight dependent ones.
+    struct slice_table_t
+    {
+        uint32_t slice[8][256];
+    };
+
+    constexpr slice_table_t make_slice_table()
+    {
+        slice_table_t table{};
+        for (int i = 0; i < 256; ++i)
+            table.slice[0][i] = crc_table[i];
+        for (int n = 1; n < 8; ++n)
+        {
+            for (int i = 0; i < 256; ++i)
+                table.slice[n][i] = (table.slice[n - 1][i] >> 8) ^ crc_table[table.slice[n - 1][i] & 0xff];
+        }
+        return table;
+    }
+
+    inline constexpr slice_table_t slice_table = make_slice_table();
+
+    // little endian load from bytes, a single load where the host is little endian
+    inline uint32_t load32(const uint8_t* data)
+    {
+        return uint32_t(data[0]) | uint32_t(data[1]) << 8 | uint32_t(data[2]) << 16 | uint32_t(data[3]) << 24;
+    }
 
     template<typename Hash>
     Hash compute(const void* key, size_t len, Hash seed);
@@ -89,12 +109,17 @@ namespace internal::crc
     template<>
     inline uint32_t compute(const void* key, size_t len, uint32_t seed)
     {
-        uint8_t* data = (uint8_t*)key;
+        const uint8_t* data = static_cast<const uint8_t*>(key);
         uint32_t crc = seed ^ 0xffffffffL;
 
+        const auto& slice = slice_table.slice;
         while (len >= 8)
         {
-            DO8(data);
+            auto one = load32(data) ^ crc;
+            auto two = load32(data + 4);
+            crc = slice[7][one & 0xff] ^ slice[6][(one >> 8) & 0xff] ^ slice[5][(one >> 16) & 0xff] ^ slice[4][one >> 24]
+                ^ slice[3][two & 0xff] ^ slice[2][(two >> 8) & 0xff] ^ slice[1][(two >> 16) & 0xff] ^ slice[0][two >> 24];
+            data += 8;
             len -= 8;
         }
 
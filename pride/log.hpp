@@ -1,12 +1,20 @@
 
 #pragma once
 
+#include "log/async_logger.hpp"
+#include "log/binary_reader.hpp"
 #include "log/channel.hpp"
+#include "log/clock.hpp"
+#include "log/deferred_logger.hpp"
+#include "log/field.hpp"
 #include "log/fmt.hpp"
+#include "log/format_string.hpp"
 #include "log/formatter.hpp"
 #include "log/logger.hpp"
 #include "log/message.hpp"
 #include "log/sevarity.hpp"
+#include "log/shm_reader.hpp"
+#include "log/structured.hpp"
 
 #include "log/channels.hpp"
 
@@ -0,0 +1,250 @@
+#pragma once
+
+#include "internal/backoff.hpp"
+#include "internal/queue.hpp"
+#include "logger.hpp"
+#include "message.hpp"
+#include "overflow_policy.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pride::log
+{
+// Logger that hands finished records to one or more backend threads through a
+// bounded lock free queue. The calling thread only pays for formatting the
+// user message into a pooled record and pushing its pointer, the channels run
+// on the workers which hand the record back to the producer's pool.
+class async_logger_t : public logger_t
+{
+public:
+    using ptr = std::shared_ptr<async_logger_t>;
+
+    static constexpr size_t default_queue_size = 8192;
+
+    static ptr create(std::string name, size_t queue_size = default_queue_size, size_t workers = 1);
+
+    async_logger_t(std::string name, size_t queue_size = default_queue_size, size_t workers = 1);
+    ~async_logger_t() override;
+
+    async_logger_t(const async_logger_t&) = delete;
+    async_logger_t& operator=(const async_logger_t&) = delete;
+
+    size_t queue_size() const { return _queue.capacity(); }
+    size_t workers() const { return _threads.size(); }
+
+    async_logger_t& overflow_policy(overflow_policy_t policy)
+    {
+        _policy.store(policy, std::memory_order_relaxed);
+        return *this;
+    }
+    overflow_policy_t overflow_policy() const { return _policy.load(std::memory_order_relaxed); }
+
+protected:
+    void _proecss(message_ptr& msg) override;
+    void _flush() override;
+
+private:
+    enum class command_t : uint8_t
+    {
+        log,
+        flush,
+        terminate
+    };
+
+    struct item_t
+    {
+        command_t command{ command_t::log };
+        message_ptr msg;
+    };
+
+    void _enqueue(item_t&& item);
+    void _enqueue_record(item_t&& item);
+    void _worker();
+    void _arrive_at_flush();
+
+    internal::mpmc_queue_t<item_t> _queue;
+    internal::parker_t _parker; // idle workers
+    std::vector<std::thread> _threads;
+    std::atomic<overflow_policy_t> _policy{ overflow_policy_t::block };
+
+    // Every worker has to take one flush command before the channels are
+    // flushed. A worker waits in the barrier after taking its command so it
+    // can not take a second one, which means everything queued before the
+    // flush call has been written once the last worker arrives.
+    std::mutex _flush_mutex;
+    std::mutex _barrier_mutex;
+    std::condition_variable _barrier_cv;
+    size_t _barrier_count{ 0 };
+    uint64_t _barrier_generation{ 0 };
+};
+
+// ────────────────────────────────────────────────────────────────────────────────
+
+inline async_logger_t::ptr async_logger_t::create(std::string name, size_t queue_size, size_t workers)
+{
+    auto instance = ptr(new async_logger_t(std::move(name), queue_size, workers));
+    _register(instance);
+    return instance;
+}
+
+// ────────────────────────────────────────────────────────────────────────────────
+
+inline async_logger_t::async_logger_t(std::string name, size_t queue_size, size_t workers)
+    : logger_t(std::move(name))
+    , _queue(queue_size)
+{
+    if (workers == 0)
+        workers = 1;
+
+    _threads.reserve(workers);
+    for (size_t i = 0; i < workers; ++i)
+        _threads.emplace_back([this] { _worker(); });
+}
+
+inline async_logger_t::~async_logger_t()
+{
+    _stop_reporting();
+
+    // The queue is fifo so every record pushed before the terminate commands
+    // is taken by a worker before it sees its own terminate command.
+    for (size_t i = 0; i < _threads.size(); ++i)
+        _enqueue(item_t{ command_t::terminate, nullptr });
+
+    for (auto& thread : _threads)
+        thread.join();
+
+    logger_t::_flush();
+}
+
+// ────────────────────────────────────────────────────────────────────────────────
+
+inline void async_logger_t::_proecss(message_ptr& msg)
+{
+    _enqueue_record(item_t{ command_t::log, std::move(msg) });
+}
+
+inline void async_logger_t::_flush()
+{
+    std::lock_guard<std::mutex> guard(_flush_mutex);
+
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(_barrier_mutex);
+        generation = _barrier_generation;
+    }
+
+    for (size_t i = 0; i < _threads.size(); ++i)
+        _enqueue(item_t{ command_t::flush, nullptr });
+
+    std::unique_lock<std::mutex> lock(_barrier_mutex);
+    _barrier_cv.wait(lock, [&] { return _barrier_generation != generation; });
+}
+
+// ────────────────────────────────────────────────────────────────────────────────
+
+// Commands always wait for room, only records are subject to the policy
+inline void async_logger_t::_enqueue(item_t&& item)
+{
+    internal::backoff_t backoff;
+    while (!_queue.try_push(std::move(item)))
+        backoff.pause();
+    _parker.notify();
+}
+
+inline void async_logger_t::_enqueue_record(item_t&& item)
+{
+    if (_queue.try_push(std::move(item)))
+    {
+        _counters.enqueued.fetch_add(1, std::memory_order_relaxed);
+        _parker.notify();
+        return;
+    }
+
+    switch (overflow_policy())
+    {
+    case overflow_policy_t::block:
+        _enqueue(std::move(item));
+        break;
+
+    case overflow_policy_t::drop_newest:
+        _counters.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+
+    case overflow_policy_t::overwrite_oldest:
+    {
+        item_t oldest;
+        while (!_queue.try_push(std::move(item)))
+        {
+            if (!_queue.try_pop(oldest))
+                continue;
+
+            if (oldest.command == command_t::log)
+                _counters.overwritten.fetch_add(1, std::memory_order_relaxed);
+            else
+                _enqueue(std::move(oldest)); // never lose a flush or terminate
+        }
+        _parker.notify();
+        break;
+    }
+    }
+
+    _counters.enqueued.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void async_logger_t::_worker()
+{
+    item_t item;
+    internal::backoff_t backoff;
+    for (;;)
+    {
+        if (!_queue.try_pop(item))
+        {
+            backoff.pause(_parker, [this] { return !_queue.empty(); });
+            continue;
+        }
+        backoff.reset();
+
+        switch (item.command)
+        {
+        case command_t::log:
+            // a throwing channel must not take the worker down with it
+            try
+            {
+                _dispatch(*item.msg);
+            }
+            catch (...)
+            {
+            }
+            item.msg.reset(); // hand the record back to its pool right away
+            break;
+        case command_t::flush:
+            _arrive_at_flush();
+            break;
+        case command_t::terminate:
+            return;
+        }
+    }
+}
+
+inline void async_logger_t::_arrive_at_flush()
+{
+    std::unique_lock<std::mutex> lock(_barrier_mutex);
+    if (++_barrier_count == _threads.size())
+    {
+        logger_t::_flush();
+        _barrier_count = 0;
+        ++_barrier_generation;
+        _barrier_cv.notify_all();
+        return;
+    }
+
+    auto generation = _barrier_generation;
+    _barrier_cv.wait(lock, [&] { return _barrier_generation != generation; });
+}
+} // namespace pride::log
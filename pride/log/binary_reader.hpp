@@ -0,0 +1,241 @@
+#pragma once
+
+#include "formatter.hpp"
+#include "internal/binary_format.hpp"
+#include "message.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pride::log
+{
+// Reads back the segments written by channels::binary_file.
+//
+// Segments whose time span misses the requested range are skipped by their
+// footer and the index of a segment is used to start close to the first
+// record in range. A segment without a footer, or with a footer that does not
+// check out, is scanned from its start. Reading a segment stops at the first
+// frame with a bad size or crc, the rest of it is skipped as a corrupt tail.
+class binary_reader_t
+{
+public:
+    using time_point = std::chrono::system_clock::time_point;
+
+    // `filename` is the name the channel was created with
+    explicit binary_reader_t(std::string filename)
+        : _filename(std::move(filename))
+    {}
+
+    // Files of the segments, oldest first
+    std::vector<std::string> segments() const
+    {
+        std::vector<std::string> names;
+        for (uint64_t index = 1;; ++index)
+        {
+            auto name = internal::binary::segment_name(_filename, index);
+            if (!std::ifstream(name).good())
+                return names;
+            names.push_back(std::move(name));
+        }
+    }
+
+    // Calls fn(const message_t&) for every record logged in [from, to], in the
+    // order they were written. Returns the number of records.
+    template<typename Fn>
+    size_t read(time_point from, time_point to, Fn&& fn)
+    {
+        return _read(_nanoseconds(from), _nanoseconds(to), fn);
+    }
+
+    template<typename Fn>
+    size_t read(Fn&& fn)
+    {
+        return _read(std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max(), fn);
+    }
+
+    // Formats the records logged in [from, to] and writes them to `out`
+    size_t read(time_point from, time_point to, formatter_t& formatter, std::ostream& out)
+    {
+        fmt::memory_buffer buffer;
+        return read(from, to, [&](const message_t& msg) {
+            buffer.resize(0);
+            formatter.format(msg, buffer);
+            out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        });
+    }
+
+    // Frames looked at by the last read
+    size_t scanned() const { return _scanned; }
+
+    // Bytes of corrupt segment tails skipped by the last read
+    size_t skipped() const { return _skipped; }
+
+private:
+    using frame_header_t = internal::binary::frame_header_t;
+    using segment_header_t = internal::binary::segment_header_t;
+    using segment_trailer_t = internal::binary::segment_trailer_t;
+    using index_entry_t = internal::binary::index_entry_t;
+
+    static int64_t _nanoseconds(time_point time)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    }
+
+    template<typename Fn>
+    size_t _read(int64_t from, int64_t to, Fn& fn)
+    {
+        _scanned = 0;
+        _skipped = 0;
+        size_t count = 0;
+        for (auto& segment : segments())
+            count += _read_segment(segment, from, to, fn);
+        return count;
+    }
+
+    template<typename Fn>
+    size_t _read_segment(const std::string& name, int64_t from, int64_t to, Fn& fn)
+    {
+        std::ifstream file(name, std::ios::binary);
+        file.seekg(0, std::ios::end);
+        const auto size = static_cast<uint64_t>(file.tellg());
+
+        segment_header_t header;
+        if (size < sizeof(header) || !_load(file, 0, &header, sizeof(header)) || std::memcmp(header.magic, internal::binary::segment_magic, sizeof(header.magic)) != 0)
+        {
+            _skipped += size;
+            return 0;
+        }
+
+        uint64_t start = header.header_size;
+        uint64_t end = size;
+        segment_trailer_t trailer;
+        if (_sealed(file, size, trailer))
+        {
+            if (trailer.last < from || trailer.first > to)
+                return 0;
+
+            end = trailer.footer;
+            auto entries = reinterpret_cast<const index_entry_t*>(_footer.data());
+            uint32_t first = 0;
+            for (uint32_t i = 0; i < trailer.index_count && entries[i].newest < from; ++i)
+            {
+                start = entries[i].offset;
+                first = i;
+            }
+
+            // the records past an entry are all newer than the range when the
+            // oldest of every interval from there on is
+            int64_t oldest = std::numeric_limits<int64_t>::max();
+            for (auto i = trailer.index_count; i > first + 1; --i)
+            {
+                oldest = std::min(oldest, entries[i - 1].oldest);
+                if (oldest > to)
+                    end = entries[i - 1].offset;
+            }
+            _load_names(trailer);
+        }
+
+        if (end <= start)
+            return 0;
+        _data.resize(end - start);
+        if (!_load(file, start, _data.data(), _data.size()))
+        {
+            _skipped += end - start;
+            return 0;
+        }
+
+        size_t count = 0;
+        size_t offset = 0;
+        while (offset < _data.size())
+        {
+            frame_header_t frame;
+            if (_data.size() - offset < sizeof(frame))
+                break;
+            std::memcpy(&frame, _data.data() + offset, sizeof(frame));
+            const char* payload = _data.data() + offset + sizeof(frame);
+            if (frame.size < sizeof(frame) || frame.size % 8 != 0 || frame.size > _data.size() - offset || frame.length > frame.size - sizeof(frame) || frame.crc != internal::binary::frame_crc(frame, payload))
+                break;
+
+            ++_scanned;
+            offset += frame.size;
+            if (frame.kind == internal::binary::frame_kind_t::name)
+                _names[frame.logger].assign(payload, frame.length);
+            else if (frame.kind == internal::binary::frame_kind_t::record && frame.time >= from && frame.time <= to)
+            {
+                _emit(frame, payload, fn);
+                ++count;
+            }
+        }
+        _skipped += _data.size() - offset;
+        return count;
+    }
+
+    template<typename Fn>
+    void _emit(const frame_header_t& frame, const char* payload, Fn& fn)
+    {
+        _message.names = &_names[frame.logger];
+        _message.sevarity = static_cast<sevarity_t>(frame.level);
+        _message.time = time_point(std::chrono::duration_cast<time_point::duration>(std::chrono::nanoseconds(frame.time)));
+        _message.thread_id = static_cast<size_t>(frame.thread);
+        _message.raw.resize(0);
+        _message.raw.append(payload, payload + frame.length);
+        fn(static_cast<const message_t&>(_message));
+    }
+
+    // Loads the footer of a sealed segment into _footer
+    bool _sealed(std::ifstream& file, uint64_t size, segment_trailer_t& trailer)
+    {
+        if (size < sizeof(segment_header_t) + sizeof(trailer) || !_load(file, size - sizeof(trailer), &trailer, sizeof(trailer)))
+            return false;
+        if (std::memcmp(trailer.magic, internal::binary::trailer_magic, sizeof(trailer.magic)) != 0 || trailer.footer < sizeof(segment_header_t) || trailer.footer > size - sizeof(trailer))
+            return false;
+
+        _footer.resize(size - trailer.footer);
+        if (!_load(file, trailer.footer, _footer.data(), _footer.size()))
+            return false;
+
+        auto checked = _footer.size() - sizeof(trailer) + offsetof(segment_trailer_t, crc);
+        return internal::binary::crc(_footer.data(), checked) == trailer.crc && trailer.index_count * sizeof(index_entry_t) <= _footer.size() - sizeof(trailer);
+    }
+
+    void _load_names(const segment_trailer_t& trailer)
+    {
+        size_t offset = trailer.index_count * sizeof(index_entry_t);
+        const size_t end = _footer.size() - sizeof(trailer);
+        for (uint32_t i = 0; i < trailer.name_count && offset + 12 <= end; ++i)
+        {
+            uint64_t id;
+            uint32_t size;
+            std::memcpy(&id, _footer.data() + offset, sizeof(id));
+            std::memcpy(&size, _footer.data() + offset + sizeof(id), sizeof(size));
+            if (size > end - offset - 12)
+                return;
+            _names[id].assign(_footer.data() + offset + 12, size);
+            offset += internal::binary::align(12 + size);
+        }
+    }
+
+    static bool _load(std::ifstream& file, uint64_t offset, void* data, size_t size)
+    {
+        file.clear();
+        file.seekg(static_cast<std::streamoff>(offset));
+        file.read(static_cast<char*>(data), static_cast<std::streamsize>(size));
+        return file.good() || (file.eof() && static_cast<size_t>(file.gcount()) == size);
+    }
+
+    const std::string _filename;
+    std::unordered_map<uint64_t, std::string> _names;
+    std::vector<char> _data;
+    std::vector<char> _footer;
+    message_t _message;
+    size_t _scanned{ 0 };
+    size_t _skipped{ 0 };
+};
+} // namespace pride::log
@@ -4,8 +4,10 @@
 #include "../utility/shareable.hpp"
 #include "fmt.hpp"
 #include "formatter.hpp"
+#include "internal/rcu.hpp"
 #include "message.hpp"
 #include "sevarity.hpp"
+#include <atomic>
 #include <initializer_list>
 #include <memory>
 #include <mutex>
@@ -20,13 +22,28 @@ public:
     using init_list = std::initializer_list<channel_t>;
 
     channel_t()
-        : _formatter(std::unique_ptr<formatter_t>(new pattern_formatter_t("%+")))
+        : _formatter(new pattern_formatter_t("%+"))
     {}
-    virtual ~channel_t() = default;
+    virtual ~channel_t() { delete _formatter.load(std::memory_order_relaxed); }
 
     virtual void log(const message_t& msg) = 0;
     virtual void flush() = 0;
 
+    // Formats the record into `formatted` and logs it so the text can be
+    // handed to channels with the same format signature. Returns the
+    // signature of the formatter that made the text, which can differ from
+    // an earlier format_signature() when the formatter was replaced since.
+    // Returns nullptr when the channel formats on its own and `formatted`
+    // was not filled.
+    virtual const std::string* format_and_log(const message_t& msg, fmt::memory_buffer& formatted);
+
+    // Logs text produced by a channel with the same format signature
+    virtual void log_formatted(const message_t& msg, const fmt::memory_buffer& formatted);
+
+    // Only stable inside a read section (internal::rcu_t::read_guard_t), the
+    // formatter can be replaced while other threads log
+    const std::string& format_signature() const { return _formatter.load(std::memory_order_seq_cst)->signature(); }
+
     bool should_log(sevarity_t level) const;
 
     bool use_sevarity() const;
@@ -34,26 +51,28 @@ public:
 
     channel_t& sevarity(sevarity_t sevarity)
     {
-        _sevarity = sevarity;
+        _sevarity.store(sevarity, std::memory_order_relaxed);
         return *this;
     }
-    sevarity_t sevarity() const { return _sevarity; }
+    sevarity_t sevarity() const { return _sevarity.load(std::memory_order_relaxed); }
 
-    channel_t& formatter(std::unique_ptr<formatter_t> format)
+    // Safe while other threads log, records already being formatted finish
+    // with the old formatter. Channels that wrap another one hand it on.
+    virtual channel_t& formatter(std::unique_ptr<formatter_t> format);
+    channel_t& pattern(const std::string& pattern)
     {
-        _formatter = std::move(format);
-        return *this;
+        return formatter(std::unique_ptr<formatter_t>(new pattern_formatter_t(pattern)));
     }
-    channel_t& pattern(const std::string& pattern)
+    template<typename Holder>
+    channel_t& pattern(pattern_string_t<Holder> pattern)
     {
-        _formatter = std::unique_ptr<formatter_t>(new pattern_formatter_t(pattern));
-        return *this;
+        return formatter(std::unique_ptr<formatter_t>(new static_pattern_formatter_t<Holder>(pattern)));
     }
 
 protected:
-    sevarity_t _sevarity{ sevarity_t::trace };
-    bool _use_sevarity{ false };
-    std::unique_ptr<formatter_t> _formatter;
+    std::atomic<sevarity_t> _sevarity{ sevarity_t::trace };
+    std::atomic<bool> _use_sevarity{ false };
+    std::atomic<formatter_t*> _formatter;
 };
 
 template<typename Mutex>
@@ -70,11 +89,18 @@ public:
     void log(const message_t& msg) final override;
     void flush() final override;
 
+    const std::string* format_and_log(const message_t& msg, fmt::memory_buffer& formatted) final override;
+    void log_formatted(const message_t& msg, const fmt::memory_buffer& formatted) final override;
+
 protected:
     virtual void _process(const message_t& msg, const fmt::memory_buffer& formatted) = 0;
     virtual void _flush() = 0;
 
     Mutex _mutex;
+
+private:
+    // reused for every record so a long message only grows it once
+    fmt::memory_buffer _formatted;
 };
 
 //
@@ -83,28 +109,65 @@ protected:
 
 inline bool channel_t::use_sevarity() const
 {
-    return _use_sevarity;
+    return _use_sevarity.load(std::memory_order_relaxed);
 }
 
 inline channel_t& channel_t::use_sevarity(bool value)
 {
-    _use_sevarity = value;
+    _use_sevarity.store(value, std::memory_order_relaxed);
     return *this;
 }
 
 inline bool channel_t::should_log(sevarity_t level) const
 {
-    return level >= _sevarity;
+    return level >= _sevarity.load(std::memory_order_relaxed);
+}
+
+inline channel_t& channel_t::formatter(std::unique_ptr<formatter_t> format)
+{
+    auto old = _formatter.exchange(format.release(), std::memory_order_seq_cst);
+    internal::rcu_t::instance().retire(old);
+    return *this;
+}
+
+inline const std::string* channel_t::format_and_log(const message_t& msg, fmt::memory_buffer&)
+{
+    log(msg);
+    return nullptr;
+}
+
+inline void channel_t::log_formatted(const message_t& msg, const fmt::memory_buffer&)
+{
+    log(msg);
 }
 
 // ────────────────────────────────────────────────────────────────────────────────
 
 template<typename Mutex>
 void base_channel<Mutex>::log(const message_t& msg)
+{
+    internal::rcu_t::read_guard_t guard;
+    std::lock_guard<Mutex> lock(_mutex);
+    _formatted.resize(0);
+    _formatter.load(std::memory_order_seq_cst)->format(msg, _formatted);
+    _process(msg, _formatted);
+}
+
+template<typename Mutex>
+const std::string* base_channel<Mutex>::format_and_log(const message_t& msg, fmt::memory_buffer& formatted)
+{
+    internal::rcu_t::read_guard_t guard;
+    std::lock_guard<Mutex> lock(_mutex);
+    auto formatter = _formatter.load(std::memory_order_seq_cst);
+    formatter->format(msg, formatted);
+    _process(msg, formatted);
+    return &formatter->signature();
+}
+
+template<typename Mutex>
+void base_channel<Mutex>::log_formatted(const message_t& msg, const fmt::memory_buffer& formatted)
 {
     std::lock_guard<Mutex> lock(_mutex);
-    fmt::memory_buffer formatted;
-    _formatter->format(msg, formatted);
     _process(msg, formatted);
 }
 
@@ -1,8 +1,17 @@
 
 #pragma once
 
+#include "channels/binary_file.hpp"
+#include "channels/buffered_file.hpp"
 #include "channels/console.hpp"
 #include "channels/file.hpp"
+#include "channels/isolated.hpp"
+#include "channels/mapped_file.hpp"
 #include "channels/msvc.hpp"
+#include "channels/null.hpp"
 #include "channels/ostream.hpp"
+#include "channels/rotating_file.hpp"
+#include "channels/shm_ring.hpp"
+#include "channels/socket.hpp"
 #include "channels/syslog.hpp"
+#include "channels/uring_file.hpp"
@@ -0,0 +1,283 @@
+#pragma once
+
+#include "../../os/file.hpp"
+#include "../channel.hpp"
+#include "../internal/binary_format.hpp"
+#include "../internal/null.hpp"
+#include "../internal/registry.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pride::log::channels
+{
+namespace internal
+{
+    // File channel that writes framed binary records instead of text, read
+    // them back with binary_reader_t. Each record keeps its time, level,
+    // thread, logger and message with a crc32, the formatter of the channel is
+    // not used.
+    //
+    // Records go into segments of about segment_size bytes named app.00000001.plog,
+    // app.00000002.plog and so on. Every index_interval bytes the segment
+    // notes where the records are in time, the index and the logger names are
+    // written in a footer when the segment is full or the channel goes away.
+    // A channel opened on existing segments starts a new one after them.
+    template<typename Mutex>
+    class binary_file : public channel_t
+    {
+    public:
+        static constexpr size_t default_segment_size = 64 * 1024 * 1024;
+        static constexpr size_t default_index_interval = 64 * 1024;
+        static constexpr size_t buffer_size = 64 * 1024;
+
+        explicit binary_file(const std::string& filename, size_t segment_size = default_segment_size, size_t index_interval = default_index_interval)
+            : channel_t()
+            , _filename(filename)
+            , _segment_size(segment_size)
+            , _index_interval(std::max<size_t>(index_interval, 1))
+            , _buffer(new char[buffer_size])
+        {
+            while (_exists(log::internal::binary::segment_name(_filename, _segment + 1)))
+                ++_segment;
+            _open_next();
+        }
+
+        ~binary_file() override
+        {
+            std::lock_guard<Mutex> lock(_mutex);
+            _seal();
+        }
+
+        binary_file(const binary_file&) = delete;
+        binary_file& operator=(const binary_file&) = delete;
+
+        void log(const message_t& msg) override
+        {
+            std::lock_guard<Mutex> lock(_mutex);
+            _record(msg);
+            if (msg.sevarity >= _flush_on)
+                _submit();
+        }
+
+        void flush() override
+        {
+            std::lock_guard<Mutex> lock(_mutex);
+            _submit();
+        }
+
+        // Records at or above this level are written out right away
+        binary_file& flush_on(sevarity_t level)
+        {
+            std::lock_guard<Mutex> lock(_mutex);
+            _flush_on = level;
+            return *this;
+        }
+
+        const std::string& filename() const { return _filename; }
+
+        // Number of the segment being written, the first one is 1
+        uint64_t segment() const
+        {
+            std::lock_guard<Mutex> lock(_mutex);
+            return _segment;
+        }
+
+    private:
+        using frame_header_t = log::internal::binary::frame_header_t;
+        using frame_kind_t = log::internal::binary::frame_kind_t;
+
+        static bool _exists(const std::string& name)
+        {
+            return std::ifstream(name).good();
+        }
+
+        static int64_t _nanoseconds(std::chrono::system_clock::time_point time)
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+        }
+
+        void _record(const message_t& msg)
+        {
+            // the id of a logger is the hash of its name, looked up again only
+            // when the record comes from another logger
+            if (_last_id == 0 || msg.names != _last_names || (msg.names != nullptr && *msg.names != _last_name))
+            {
+                _last_names = msg.names;
+                _last_name = msg.names != nullptr ? *msg.names : std::string();
+                _last_id = logger_key_t(std::string_view(_last_name)).value;
+                _last_named = _named(_last_id);
+            }
+
+            auto size = sizeof(frame_header_t) + log::internal::binary::align(msg.raw.size());
+            if (!_last_named)
+                size += sizeof(frame_header_t) + log::internal::binary::align(_last_name.size());
+            if (_offset + size > _segment_size && _offset > sizeof(log::internal::binary::segment_header_t))
+            {
+                _seal();
+                _open_next();
+            }
+
+            auto time = _nanoseconds(msg.time);
+            if (!_last_named)
+            {
+                _frame(frame_kind_t::name, time, msg.thread_id, _last_id, msg.sevarity, _last_name.data(), _last_name.size());
+                _names.emplace_back(_last_id, _last_name);
+                _last_named = true;
+            }
+            _frame(frame_kind_t::record, time, msg.thread_id, _last_id, msg.sevarity, msg.raw.data(), msg.raw.size());
+            _first = std::min(_first, time);
+            _last = std::max(_last, time);
+            _index.back().oldest = std::min(_index.back().oldest, time);
+        }
+
+        bool _named(uint64_t id) const
+        {
+            return std::any_of(_names.begin(), _names.end(), [id](const auto& name) { return name.first == id; });
+        }
+
+        void _frame(frame_kind_t kind, int64_t time, size_t thread, uint64_t logger, sevarity_t level, const char* payload, size_t length)
+        {
+            if (_offset >= _next_index)
+            {
+                _index.push_back({ _last, std::numeric_limits<int64_t>::max(), _offset });
+                _next_index = _offset + _index_interval;
+            }
+
+            frame_header_t frame{};
+            frame.size = static_cast<uint32_t>(sizeof(frame) + log::internal::binary::align(length));
+            frame.time = time;
+            frame.thread = thread;
+            frame.logger = logger;
+            frame.length = static_cast<uint32_t>(length);
+            frame.kind = kind;
+            frame.level = static_cast<uint8_t>(level);
+            frame.crc = log::internal::binary::frame_crc(frame, payload);
+
+            static constexpr char padding[8] = {};
+            _append(&frame, sizeof(frame));
+            _append(payload, length);
+            _append(padding, frame.size - sizeof(frame) - length);
+            _offset += frame.size;
+        }
+
+        void _append(const void* data, size_t size)
+        {
+            if (size > buffer_size - _used)
+            {
+                _submit();
+                if (size > buffer_size)
+                {
+                    _file.write(static_cast<const char*>(data), size);
+                    return;
+                }
+            }
+            std::memcpy(_buffer.get() + _used, data, size);
+            _used += size;
+        }
+
+        void _submit()
+        {
+            if (_used == 0)
+                return;
+            _file.write(_buffer.get(), _used);
+            _used = 0;
+        }
+
+        void _open_next()
+        {
+            ++_segment;
+            _file.open(log::internal::binary::segment_name(_filename, _segment), true);
+            _offset = 0;
+            _next_index = sizeof(log::internal::binary::segment_header_t);
+            _index.clear();
+            _names.clear();
+            _last_named = false;
+            _first = std::numeric_limits<int64_t>::max();
+            _last = std::numeric_limits<int64_t>::min();
+
+            log::internal::binary::segment_header_t header{};
+            std::memcpy(header.magic, log::internal::binary::segment_magic, sizeof(header.magic));
+            header.version = log::internal::binary::version;
+            header.header_size = sizeof(header);
+            header.index = _segment;
+            header.created = _nanoseconds(log::internal::now());
+            _append(&header, sizeof(header));
+            _offset = sizeof(header);
+        }
+
+        // writes the footer and closes the segment
+        void _seal()
+        {
+            fmt::memory_buffer footer;
+            auto append = [&footer](const void* data, size_t size) {
+                auto bytes = static_cast<const char*>(data);
+                footer.append(bytes, bytes + size);
+            };
+
+            for (auto& entry : _index)
+                append(&entry, sizeof(entry));
+            for (auto& name : _names)
+            {
+                auto size = static_cast<uint32_t>(name.second.size());
+                static constexpr char padding[8] = {};
+                append(&name.first, sizeof(name.first));
+                append(&size, sizeof(size));
+                append(name.second.data(), size);
+                append(padding, log::internal::binary::align(sizeof(name.first) + sizeof(size) + size) - sizeof(name.first) - sizeof(size) - size);
+            }
+
+            log::internal::binary::segment_trailer_t trailer{};
+            std::memcpy(trailer.magic, log::internal::binary::trailer_magic, sizeof(trailer.magic));
+            trailer.footer = _offset;
+            trailer.index_count = static_cast<uint32_t>(_index.size());
+            trailer.name_count = static_cast<uint32_t>(_names.size());
+            trailer.first = _first;
+            trailer.last = _last;
+            append(&trailer, offsetof(log::internal::binary::segment_trailer_t, crc));
+            trailer.crc = log::internal::binary::crc(footer.data(), footer.size());
+            append(reinterpret_cast<const char*>(&trailer) + offsetof(log::internal::binary::segment_trailer_t, crc), sizeof(trailer) - offsetof(log::internal::binary::segment_trailer_t, crc));
+
+            _submit();
+            _file.write(footer.data(), footer.size());
+            _file.close();
+        }
+
+        const std::string _filename;
+        const size_t _segment_size;
+        const size_t _index_interval;
+
+        mutable Mutex _mutex;
+        os::raw_file_t _file;
+        std::unique_ptr<char[]> _buffer;
+        size_t _used{ 0 };
+        sevarity_t _flush_on{ sevarity_t::off };
+
+        // segment being written
+        uint64_t _segment{ 0 };
+        uint64_t _offset{ 0 };
+        uint64_t _next_index{ 0 };
+        int64_t _first{ 0 };
+        int64_t _last{ 0 };
+        std::vector<log::internal::binary::index_entry_t> _index;
+        std::vector<std::pair<uint64_t, std::string>> _names;
+
+        // logger of the last record
+        const std::string* _last_names{ nullptr };
+        std::string _last_name;
+        uint64_t _last_id{ 0 };
+        bool _last_named{ false };
+    };
+} // namespace internal
+
+using binary_file_mt = internal::binary_file<std::mutex>;
+using binary_file_st = internal::binary_file<log::internal::null_mutex>;
+} // namespace pride::log::channels
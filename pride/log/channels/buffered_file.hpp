@@ -0,0 +1,135 @@
+#pragma once
+
+#include "../../os/file.hpp"
+#include "../channel.hpp"
+#include "../internal/flusher.hpp"
+#include "../internal/null.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+
+namespace pride::log::channels
+{
+namespace internal
+{
+    // File channel that collects formatted records in a large buffer and hands
+    // it to the kernel in one write. The buffer goes out when the next record
+    // does not fit (together with that record as a single gather write), when
+    // a record at or above the flush_on level arrives, on flush, and every
+    // flush interval when one is set. A write that fails keeps the buffer for
+    // the next one, records that no longer fit next to it are dropped.
+    template<typename Mutex>
+    class buffered_file : public base_channel<Mutex>
+    {
+    public:
+        static constexpr size_t default_buffer_size = 256 * 1024;
+
+        explicit buffered_file(const std::string& filename, bool truncate = false, size_t buffer_size = default_buffer_size)
+            : base_channel<Mutex>()
+            , _buffer(new char[buffer_size])
+            , _capacity(buffer_size)
+        {
+            // a file that does not open fails every write
+            _file.open(filename, truncate);
+        }
+
+        ~buffered_file() override
+        {
+            _flusher.stop();
+            std::lock_guard<Mutex> lock(this->_mutex);
+            _submit(nullptr, 0);
+        }
+
+        buffered_file(const buffered_file&) = delete;
+        buffered_file& operator=(const buffered_file&) = delete;
+
+        // Records at or above this level are written out right away
+        buffered_file& flush_on(sevarity_t level)
+        {
+            std::lock_guard<Mutex> lock(this->_mutex);
+            _flush_on = level;
+            return *this;
+        }
+
+        // Writes the buffer out at least this often from a background thread,
+        // zero turns it off
+        buffered_file& flush_every(std::chrono::milliseconds interval)
+        {
+            static_assert(!std::is_same_v<Mutex, log::internal::null_mutex>, "flush_every needs the thread safe channel");
+
+            _flusher.start(interval, [this] { this->flush(); });
+            return *this;
+        }
+
+        // Number of writes handed to the kernel so far, and the ones among them
+        // that failed
+        uint64_t submissions() const { return _submissions.load(std::memory_order_relaxed); }
+        uint64_t failures() const { return _failures.load(std::memory_order_relaxed); }
+
+        // Records lost because the file could not take them
+        uint64_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+    protected:
+        void _process(const message_t& msg, const fmt::memory_buffer& formatted) override
+        {
+            if (formatted.size() > _capacity - _used)
+            {
+                if (!_submit(formatted.data(), formatted.size()))
+                    _dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                std::memcpy(_buffer.get() + _used, formatted.data(), formatted.size());
+                _used += formatted.size();
+            }
+
+            if (msg.sevarity >= _flush_on)
+                _submit(nullptr, 0);
+        }
+
+        void _flush() override
+        {
+            _submit(nullptr, 0);
+        }
+
+    private:
+        // writes the buffer followed by `extra` and empties the buffer, on a
+        // failed write the buffer is left as it was
+        bool _submit(const char* extra, size_t extra_size)
+        {
+            if (_used == 0 && extra_size == 0)
+                return true;
+
+            _submissions.fetch_add(1, std::memory_order_relaxed);
+            bool ok = _used == 0 ? _file.write(extra, extra_size) : _file.write(_buffer.get(), _used, extra, extra_size);
+            if (!ok)
+            {
+                _failures.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            _used = 0;
+            return true;
+        }
+
+        os::raw_file_t _file;
+        std::unique_ptr<char[]> _buffer;
+        const size_t _capacity;
+        size_t _used{ 0 };
+        sevarity_t _flush_on{ sevarity_t::off };
+        std::atomic<uint64_t> _submissions{ 0 };
+        std::atomic<uint64_t> _failures{ 0 };
+        std::atomic<uint64_t> _dropped{ 0 };
+
+        log::internal::periodic_flusher_t _flusher;
+    };
+} // namespace internal
+
+using buffered_file_mt = internal::buffered_file<std::mutex>;
+using buffered_file_st = internal::buffered_file<log::internal::null_mutex>;
+} // namespace pride::log::channels
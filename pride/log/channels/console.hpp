@@ -1,15 +1,25 @@
-
 #pragma once
 
 #include "../channel.hpp"
 #include "../fmt.hpp"
+#include "../internal/flusher.hpp"
 #include "../internal/null.hpp"
 #include "../message.hpp"
+#include <chrono>
+#include <cstdio>
 #include <memory>
 #include <mutex>
+#include <type_traits>
 
 namespace pride::log::channels
 {
+// How a console channel hands records to its stream
+enum class console_mode_t : uint8_t
+{
+    unbuffered, // write and flush every record
+    buffered    // collect records and write them out in batches
+};
+
 namespace internal
 {
     // used to seperate FILE* stdout and stdout : public channel_t
@@ -29,72 +39,124 @@ namespace internal
         }
     };
 
-    template<typename Mutex>
-    class stdout_console : public channel_t
+    // Console channel writing to the FILE* of Stream. Unbuffered by default,
+    // every record is flushed as soon as it is written. In buffered mode the
+    // records are collected and written with a single flush when the buffer
+    // is full, when a record at or above flush_on arrives, on flush and every
+    // flush period when one is set.
+    template<typename Stream, typename Mutex>
+    class console : public base_channel<Mutex>
     {
     public:
-        stdout_console()
-            : channel_t()
-            , _file(stdout_stream::stream())
+        static constexpr size_t default_buffer_size = 64 * 1024;
+
+        console()
+            : base_channel<Mutex>()
+            , _file(Stream::stream())
         {
         }
 
-        ~stdout_console() = default;
-        stdout_console(const stdout_console&) = delete;
-        stdout_console& operator=(const stdout_console&) = delete;
-
-        void log(const message_t& msg) override
+        ~console() override
         {
-            fmt::memory_buffer format;
-            _formatter->format(msg, format);
-            std::lock_guard<Mutex> lock(_mutex);
-            fwrite(format.data(), sizeof(char), format.size(), _file);
-            fflush(stdout_stream::stream());
+            _flusher.stop();
+            std::lock_guard<Mutex> lock(this->_mutex);
+            _write_out();
         }
 
-        void flush() override
+        console(const console&) = delete;
+        console& operator=(const console&) = delete;
+
+        console& mode(console_mode_t mode)
         {
-            std::lock_guard<Mutex> lock(_mutex);
-            fflush(stdout_stream::stream());
+            std::lock_guard<Mutex> lock(this->_mutex);
+            if (mode == console_mode_t::unbuffered)
+                _write_out();
+            _mode = mode;
+            return *this;
         }
+        console_mode_t mode() const { return _mode; }
 
-    private:
-        Mutex _mutex;
-        FILE* _file;
-    };
+        // Switches to buffered mode with room for `size` bytes of records
+        console& buffered(size_t size = default_buffer_size)
+        {
+            std::lock_guard<Mutex> lock(this->_mutex);
+            _buffer.reserve(size);
+            _capacity = size;
+            _mode = console_mode_t::buffered;
+            return *this;
+        }
 
-    template<typename Mutex>
-    class stderr_console : public channel_t
-    {
-    public:
-        stderr_console()
-            : _file(stderr_stream::stream())
+        // Records at or above this level are written out right away
+        console& flush_on(sevarity_t level)
         {
+            std::lock_guard<Mutex> lock(this->_mutex);
+            _flush_on = level;
+            return *this;
         }
 
-        ~stderr_console() = default;
-        stderr_console(const stderr_console&) = delete;
-        stderr_console& operator=(const stderr_console&) = delete;
+        // Writes buffered records out at least this often from a background
+        // thread, zero turns it off
+        console& flush_every(std::chrono::milliseconds period)
+        {
+            static_assert(!std::is_same_v<Mutex, log::internal::null_mutex>, "flush_every needs the thread safe channel");
+
+            _flusher.start(period, [this] { this->flush(); });
+            return *this;
+        }
 
-        void log(const message_t& msg) override
+    protected:
+        void _process(const message_t& msg, const fmt::memory_buffer& formatted) override
         {
-            fmt::memory_buffer format;
-            _formatter->format(msg, format);
-            std::lock_guard<Mutex> lock(_mutex);
-            fwrite(format.data(), sizeof(char), format.size(), _file);
-            fflush(stdout_stream::stream());
+            if (_mode == console_mode_t::unbuffered)
+            {
+                std::fwrite(formatted.data(), sizeof(char), formatted.size(), _file);
+                std::fflush(_file);
+                return;
+            }
+
+            if (_buffer.size() + formatted.size() > _capacity)
+                _write_out();
+            if (formatted.size() > _capacity)
+            {
+                std::fwrite(formatted.data(), sizeof(char), formatted.size(), _file);
+                std::fflush(_file);
+            }
+            else
+                fmt::helper::append_buffer(formatted, _buffer);
+
+            if (msg.sevarity >= _flush_on)
+                _write_out();
         }
 
-        void flush() override
+        void _flush() override
         {
-            std::lock_guard<Mutex> lock(_mutex);
-            fflush(stdout_stream::stream());
+            _write_out();
+            std::fflush(_file);
         }
 
     private:
-        Mutex _mutex;
+        void _write_out()
+        {
+            if (_buffer.size() == 0)
+                return;
+            std::fwrite(_buffer.data(), sizeof(char), _buffer.size(), _file);
+            std::fflush(_file);
+            _buffer.resize(0);
+        }
+
         FILE* _file;
+        console_mode_t _mode{ console_mode_t::unbuffered };
+        fmt::memory_buffer _buffer;
+        size_t _capacity{ default_buffer_size };
+        sevarity_t _flush_on{ sevarity_t::off };
+        log::internal::periodic_flusher_t _flusher;
     };
+
+    template<typename Mutex>
+    using stdout_console = console<stdout_stream, Mutex>;
+
+    template<typename Mutex>
+    using stderr_console = console<stderr_stream, Mutex>;
 } // namespace internal
 
 using stdout_mt = internal::stdout_console<std::mutex>;
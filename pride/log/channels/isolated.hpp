@@ -0,0 +1,353 @@
+#pragma once
+
+#include "../../utility/scope_guard.hpp"
+#include "../channel.hpp"
+#include "../internal/backoff.hpp"
+#include "../internal/message_pool.hpp"
+#include "../internal/queue.hpp"
+#include "../overflow_policy.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace pride::log
+{
+// Health of an isolated channel, see channels::isolated::stats
+struct channel_stats_t
+{
+    size_t queue_depth{ 0 }; // records waiting for the channel
+    size_t queue_size{ 0 };
+    uint64_t written{ 0 };
+    uint64_t dropped{ 0 };     // turned away by drop_newest
+    uint64_t overwritten{ 0 }; // pushed out by overwrite_oldest
+    uint64_t failed{ 0 };      // the channel threw while logging or flushing
+    std::chrono::nanoseconds last_latency{ 0 }; // time the last record took to write
+    std::chrono::nanoseconds max_latency{ 0 };
+};
+
+namespace channels
+{
+    // Runs a channel on a thread of its own behind a bounded queue, so a
+    // channel that stalls (a hung syslog daemon, a file on a slow network
+    // share) only holds up itself. The logging thread copies the record into
+    // a pooled message and pushes it, the overflow policy decides what
+    // happens when the channel falls queue_size records behind.
+    //
+    // Formatters set on the isolated channel are handed to the channel it
+    // runs. flush() waits for the records queued before it to be written, at
+    // most flush_timeout when one is set.
+    class isolated : public channel_t
+    {
+    public:
+        static constexpr size_t default_queue_size = 8192;
+
+        explicit isolated(channel_t::ptr channel, size_t queue_size = default_queue_size, overflow_policy_t policy = overflow_policy_t::drop_newest)
+            : channel_t()
+            , _channel(std::move(channel))
+            , _queue(queue_size)
+            , _policy(policy)
+        {
+            _thread = std::thread([this] { _run(); });
+        }
+
+        ~isolated() override
+        {
+            _push(item_t{ command_t::terminate, nullptr }, std::chrono::steady_clock::time_point::max());
+            _thread.join();
+        }
+
+        isolated(const isolated&) = delete;
+        isolated& operator=(const isolated&) = delete;
+
+        void log(const message_t& msg) override
+        {
+            // the copy holds an interned name until it is queued or dropped
+            _interning.fetch_add(1, std::memory_order_seq_cst);
+            defer { _interning.fetch_sub(1, std::memory_order_release); };
+
+            auto copy = log::internal::message_pool_t::acquire(_intern(msg.names), msg.sevarity);
+            copy->time = msg.time;
+            copy->thread_id = msg.thread_id;
+            copy->source = msg.source;
+            copy->backtrace = msg.backtrace;
+            copy->raw.append(msg.raw.data(), msg.raw.data() + msg.raw.size());
+            for (size_t i = 0; i < msg.fields.size(); ++i)
+                copy->fields.add(msg.fields[i]);
+            _enqueue_record(item_t{ command_t::log, std::move(copy) });
+        }
+
+        void flush() override
+        {
+            auto timeout = std::chrono::milliseconds(_flush_timeout.load(std::memory_order_relaxed));
+            auto deadline = timeout.count() > 0 ? std::chrono::steady_clock::now() + timeout : std::chrono::steady_clock::time_point::max();
+
+            uint64_t ticket;
+            {
+                std::lock_guard<std::mutex> lock(_flush_mutex);
+                if (!_push(item_t{ command_t::flush, nullptr }, deadline))
+                    return;
+                ticket = ++_flush_requested;
+            }
+
+            std::unique_lock<std::mutex> lock(_flushed_mutex);
+            auto done = [&] { return _flushed >= ticket; };
+            if (deadline == std::chrono::steady_clock::time_point::max())
+                _flushed_cv.wait(lock, done);
+            else
+                _flushed_cv.wait_until(lock, deadline, done);
+        }
+
+        channel_t& formatter(std::unique_ptr<formatter_t> format) override
+        {
+            _channel->formatter(std::move(format));
+            return *this;
+        }
+
+        // Longest flush() waits for the channel, zero waits for as long as it takes
+        isolated& flush_timeout(std::chrono::milliseconds timeout)
+        {
+            _flush_timeout.store(timeout.count(), std::memory_order_relaxed);
+            return *this;
+        }
+
+        isolated& overflow_policy(overflow_policy_t policy)
+        {
+            _policy.store(policy, std::memory_order_relaxed);
+            return *this;
+        }
+        overflow_policy_t overflow_policy() const { return _policy.load(std::memory_order_relaxed); }
+
+        const channel_t::ptr& channel() const { return _channel; }
+
+        channel_stats_t stats() const
+        {
+            channel_stats_t result;
+            result.queue_depth = _queue.size();
+            result.queue_size = _queue.capacity();
+            result.written = _written.load(std::memory_order_relaxed);
+            result.dropped = _dropped.load(std::memory_order_relaxed);
+            result.overwritten = _overwritten.load(std::memory_order_relaxed);
+            result.failed = _failed.load(std::memory_order_relaxed);
+            result.last_latency = std::chrono::nanoseconds(_last_latency.load(std::memory_order_relaxed));
+            result.max_latency = std::chrono::nanoseconds(_max_latency.load(std::memory_order_relaxed));
+            return result;
+        }
+
+    private:
+        enum class command_t : uint8_t
+        {
+            log,
+            flush,
+            terminate
+        };
+
+        struct item_t
+        {
+            command_t command{ command_t::log };
+            message_ptr msg;
+        };
+
+        // A logger can go away while its records still wait in the queue, the
+        // queued copies point to names owned by the channel. Each name is
+        // copied once and found again through a small lock free cache. Once
+        // there are more than max_names of them the worker drops them all
+        // the next time the queue is empty and no record is being copied.
+        struct name_t
+        {
+            const std::string* source;
+            std::string copy;
+        };
+
+        const std::string* _intern(const std::string* names)
+        {
+            if (names == nullptr)
+                return nullptr;
+
+            auto& slot = _name_cache[(reinterpret_cast<uintptr_t>(names) >> 4) % name_cache_size];
+            auto cached = slot.load(std::memory_order_seq_cst);
+            if (cached != nullptr && cached->source == names && cached->copy == *names)
+                return &cached->copy;
+
+            std::lock_guard<std::mutex> lock(_names_mutex);
+            auto found = std::find_if(_names.begin(), _names.end(), [names](const name_t& name) { return name.source == names && name.copy == *names; });
+            const name_t* name = found != _names.end() ? &*found : &_names.emplace_back(name_t{ names, *names });
+            _name_count.store(_names.size(), std::memory_order_relaxed);
+            slot.store(name, std::memory_order_release);
+            return &name->copy;
+        }
+
+        // Called by the worker with the queue empty. A producer announces
+        // itself before it reads the cache, and the cache is emptied before
+        // producers are counted, so a producer either holds the worker off or
+        // misses the cache and waits for the lock.
+        void _reclaim_names()
+        {
+            std::lock_guard<std::mutex> lock(_names_mutex);
+            for (auto& slot : _name_cache)
+                slot.store(nullptr, std::memory_order_seq_cst);
+            if (_interning.load(std::memory_order_seq_cst) != 0 || !_queue.empty())
+                return;
+
+            _names.clear();
+            _name_count.store(0, std::memory_order_relaxed);
+        }
+
+        // Commands wait for room until the deadline, records follow the policy
+        bool _push(item_t&& item, std::chrono::steady_clock::time_point deadline)
+        {
+            log::internal::backoff_t backoff;
+            while (!_queue.try_push(std::move(item)))
+            {
+                if (backoff.is_sleeping() && std::chrono::steady_clock::now() >= deadline)
+                    return false;
+                backoff.pause();
+            }
+            _parker.notify();
+            return true;
+        }
+
+        void _enqueue_record(item_t&& item)
+        {
+            if (_queue.try_push(std::move(item)))
+            {
+                _parker.notify();
+                return;
+            }
+
+            switch (overflow_policy())
+            {
+            case overflow_policy_t::block:
+                _push(std::move(item), std::chrono::steady_clock::time_point::max());
+                break;
+
+            case overflow_policy_t::drop_newest:
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                break;
+
+            case overflow_policy_t::overwrite_oldest:
+            {
+                item_t oldest;
+                while (!_queue.try_push(std::move(item)))
+                {
+                    if (!_queue.try_pop(oldest))
+                        continue;
+
+                    if (oldest.command == command_t::log)
+                        _overwritten.fetch_add(1, std::memory_order_relaxed);
+                    else
+                        _push(std::move(oldest), std::chrono::steady_clock::time_point::max()); // never lose a flush or terminate
+                }
+                _parker.notify();
+                break;
+            }
+            }
+        }
+
+        void _run()
+        {
+            item_t item;
+            log::internal::backoff_t backoff;
+            for (;;)
+            {
+                if (!_queue.try_pop(item))
+                {
+                    if (_name_count.load(std::memory_order_relaxed) > max_names)
+                        _reclaim_names();
+                    backoff.pause(_parker, [this] { return !_queue.empty(); });
+                    continue;
+                }
+                backoff.reset();
+
+                switch (item.command)
+                {
+                case command_t::log:
+                    _write(*item.msg);
+                    item.msg.reset();
+                    break;
+                case command_t::flush:
+                    try
+                    {
+                        _channel->flush();
+                    }
+                    catch (...)
+                    {
+                        _failed.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    {
+                        std::lock_guard<std::mutex> lock(_flushed_mutex);
+                        ++_flushed;
+                    }
+                    _flushed_cv.notify_all();
+                    break;
+                case command_t::terminate:
+                    try
+                    {
+                        _channel->flush();
+                    }
+                    catch (...)
+                    {
+                    }
+                    return;
+                }
+            }
+        }
+
+        void _write(const message_t& msg)
+        {
+            auto start = std::chrono::steady_clock::now();
+            try
+            {
+                _channel->log(msg);
+                _written.fetch_add(1, std::memory_order_relaxed);
+            }
+            catch (...)
+            {
+                _failed.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            _last_latency.store(latency, std::memory_order_relaxed);
+            if (latency > _max_latency.load(std::memory_order_relaxed))
+                _max_latency.store(latency, std::memory_order_relaxed);
+        }
+
+        static constexpr size_t name_cache_size = 8;
+        static constexpr size_t max_names = 256;
+
+        const channel_t::ptr _channel;
+        log::internal::mpmc_queue_t<item_t> _queue;
+        log::internal::parker_t _parker; // the idle worker
+        std::atomic<overflow_policy_t> _policy;
+        std::atomic<int64_t> _flush_timeout{ 0 };
+
+        std::atomic<const name_t*> _name_cache[name_cache_size] = {};
+        std::mutex _names_mutex;
+        std::deque<name_t> _names;
+        std::atomic<size_t> _name_count{ 0 };
+        std::atomic<size_t> _interning{ 0 };
+
+        // flush tickets, a flush is done once the worker counted its command
+        std::mutex _flush_mutex;
+        uint64_t _flush_requested{ 0 };
+        std::mutex _flushed_mutex;
+        std::condition_variable _flushed_cv;
+        uint64_t _flushed{ 0 };
+
+        std::atomic<uint64_t> _written{ 0 };
+        std::atomic<uint64_t> _dropped{ 0 };
+        std::atomic<uint64_t> _overwritten{ 0 };
+        std::atomic<uint64_t> _failed{ 0 };
+        std::atomic<int64_t> _last_latency{ 0 };
+        std::atomic<int64_t> _max_latency{ 0 };
+
+        std::thread _thread;
+    };
+} // namespace channels
+} // namespace pride::log
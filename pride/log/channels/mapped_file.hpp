@@ -0,0 +1,270 @@
+#pragma once
+
+#include "../../os/file.hpp"
+#include "../channel.hpp"
+#include "../internal/null.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pride::log::channels
+{
+namespace internal
+{
+    // Last resort crash log. Records are copied into a memory mapped file,
+    // so a record costs a memcpy and an offset bump and no system call.
+    // The file grows in chunks: while the channel fills one, a background
+    // thread has already mapped the next one, and it unmaps the chunks left
+    // behind. Copied records sit in the page cache and survive the process
+    // dying. flush() msyncs them to the disk. Until the channel closes the
+    // file ends in zeros up to the chunk boundary. A channel opened on such a
+    // file carries on after the last record.
+    template<typename Mutex>
+    class mapped_file : public base_channel<Mutex>
+    {
+    public:
+        static constexpr size_t default_chunk_size = 64 * 1024 * 1024;
+
+        // `chunk_size` is rounded up to the mapping granularity
+        explicit mapped_file(const std::string& filename, bool truncate = false, size_t chunk_size = default_chunk_size)
+            : base_channel<Mutex>()
+        {
+            auto granularity = os::mapped_region_t::mapped_file_granularity();
+            _chunk_size = std::max<size_t>(1, (chunk_size + granularity - 1) / granularity) * granularity;
+
+            // without a file every record finds the chunk full and is dropped
+            _used = _chunk_size;
+            if (!_file.open(filename, truncate))
+                return;
+
+            auto end = _find_end();
+            _written.store(end, std::memory_order_relaxed);
+            _current = _map_chunk(end / _chunk_size);
+            _current.touch();
+            _used = _current.is_mapped() ? static_cast<size_t>(end % _chunk_size) : _chunk_size;
+            _next_chunk = end / _chunk_size + 1;
+            _preparer = std::thread([this] { _prepare(); });
+        }
+
+        ~mapped_file() override
+        {
+            if (!_file.is_open())
+                return;
+
+            {
+                std::lock_guard<std::mutex> lock(_prepare_mutex);
+                _stopping = true;
+            }
+            _wake.notify_one();
+            _preparer.join();
+
+            _current.unmap();
+            _next.unmap();
+            _retired.clear();
+            _file.resize(_written.load(std::memory_order_relaxed));
+        }
+
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        // Bytes of records in the file
+        uint64_t size() const { return _written.load(std::memory_order_acquire); }
+
+        // Records lost because the file could not grow
+        uint64_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+        // Times a record had to wait for the next chunk to be mapped
+        uint64_t stalls() const { return _stalls.load(std::memory_order_relaxed); }
+
+    protected:
+        void _process(const message_t&, const fmt::memory_buffer& formatted) override
+        {
+            auto data = formatted.data();
+            auto size = formatted.size();
+            auto start = _used;
+            bool advanced = false;
+            while (size > 0)
+            {
+                if (_used == _chunk_size)
+                {
+                    if (!_advance())
+                    {
+                        _drop(start, advanced, formatted.size() - size);
+                        return;
+                    }
+                    advanced = true;
+                }
+
+                auto part = std::min(size, _chunk_size - _used);
+                std::memcpy(_current.data() + _used, data, part);
+                _used += part;
+                data += part;
+                size -= part;
+            }
+            _written.fetch_add(formatted.size(), std::memory_order_release);
+        }
+
+        void _flush() override
+        {
+            // the chunks left behind are no longer mapped, only the file
+            // sync reaches them
+            if (_left_chunk)
+            {
+                _file.sync(true);
+                _left_chunk = false;
+            }
+            else
+                _current.sync(0, _used);
+        }
+
+    private:
+        // a record that did not fit is taken back out of the chunk so the
+        // next one starts where it did, unless part of it is in a chunk left
+        // behind. Then that part stays in the file and is counted as written.
+        void _drop(size_t start, bool advanced, size_t copied)
+        {
+            if (!advanced)
+            {
+                if (_used > start)
+                    std::memset(_current.data() + start, 0, _used - start);
+                _used = start;
+            }
+            else
+                _written.fetch_add(copied, std::memory_order_release);
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // moves on to the chunk the preparer mapped, false when it could not
+        bool _advance()
+        {
+            if (!_preparer.joinable())
+                return false;
+
+            std::unique_lock<std::mutex> lock(_prepare_mutex);
+            if (!_next.is_mapped())
+            {
+                if (_failed)
+                {
+                    // try again for the next record
+                    _failed = false;
+                    lock.unlock();
+                    _wake.notify_one();
+                    return false;
+                }
+
+                _stalls.fetch_add(1, std::memory_order_relaxed);
+                _ready.wait(lock, [this] { return _next.is_mapped() || _failed; });
+                if (!_next.is_mapped())
+                    return false;
+            }
+
+            if (_current.is_mapped())
+                _retired.push_back(std::move(_current));
+            _current = std::move(_next);
+            _used = 0;
+            ++_next_chunk;
+            _left_chunk = true;
+            lock.unlock();
+            _wake.notify_one();
+            return true;
+        }
+
+        // background thread keeping the next chunk mapped
+        void _prepare()
+        {
+            std::unique_lock<std::mutex> lock(_prepare_mutex);
+            for (;;)
+            {
+                _wake.wait(lock, [this] { return _stopping || !_retired.empty() || (!_next.is_mapped() && !_failed); });
+                if (_stopping)
+                    return;
+
+                auto retired = std::move(_retired);
+                _retired.clear();
+                bool map = !_next.is_mapped() && !_failed;
+                auto chunk = _next_chunk;
+                lock.unlock();
+
+                retired.clear();
+                os::mapped_region_t next;
+                if (map)
+                {
+                    next = _map_chunk(chunk);
+                    if (next.is_mapped())
+                        next.touch();
+                }
+
+                lock.lock();
+                if (map)
+                {
+                    if (next.is_mapped())
+                        _next = std::move(next);
+                    else
+                        _failed = true;
+                    _ready.notify_all();
+                }
+            }
+        }
+
+        os::mapped_region_t _map_chunk(uint64_t chunk)
+        {
+            auto end = (chunk + 1) * _chunk_size;
+            if (_file.size() < end && !_file.resize(end))
+                return {};
+            return _file.map(chunk * _chunk_size, _chunk_size);
+        }
+
+        // end of the records in the file, before the zeros a channel that
+        // did not close left behind
+        uint64_t _find_end()
+        {
+            auto end = _file.size();
+            while (end > 0)
+            {
+                auto start = (end - 1) / _chunk_size * _chunk_size;
+                auto region = _file.map(start, static_cast<size_t>(end - start));
+                if (!region.is_mapped())
+                    return end;
+
+                auto data = region.data();
+                for (auto i = region.size(); i > 0; --i)
+                    if (data[i - 1] != 0)
+                        return start + i;
+                end = start;
+            }
+            return 0;
+        }
+
+        os::mapped_file_t _file;
+        size_t _chunk_size;
+
+        // used by the logging thread under the channel lock
+        os::mapped_region_t _current;
+        size_t _used{ 0 };
+        bool _left_chunk{ false };
+        std::atomic<uint64_t> _written{ 0 };
+        std::atomic<uint64_t> _dropped{ 0 };
+        std::atomic<uint64_t> _stalls{ 0 };
+
+        // shared with the preparer under _prepare_mutex
+        std::mutex _prepare_mutex;
+        std::condition_variable _wake;
+        std::condition_variable _ready;
+        os::mapped_region_t _next;
+        uint64_t _next_chunk{ 0 };
+        std::vector<os::mapped_region_t> _retired;
+        bool _failed{ false };
+        bool _stopping{ false };
+        std::thread _preparer;
+    };
+} // namespace internal
+
+using mapped_file_mt = internal::mapped_file<std::mutex>;
+using mapped_file_st = internal::mapped_file<log::internal::null_mutex>;
+} // namespace pride::log::channels
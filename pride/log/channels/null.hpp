@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../channel.hpp"
+#include "../internal/null.hpp"
+#include <mutex>
+
+namespace pride::log::channels
+{
+namespace internal
+{
+    // Formats every record and throws the result away. Useful to measure the
+    // cost of the logger and formatter without any io.
+    template<typename Mutex>
+    class null_channel : public base_channel<Mutex>
+    {
+    public:
+        null_channel()
+            : base_channel<Mutex>()
+        {}
+
+    protected:
+        void _process(const message_t&, const fmt::memory_buffer&) override {}
+        void _flush() override {}
+    };
+} // namespace internal
+
+using null_mt = internal::null_channel<std::mutex>;
+using null_st = internal::null_channel<log::internal::null_mutex>;
+} // namespace pride::log::channels
@@ -0,0 +1,240 @@
+#pragma once
+
+#include "../../os/file.hpp"
+#include "../channel.hpp"
+#include "../internal/null.hpp"
+#include "../internal/time.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace pride::log::channels
+{
+// Wall clock boundary a rotating file rolls over on, in local time
+enum class rotation_interval_t : uint8_t
+{
+    none,
+    hourly,
+    daily
+};
+
+namespace internal
+{
+    // app.log -> app.3.log, a name without an extension gets the index appended
+    inline std::string history_name(const std::string& filename, size_t index)
+    {
+        if (index == 0)
+            return filename;
+
+        auto dot = filename.find_last_of('.');
+        auto slash = filename.find_last_of("/\\");
+        if (dot == std::string::npos || dot == 0 || (slash != std::string::npos && dot < slash + 2))
+            return filename + "." + std::to_string(index);
+        return filename.substr(0, dot) + "." + std::to_string(index) + filename.substr(dot);
+    }
+
+    inline std::chrono::system_clock::time_point next_rotation(std::chrono::system_clock::time_point time, rotation_interval_t interval)
+    {
+        if (interval == rotation_interval_t::none)
+            return std::chrono::system_clock::time_point::max();
+
+        auto tm = log::internal::local_time(std::chrono::system_clock::to_time_t(time));
+        tm.tm_min = 0;
+        tm.tm_sec = 0;
+        tm.tm_isdst = -1;
+        if (interval == rotation_interval_t::hourly)
+            ++tm.tm_hour;
+        else
+        {
+            tm.tm_hour = 0;
+            ++tm.tm_mday;
+        }
+        return std::chrono::system_clock::from_time_t(std::mktime(&tm));
+    }
+
+    // File channel that rolls over when the file would grow past max_size, on
+    // an hourly or daily boundary, or both, and keeps max_files old files
+    // (app.1.log is the newest).
+    //
+    // A background thread keeps the next file open and preallocated. Rolling
+    // over on the logging thread only swaps descriptors, renaming the old
+    // files and preparing the one after happen on the background thread.
+    template<typename Mutex>
+    class rotating_file : public base_channel<Mutex>
+    {
+    public:
+        rotating_file(const std::string& filename, size_t max_size, size_t max_files,
+            rotation_interval_t interval = rotation_interval_t::none)
+            : base_channel<Mutex>()
+            , _filename(filename)
+            , _max_size(max_size)
+            , _max_files(max_files)
+            , _interval(interval)
+            , _preallocate(max_size)
+            , _file(new os::raw_file_t())
+        {
+            _file->open(_filename);
+            _size = _file->size();
+            _next_rotation = next_rotation(log::internal::now(), _interval);
+            _thread = std::thread([this] { _run(); });
+        }
+
+        ~rotating_file() override
+        {
+            {
+                std::lock_guard<std::mutex> lock(_rotator_mutex);
+                _running = false;
+            }
+            _rotator_cv.notify_all();
+            _thread.join();
+
+            _file->truncate(_size);
+            if (_prepared)
+            {
+                _prepared->close();
+                std::remove(_prepared_name().c_str());
+            }
+        }
+
+        rotating_file(const rotating_file&) = delete;
+        rotating_file& operator=(const rotating_file&) = delete;
+
+        // Bytes reserved up front for each new file, defaults to max_size
+        rotating_file& preallocate(size_t bytes)
+        {
+            std::lock_guard<std::mutex> lock(_rotator_mutex);
+            _preallocate = bytes;
+            return *this;
+        }
+
+        const std::string& filename() const { return _filename; }
+
+    protected:
+        void _process(const message_t& msg, const fmt::memory_buffer& formatted) override
+        {
+            bool full = _max_size > 0 && _size > 0 && _size + formatted.size() > _max_size;
+            if (full || msg.time >= _next_rotation)
+                _rotate(msg.time);
+
+            _file->write(formatted.data(), formatted.size());
+            _size += formatted.size();
+        }
+
+        void _flush() override {}
+
+    private:
+        std::string _prepared_name() const { return _filename + ".next"; }
+
+        // swaps in the prepared file and hands the current one to the
+        // background thread
+        void _rotate(std::chrono::system_clock::time_point time)
+        {
+            std::unique_lock<std::mutex> lock(_rotator_mutex);
+
+            // only waits when files fill up faster than the background thread
+            // renames them
+            _rotator_cv.wait(lock, [this] { return _prepared != nullptr || !_running; });
+            if (!_prepared)
+                return;
+
+            _retired = std::move(_file);
+            _retired_size = _size;
+            _file = std::move(_prepared);
+            _size = 0;
+            _next_rotation = next_rotation(time, _interval);
+
+            lock.unlock();
+            _rotator_cv.notify_all();
+        }
+
+        void _run()
+        {
+            std::unique_lock<std::mutex> lock(_rotator_mutex);
+            for (;;)
+            {
+                if (_retired)
+                {
+                    auto retired = std::move(_retired);
+                    auto size = _retired_size;
+                    lock.unlock();
+                    _shift(*retired, size);
+                    lock.lock();
+                    continue;
+                }
+
+                if (!_prepared && _running)
+                {
+                    auto bytes = _preallocate;
+                    lock.unlock();
+                    auto prepared = _prepare(bytes);
+                    lock.lock();
+                    _prepared = std::move(prepared);
+                    _rotator_cv.notify_all();
+                    continue;
+                }
+
+                if (!_running)
+                    return;
+                _rotator_cv.wait(lock);
+            }
+        }
+
+        std::unique_ptr<os::raw_file_t> _prepare(size_t bytes)
+        {
+            auto file = std::make_unique<os::raw_file_t>();
+            file->open(_prepared_name(), true);
+            if (bytes > 0)
+                file->preallocate(bytes);
+            return file;
+        }
+
+        // gives the retired file its history name and moves the prepared one
+        // into the place of the current file
+        void _shift(os::raw_file_t& retired, size_t size)
+        {
+            retired.truncate(size);
+            retired.close();
+
+            if (_max_files == 0)
+                std::remove(_filename.c_str());
+            else
+            {
+                std::remove(history_name(_filename, _max_files).c_str());
+                for (auto i = _max_files; i > 1; --i)
+                    std::rename(history_name(_filename, i - 1).c_str(), history_name(_filename, i).c_str());
+                std::rename(_filename.c_str(), history_name(_filename, 1).c_str());
+            }
+            std::rename(_prepared_name().c_str(), _filename.c_str());
+        }
+
+        const std::string _filename;
+        const size_t _max_size;
+        const size_t _max_files;
+        const rotation_interval_t _interval;
+        size_t _preallocate;
+
+        // logging thread, under the channel mutex
+        std::unique_ptr<os::raw_file_t> _file;
+        size_t _size{ 0 };
+        std::chrono::system_clock::time_point _next_rotation;
+
+        // shared with the background thread, under _rotator_mutex
+        std::unique_ptr<os::raw_file_t> _prepared;
+        std::unique_ptr<os::raw_file_t> _retired;
+        size_t _retired_size{ 0 };
+        bool _running{ true };
+
+        std::mutex _rotator_mutex;
+        std::condition_variable _rotator_cv;
+        std::thread _thread;
+    };
+} // namespace internal
+
+using rotating_file_mt = internal::rotating_file<std::mutex>;
+using rotating_file_st = internal::rotating_file<log::internal::null_mutex>;
+} // namespace pride::log::channels
@@ -0,0 +1,229 @@
+#pragma once
+
+#include "../../os/shared_memory.hpp"
+#include "../channel.hpp"
+#include "../internal/backoff.hpp"
+#include "../internal/null.hpp"
+#include "../internal/shm_format.hpp"
+#include "../overflow_policy.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#if defined(PRIDE_OS_WINDOWS)
+#    include <process.h>
+#else
+#    include <unistd.h>
+#endif
+
+namespace pride::log::channels
+{
+namespace internal
+{
+    // Channel that moves log I/O out of the process. Records go into a ring in
+    // shared memory and a collector process (tools/log-collect, or anything
+    // using shm_reader_t) takes them out and writes them to its own channels.
+    // Logging is a copy into the ring, the channel never waits for the disk
+    // and, with drop_newest, not for the collector either. A record is in the
+    // ring as soon as log() returns, a crash of the process afterwards does not
+    // lose it.
+    //
+    // Like binary_file it keeps each record's time, level, thread, logger,
+    // source and message, the formatter of the channel is not used. A channel
+    // opened on an existing ring carries on after the records still in it.
+    template<typename Mutex>
+    class shm_ring : public channel_t
+    {
+    public:
+        static constexpr size_t default_capacity = 4 * 1024 * 1024;
+
+        // `capacity` bytes of records, rounded up to a power of two. An
+        // existing ring keeps its capacity. Only drop_newest and block mean
+        // something here, the writer cannot take records back from the
+        // collector so overwrite_oldest drops the newest as well. Records
+        // longer than half the capacity are always dropped.
+        explicit shm_ring(const std::string& name, size_t capacity = default_capacity, overflow_policy_t policy = overflow_policy_t::drop_newest)
+            : channel_t()
+            , _name(name)
+            , _policy(policy)
+        {
+            size_t rounded = 64;
+            while (rounded < capacity)
+                rounded <<= 1;
+
+            bool created = false;
+            if (!_memory.create(_name, log::internal::shm::memory_size(rounded), &created))
+                return;
+
+            _header = reinterpret_cast<log::internal::shm::header_t*>(_memory.data());
+            if (created || !log::internal::shm::valid(*_header, _memory.size()))
+                _initialize(std::min(rounded, _memory.size() - log::internal::shm::header_size));
+            else
+                std::atomic_thread_fence(std::memory_order_acquire);
+
+#if defined(PRIDE_OS_WINDOWS)
+            _header->writer = static_cast<uint64_t>(::_getpid());
+#else
+            _header->writer = static_cast<uint64_t>(::getpid());
+#endif
+            _records = _memory.data() + log::internal::shm::header_size;
+            _mask = _header->capacity - 1;
+            _write = _header->write.load(std::memory_order_relaxed);
+            _sequence = _header->sequence.load(std::memory_order_relaxed);
+        }
+
+        shm_ring(const shm_ring&) = delete;
+        shm_ring& operator=(const shm_ring&) = delete;
+
+        void log(const message_t& msg) override
+        {
+            std::lock_guard<Mutex> lock(_mutex);
+            if (_header == nullptr)
+            {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            auto name = msg.names != nullptr ? std::string_view(*msg.names) : std::string_view();
+            auto file = msg.source != nullptr && msg.source->file != nullptr ? std::string_view(msg.source->file) : std::string_view();
+            auto function = msg.source != nullptr && msg.source->function != nullptr ? std::string_view(msg.source->function) : std::string_view();
+            name = name.substr(0, UINT16_MAX);
+            file = file.substr(0, UINT16_MAX);
+            function = function.substr(0, UINT16_MAX);
+
+            auto size = log::internal::shm::align(sizeof(log::internal::shm::record_t) + name.size() + file.size() + function.size() + msg.raw.size());
+            auto sequence = _sequence++;
+            if (!_reserve(size))
+            {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                _header->dropped.fetch_add(1, std::memory_order_relaxed);
+                _header->sequence.store(_sequence, std::memory_order_release);
+                return;
+            }
+
+            log::internal::shm::record_t record;
+            std::memset(&record, 0, sizeof(record));
+            record.size = static_cast<uint32_t>(size);
+            record.name_length = static_cast<uint16_t>(name.size());
+            record.kind = log::internal::shm::record_kind_t::record;
+            record.level = static_cast<uint8_t>(msg.sevarity);
+            record.sequence = sequence;
+            record.time = std::chrono::duration_cast<std::chrono::nanoseconds>(msg.time.time_since_epoch()).count();
+            record.thread = msg.thread_id;
+            record.length = static_cast<uint32_t>(msg.raw.size());
+            record.line = msg.source != nullptr ? static_cast<uint32_t>(msg.source->line) : 0;
+            record.file_length = static_cast<uint16_t>(file.size());
+            record.function_length = static_cast<uint16_t>(function.size());
+
+            auto at = _records + (_write & _mask);
+            std::memcpy(at, &record, sizeof(record));
+            at += sizeof(record);
+            for (auto part : { name, file, function, std::string_view(msg.raw.data(), msg.raw.size()) })
+            {
+                std::memcpy(at, part.data(), part.size());
+                at += part.size();
+            }
+
+            _write += size;
+            _header->sequence.store(_sequence, std::memory_order_relaxed);
+            _header->write.store(_write, std::memory_order_release);
+            log::internal::shm::wake(*_header);
+        }
+
+        // Records reach the ring in log(), there is nothing to flush
+        void flush() override {}
+
+        const std::string& name() const { return _name; }
+
+        // False when the shared memory could not be set up, records are
+        // dropped then
+        bool is_open() const { return _header != nullptr; }
+
+        // Records this channel had no room for
+        uint64_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+        // Removes the ring from the system once nothing needs it anymore
+        static bool remove(const std::string& name) { return os::shared_memory_t::remove(name); }
+
+    private:
+        void _initialize(size_t capacity)
+        {
+            size_t rounded = 64;
+            while (rounded * 2 <= capacity)
+                rounded <<= 1;
+
+            auto header = _header;
+            std::memset(header->magic, 0, sizeof(header->magic));
+            header->version = log::internal::shm::version;
+            header->header_size = static_cast<uint32_t>(log::internal::shm::header_size);
+            header->capacity = rounded;
+            header->write.store(0, std::memory_order_relaxed);
+            header->sequence.store(0, std::memory_order_relaxed);
+            header->dropped.store(0, std::memory_order_relaxed);
+            header->read.store(0, std::memory_order_relaxed);
+            header->parked.store(0, std::memory_order_relaxed);
+
+            // a collector only trusts the header once the magic is there
+            std::atomic_thread_fence(std::memory_order_release);
+            std::memcpy(header->magic, log::internal::shm::magic, sizeof(header->magic));
+        }
+
+        // makes room for `size` bytes at _write, wrapping to the start of the
+        // ring when they do not fit before its end
+        bool _reserve(size_t size)
+        {
+            auto capacity = _header->capacity;
+            // a record that does not fit before the end of the ring starts at
+            // its beginning once the collector passed the end. That is only
+            // sure to happen when the record fits in the part before the
+            // writer, which is more than half the ring.
+            if (size > capacity / 2)
+                return false;
+
+            log::internal::backoff_t backoff;
+            for (;;)
+            {
+                auto read = _header->read.load(std::memory_order_acquire);
+                auto left = capacity - (_write & _mask);
+                auto needed = size <= left ? size : left + size;
+                if (_write + needed - read <= capacity)
+                {
+                    if (size > left)
+                    {
+                        log::internal::shm::record_t wrap;
+                        std::memset(&wrap, 0, sizeof(wrap));
+                        wrap.size = static_cast<uint32_t>(left);
+                        wrap.kind = log::internal::shm::record_kind_t::wrap;
+                        std::memcpy(_records + (_write & _mask), &wrap, log::internal::shm::wrap_size);
+                        _write += left;
+                    }
+                    return true;
+                }
+
+                if (_policy != overflow_policy_t::block)
+                    return false;
+                backoff.pause();
+            }
+        }
+
+        std::string _name;
+        overflow_policy_t _policy;
+        os::shared_memory_t _memory;
+        log::internal::shm::header_t* _header{ nullptr };
+        char* _records{ nullptr };
+        uint64_t _mask{ 0 };
+        uint64_t _write{ 0 };
+        uint64_t _sequence{ 0 };
+        std::atomic<uint64_t> _dropped{ 0 };
+        mutable Mutex _mutex;
+    };
+} // namespace internal
+
+using shm_ring_mt = internal::shm_ring<std::mutex>;
+using shm_ring_st = internal::shm_ring<log::internal::null_mutex>;
+} // namespace pride::log::channels
@@ -0,0 +1,443 @@
+#pragma once
+
+#include "../../config/detection/os.hpp"
+#include "../../os/socket.hpp"
+#include "../channel.hpp"
+#include "../fmt.hpp"
+#include "../internal/flusher.hpp"
+#include "../internal/null.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#if !defined(PRIDE_OS_WINDOWS)
+#    include <unistd.h>
+#endif
+
+namespace pride::log::channels
+{
+// How records are put on the wire
+enum class socket_framing_t : uint8_t
+{
+    rfc5424, // syslog messages, octet counted (RFC 6587) on streams
+    newline  // the formatted text, one line per record
+};
+
+#if !defined(PRIDE_OS_WINDOWS)
+namespace internal
+{
+    // Sends records to a local collector (a syslog daemon, a log shipper)
+    // over a unix domain datagram or stream socket, or over UDP or TCP.
+    //
+    // Records are framed into a buffer and go out in batches, a datagram each
+    // with one sendmmsg or all of them with one gather write on streams. A
+    // batch leaves when it reaches the batch size, when a record at or above
+    // the flush_on level arrives, on flush and every flush interval. The
+    // socket never blocks: what the peer cannot take yet stays buffered. When
+    // the peer is gone the channel connects again, waiting longer after every
+    // failure, and keeps records until they pass the byte budget. Records
+    // past the budget are dropped.
+    //
+    // With RFC 5424 framing the formatted text (the pattern defaults to "%v")
+    // is the MSG part, the header carries the time, host, app, process and
+    // the logger name as MSGID.
+    template<typename Mutex>
+    class socket : public base_channel<Mutex>
+    {
+    public:
+        static constexpr size_t default_batch_size = 64 * 1024;
+        static constexpr size_t default_budget = 4 * 1024 * 1024;
+        static constexpr size_t max_batch_records = 256;
+
+        explicit socket(os::socket_endpoint_t endpoint, socket_framing_t framing = socket_framing_t::rfc5424)
+            : base_channel<Mutex>()
+            , _endpoint(std::move(endpoint))
+            , _framing(framing)
+        {
+            if (_framing == socket_framing_t::rfc5424)
+                this->pattern("%v");
+
+            char host[256] = {};
+            ::gethostname(host, sizeof(host) - 1);
+            _host = _header_field(host, 255);
+            _process_id = std::to_string(::getpid());
+
+            _connect();
+        }
+
+        ~socket() override
+        {
+            _flusher.stop();
+            std::lock_guard<Mutex> lock(this->_mutex);
+            _send();
+        }
+
+        socket(const socket&) = delete;
+        socket& operator=(const socket&) = delete;
+
+        // Records at or above this level are sent right away
+        socket& flush_on(sevarity_t level)
+        {
+            std::lock_guard<Mutex> lock(this->_mutex);
+            _flush_on = level;
+            return *this;
+        }
+
+        // Sends what is buffered at least this often from a background thread,
+        // zero turns it off
+        socket& flush_every(std::chrono::milliseconds interval)
+        {
+            static_assert(!std::is_same_v<Mutex, log::internal::null_mutex>, "flush_every needs the thread safe channel");
+
+            _flusher.start(interval, [this] { this->flush(); });
+            return *this;
+        }
+
+        // Bytes of framed records that make a batch go out
+        socket& batch_size(size_t bytes)
+        {
+            std::lock_guard<Mutex> lock(this->_mutex);
+            _batch_size = bytes;
+            return *this;
+        }
+
+        // Bytes of records kept while the peer does not take them
+        socket& budget(size_t bytes)
+        {
+            std::lock_guard<Mutex> lock(this->_mutex);
+            _budget = bytes;
+            return *this;
+        }
+
+        // Wait before connecting again, doubled after every failure up to `most`.
+        // The next send tries to connect right away.
+        socket& reconnect_backoff(std::chrono::milliseconds least, std::chrono::milliseconds most)
+        {
+            std::lock_guard<Mutex> lock(this->_mutex);
+            _least_backoff = least;
+            _most_backoff = std::max(least, most);
+            _backoff = least;
+            _retry_at = clock::time_point{};
+            return *this;
+        }
+
+        // APP-NAME and facility (0 to 23, user is 1) of RFC 5424 records
+        socket& app_name(const std::string& name)
+        {
+            std::lock_guard<Mutex> lock(this->_mutex);
+            _app = _header_field(name, 48);
+            return *this;
+        }
+        socket& facility(int facility)
+        {
+            std::lock_guard<Mutex> lock(this->_mutex);
+            _facility = std::clamp(facility, 0, 23);
+            return *this;
+        }
+
+        bool connected() const { return _connected.load(std::memory_order_relaxed); }
+
+        // Records sent, records dropped, rounds of sending and successful
+        // connects after the first one
+        uint64_t sent() const { return _sent.load(std::memory_order_relaxed); }
+        uint64_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+        uint64_t batches() const { return _batches.load(std::memory_order_relaxed); }
+        uint64_t reconnects() const { return _reconnects.load(std::memory_order_relaxed); }
+
+    protected:
+        void _process(const message_t& msg, const fmt::memory_buffer& formatted) override
+        {
+            auto start = _pending.size();
+            _frame(msg, formatted);
+            if (_pending.size() > _budget)
+            {
+                _pending.resize(start);
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            _ends.push_back(_pending.size());
+
+            if (_pending.size() >= _batch_size || _ends.size() >= max_batch_records || msg.sevarity >= _flush_on)
+                _send();
+        }
+
+        void _flush() override
+        {
+            _send();
+        }
+
+    private:
+        using clock = std::chrono::steady_clock;
+
+        // ─── FRAMING ────────────────────────────────────────────────────────────────────
+
+        void _frame(const message_t& msg, const fmt::memory_buffer& formatted)
+        {
+            std::string_view text(formatted.data(), formatted.size());
+            while (!text.empty() && (text.back() == '\n' || text.back() == '\r'))
+                text.remove_suffix(1);
+
+            if (_framing == socket_framing_t::newline)
+            {
+                _append(text);
+                _append("\n");
+                return;
+            }
+
+            _header.resize(0);
+            fmt::format_to(_header, "<{}>1 ", _facility * 8 + _severity(msg.sevarity));
+            _timestamp(msg.time);
+            _header.push_back(' ');
+            _append_to(_header, _host);
+            _header.push_back(' ');
+            _append_to(_header, _app);
+            _header.push_back(' ');
+            _append_to(_header, _process_id);
+            _header.push_back(' ');
+            _append_to(_header, _message_id(msg));
+            _append_to(_header, " - ");
+
+            if (_endpoint.stream())
+                fmt::format_to(_pending, "{} ", _header.size() + text.size());
+            _append(std::string_view(_header.data(), _header.size()));
+            _append(text);
+        }
+
+        static int _severity(sevarity_t level)
+        {
+            switch (level)
+            {
+                case sevarity_t::trace:
+                case sevarity_t::debug: return 7;
+                case sevarity_t::warn: return 4;
+                case sevarity_t::error: return 3;
+                case sevarity_t::critical: return 2;
+                default: return 6;
+            }
+        }
+
+        // 2020-01-02T03:04:05.123456Z, the text of the second is kept
+        void _timestamp(std::chrono::system_clock::time_point time)
+        {
+            auto micros = std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+            auto seconds = micros / 1000000;
+            auto fraction = micros % 1000000;
+            if (fraction < 0)
+            {
+                fraction += 1000000;
+                --seconds;
+            }
+
+            if (seconds != _cached_second)
+            {
+                _cached_second = seconds;
+                auto value = static_cast<std::time_t>(seconds);
+                std::tm tm;
+                ::gmtime_r(&value, &tm);
+                _cached_time.resize(0);
+                fmt::format_to(_cached_time, "{:04}-{:02}-{:02}T{:02}:{:02}:{:02}", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+            }
+            _append_to(_header, std::string_view(_cached_time.data(), _cached_time.size()));
+            fmt::format_to(_header, ".{:06}Z", fraction);
+        }
+
+        // the logger name as MSGID, worked out again only for another logger.
+        // The text is compared too, a logger can be replaced by another one at
+        // the same address.
+        const std::string& _message_id(const message_t& msg)
+        {
+            if (msg.names != _last_names || (msg.names != nullptr && *msg.names != _last_name))
+            {
+                _last_names = msg.names;
+                _last_name = msg.names != nullptr ? *msg.names : std::string();
+                _last_id = msg.names != nullptr ? _header_field(*msg.names, 32) : "-";
+            }
+            return _last_id;
+        }
+
+        // header fields are printable ASCII without spaces, "-" when empty
+        static std::string _header_field(std::string_view value, size_t limit)
+        {
+            std::string field;
+            for (auto c : value.substr(0, limit))
+                field.push_back(c > 32 && c < 127 ? c : '_');
+            return field.empty() ? "-" : field;
+        }
+
+        static void _append_to(fmt::memory_buffer& buffer, std::string_view text)
+        {
+            buffer.append(text.data(), text.data() + text.size());
+        }
+
+        void _append(std::string_view text)
+        {
+            _append_to(_pending, text);
+        }
+
+        // ─── SENDING ────────────────────────────────────────────────────────────────────
+
+        void _send()
+        {
+            if (_ends.empty() || (!_socket.is_open() && !_connect()))
+                return;
+
+            auto status = _endpoint.stream() ? _send_stream() : _send_datagrams();
+            if (status == os::socket_t::status_t::broken)
+            {
+                _socket.close();
+                _connected.store(false, std::memory_order_relaxed);
+                // the rest of a record the peer got half of is of no use
+                if (_front_partial)
+                    _drop_front();
+                _retry_after_failure();
+            }
+            else
+                _backoff = _least_backoff;
+        }
+
+        os::socket_t::status_t _send_datagrams()
+        {
+            _batches.fetch_add(1, std::memory_order_relaxed);
+            for (;;)
+            {
+                _blocks.clear();
+                size_t start = 0;
+                for (auto end : _ends)
+                {
+                    _blocks.push_back({ _pending.data() + start, end - start });
+                    start = end;
+                }
+
+                auto result = _socket.send_datagrams(_blocks.data(), _blocks.size());
+                if (result.count > 0)
+                {
+                    _sent.fetch_add(result.count, std::memory_order_relaxed);
+                    _consume(_ends[result.count - 1]);
+                }
+                if (result.status != os::socket_t::status_t::too_large)
+                    return result.status;
+
+                _drop_front();
+                if (_ends.empty())
+                    return os::socket_t::status_t::ok;
+            }
+        }
+
+        os::socket_t::status_t _send_stream()
+        {
+            _batches.fetch_add(1, std::memory_order_relaxed);
+            os::socket_t::block_t block{ _pending.data(), _pending.size() };
+            auto result = _socket.send_stream(&block, 1);
+
+            if (result.count > 0)
+            {
+                auto before = _ends.size();
+                // stopped inside a record unless it stopped right at one's end
+                _front_partial = !std::binary_search(_ends.begin(), _ends.end(), result.count);
+                _consume(result.count);
+                _sent.fetch_add(before - _ends.size(), std::memory_order_relaxed);
+            }
+            return result.status;
+        }
+
+        // removes `bytes` from the front of the buffer, and the records that
+        // ended in them
+        void _consume(size_t bytes)
+        {
+            if (bytes == 0)
+                return;
+
+            auto left = _pending.size() - bytes;
+            std::memmove(_pending.data(), _pending.data() + bytes, left);
+            _pending.resize(left);
+
+            size_t done = 0;
+            while (done < _ends.size() && _ends[done] <= bytes)
+                ++done;
+            _ends.erase(_ends.begin(), _ends.begin() + static_cast<std::ptrdiff_t>(done));
+            for (auto& end : _ends)
+                end -= bytes;
+        }
+
+        void _drop_front()
+        {
+            _consume(_ends.front());
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            _front_partial = false;
+        }
+
+        bool _connect()
+        {
+            if (clock::now() < _retry_at)
+                return false;
+
+            if (!_socket.connect(_endpoint))
+            {
+                _retry_after_failure();
+                return false;
+            }
+
+            _connected.store(true, std::memory_order_relaxed);
+            if (_connected_before)
+                _reconnects.fetch_add(1, std::memory_order_relaxed);
+            _connected_before = true;
+            return true;
+        }
+
+        void _retry_after_failure()
+        {
+            _retry_at = clock::now() + _backoff;
+            _backoff = std::min(_backoff * 2, _most_backoff);
+        }
+
+        os::socket_endpoint_t _endpoint;
+        socket_framing_t _framing;
+        os::socket_t _socket;
+
+        fmt::memory_buffer _pending;
+        std::vector<size_t> _ends; // of the records in _pending
+        std::vector<os::socket_t::block_t> _blocks;
+        bool _front_partial{ false };
+        size_t _batch_size{ default_batch_size };
+        size_t _budget{ default_budget };
+        sevarity_t _flush_on{ sevarity_t::off };
+
+        std::chrono::milliseconds _least_backoff{ 100 };
+        std::chrono::milliseconds _most_backoff{ 10000 };
+        std::chrono::milliseconds _backoff{ 100 };
+        clock::time_point _retry_at{};
+        bool _connected_before{ false };
+
+        fmt::memory_buffer _header;
+        fmt::memory_buffer _cached_time;
+        int64_t _cached_second{ -1 };
+        int _facility{ 1 };
+        std::string _host;
+        std::string _app{ "-" };
+        std::string _process_id;
+        const std::string* _last_names{ nullptr };
+        std::string _last_name;
+        std::string _last_id{ "-" };
+
+        std::atomic<bool> _connected{ false };
+        std::atomic<uint64_t> _sent{ 0 };
+        std::atomic<uint64_t> _dropped{ 0 };
+        std::atomic<uint64_t> _batches{ 0 };
+        std::atomic<uint64_t> _reconnects{ 0 };
+
+        log::internal::periodic_flusher_t _flusher;
+    };
+} // namespace internal
+
+using socket_mt = internal::socket<std::mutex>;
+using socket_st = internal::socket<log::internal::null_mutex>;
+#endif
+} // namespace pride::log::channels
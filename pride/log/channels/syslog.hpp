@@ -18,6 +18,7 @@ class syslog_t : public channel_t
 {
 public:
     syslog_t(const std::string& indent = "", int option = 0, int facility = LOG_USER)
+        : _indent(indent)
     {
         _properties[static_cast<size_t>(sevarity_t::trace)] = LOG_DEBUG;
         _properties[static_cast<size_t>(sevarity_t::info)] = LOG_INFO;
@@ -40,7 +41,8 @@ public:
 
     void log(const message_t& msg) override
     {
-        ::syslog(prop_from_sevarity(msg), "%s", fmt::to_string(msg.raw).c_str());
+        // the message is not null terminated, the precision bounds it
+        ::syslog(prop_from_sevarity(msg), "%.*s", static_cast<int>(msg.raw.size()), msg.raw.data());
     }
 
     void flush() override {}
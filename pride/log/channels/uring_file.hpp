@@ -0,0 +1,161 @@
+#pragma once
+
+#include "../../os/file.hpp"
+#include "../channel.hpp"
+#include "../internal/file_writer.hpp"
+#include "../internal/flusher.hpp"
+#include "../internal/null.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+
+namespace pride::log::channels
+{
+namespace internal
+{
+    // File channel that never writes on the logging thread. Records are
+    // packed into a set of buffers. A full buffer is submitted to io_uring as
+    // a write and the channel moves on to the next buffer. A thread of the
+    // writer reaps completions and frees buffers again. The logging thread
+    // only waits when every buffer is still in flight. Where io_uring is
+    // missing (other systems, old kernels, seccomp) a few writer threads do
+    // the positioned writes instead. flush() submits the open buffer with an
+    // fdatasync linked behind it and waits for both.
+    template<typename Mutex>
+    class uring_file : public base_channel<Mutex>
+    {
+    public:
+        static constexpr size_t default_buffer_size = 256 * 1024;
+        static constexpr size_t default_buffer_count = 8;
+        static constexpr size_t fallback_threads = 2;
+
+        // `use_uring` false always takes the writer threads
+        explicit uring_file(const std::string& filename, bool truncate = false, size_t buffer_size = default_buffer_size,
+                            size_t buffer_count = default_buffer_count, bool use_uring = true)
+            : base_channel<Mutex>()
+        {
+            _file.open(filename, truncate, false);
+            _writer = log::internal::make_file_writer(_file, buffer_size, buffer_count, fallback_threads, use_uring);
+        }
+
+        ~uring_file() override
+        {
+            _flusher.stop();
+            std::lock_guard<Mutex> lock(this->_mutex);
+            _submit();
+            _writer->wait();
+        }
+
+        uring_file(const uring_file&) = delete;
+        uring_file& operator=(const uring_file&) = delete;
+
+        // Records at or above this level are submitted right away, without
+        // waiting for their buffer to fill
+        uring_file& flush_on(sevarity_t level)
+        {
+            std::lock_guard<Mutex> lock(this->_mutex);
+            _flush_on = level;
+            return *this;
+        }
+
+        // What flush() syncs the file with, fdatasync by default
+        uring_file& sync_on_flush(log::internal::file_sync_t mode)
+        {
+            std::lock_guard<Mutex> lock(this->_mutex);
+            _sync = mode;
+            return *this;
+        }
+
+        // Submits the open buffer at least this often from a background
+        // thread, zero turns it off. It does not sync, only flush() does.
+        uring_file& flush_every(std::chrono::milliseconds interval)
+        {
+            static_assert(!std::is_same_v<Mutex, log::internal::null_mutex>, "flush_every needs the thread safe channel");
+
+            _flusher.start(interval, [this] {
+                std::lock_guard<Mutex> lock(this->_mutex);
+                _submit();
+            });
+            return *this;
+        }
+
+        // False when the writes go through the fallback writer threads
+        bool uses_uring() const { return _writer->uses_uring(); }
+
+        // Writes submitted so far, and the ones among them that failed
+        uint64_t submissions() const { return _writer->submissions(); }
+        uint64_t failures() const { return _writer->failures(); }
+
+    protected:
+        void _process(const message_t& msg, const fmt::memory_buffer& formatted) override
+        {
+            auto data = formatted.data();
+            auto size = formatted.size();
+            while (size > 0)
+            {
+                if (_current == npos)
+                {
+                    _current = _writer->acquire();
+                    _used = 0;
+                }
+
+                auto part = std::min(size, _writer->buffer_size() - _used);
+                std::memcpy(_writer->data(_current) + _used, data, part);
+                _used += part;
+                data += part;
+                size -= part;
+
+                if (_used == _writer->buffer_size())
+                    _submit();
+            }
+
+            if (msg.sevarity >= _flush_on)
+                _submit();
+        }
+
+        void _flush() override
+        {
+            if (_current != npos && _used > 0)
+                _writer->sync(_sync, _current, _used);
+            else
+            {
+                _submit();
+                _writer->sync(_sync);
+            }
+            _current = npos;
+        }
+
+    private:
+        static constexpr size_t npos = log::internal::file_writer_t::npos;
+
+        void _submit()
+        {
+            if (_current == npos)
+                return;
+
+            if (_used > 0)
+                _writer->submit(_current, _used);
+            else
+                _writer->release(_current);
+            _current = npos;
+        }
+
+        os::raw_file_t _file;
+        std::unique_ptr<log::internal::file_writer_t> _writer;
+        size_t _current{ npos };
+        size_t _used{ 0 };
+        sevarity_t _flush_on{ sevarity_t::off };
+        log::internal::file_sync_t _sync{ log::internal::file_sync_t::data };
+
+        log::internal::periodic_flusher_t _flusher;
+    };
+} // namespace internal
+
+using uring_file_mt = internal::uring_file<std::mutex>;
+using uring_file_st = internal::uring_file<log::internal::null_mutex>;
+} // namespace pride::log::channels
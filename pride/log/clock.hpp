@@ -0,0 +1,81 @@
+#pragma once
+
+#include "../config/detection/os.hpp"
+#include "internal/tsc.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if defined(PRIDE_OS_LINUX)
+#    include <time.h>
+#endif
+
+namespace pride::log
+{
+// Clock every record is stamped with. All of them give wall time, they trade
+// resolution for the cost of a read.
+enum class clock_source_t : uint8_t
+{
+    precise, // std::chrono::system_clock
+    coarse,  // CLOCK_REALTIME_COARSE, as fine as the scheduler tick (1 to 4ms)
+    tsc      // the cycle counter of the cpu, calibrated against the system clock
+};
+
+namespace internal
+{
+    inline std::atomic<clock_source_t> current_clock_source{ clock_source_t::precise };
+
+    inline std::chrono::system_clock::time_point coarse_now()
+    {
+#if defined(PRIDE_OS_LINUX)
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+        return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec)));
+#else
+        return std::chrono::system_clock::now();
+#endif
+    }
+
+    inline std::chrono::system_clock::time_point now()
+    {
+        // acquire pairs with the release in clock_source(), a reader that
+        // sees the tsc also sees its calibration
+        switch (current_clock_source.load(std::memory_order_acquire))
+        {
+        case clock_source_t::coarse: return coarse_now();
+        case clock_source_t::tsc: return tsc_clock.now();
+        default: return std::chrono::system_clock::now();
+        }
+    }
+} // namespace internal
+
+// Changes the clock of the records logged from here on. Returns false when the
+// source is not available on this platform, the clock is left as it was then.
+// The first switch to the tsc calibrates the counter, which takes about 10ms.
+inline bool clock_source(clock_source_t source)
+{
+    switch (source)
+    {
+    case clock_source_t::coarse:
+#if !defined(PRIDE_OS_LINUX)
+        return false;
+#endif
+        break;
+    case clock_source_t::tsc:
+        if (!internal::tsc_clock_t::supported())
+            return false;
+        internal::tsc_clock.calibrate();
+        break;
+    default:
+        break;
+    }
+
+    internal::current_clock_source.store(source, std::memory_order_release);
+    return true;
+}
+
+inline clock_source_t clock_source()
+{
+    return internal::current_clock_source.load(std::memory_order_acquire);
+}
+} // namespace pride::log
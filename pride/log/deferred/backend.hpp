@@ -0,0 +1,240 @@
+#pragma once
+
+#include "../internal/backoff.hpp"
+#include "../internal/thread.hpp"
+#include "codec.hpp"
+#include "ring.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pride::log::deferred
+{
+class sink_t;
+
+// Fixed part of every record in a producer ring, the encoded arguments follow
+struct record_header_t
+{
+    uint32_t size; // header and arguments, must stay the first member
+    uint32_t reserved;
+    const call_site_t* site;
+    sink_t* sink;
+    int64_t time; // nanoseconds since the epoch
+};
+
+// Receives the records of one logger on the backend thread
+class sink_t
+{
+public:
+    virtual ~sink_t() = default;
+    virtual void consume(const record_header_t& header, size_t thread_id, const char* args, size_t size) = 0;
+};
+
+// Owns one ring per producing thread and the thread that drains them. The
+// records of different threads are handed out round robin, within a thread
+// they keep their order.
+class backend_t
+{
+public:
+    static constexpr size_t default_ring_size = 1 << 20;
+
+    static std::shared_ptr<backend_t> instance();
+
+    backend_t(const backend_t&) = delete;
+    backend_t& operator=(const backend_t&) = delete;
+    ~backend_t();
+
+    // Ring of the calling thread, created the first time a thread logs
+    byte_ring_t& local_ring();
+
+    // Blocks until every record written before the call has been consumed
+    void flush();
+
+    // Producers call this after a commit, it wakes the backend thread when
+    // it is parked
+    void notify() { _parker.notify(); }
+
+    // Size of the rings created from now on
+    void ring_size(size_t size) { _ring_size.store(size, std::memory_order_relaxed); }
+    size_t ring_size() const { return _ring_size.load(std::memory_order_relaxed); }
+
+private:
+    backend_t();
+
+    struct producer_t
+    {
+        producer_t(size_t capacity, size_t thread_id)
+            : ring(capacity)
+            , thread_id(thread_id)
+        {}
+
+        byte_ring_t ring;
+        size_t thread_id;
+        std::atomic<bool> retired{ false };
+    };
+
+    struct thread_handle_t
+    {
+        std::shared_ptr<producer_t> producer;
+        ~thread_handle_t()
+        {
+            if (producer)
+                producer->retired.store(true, std::memory_order_release);
+        }
+    };
+
+    void _run();
+    bool _drain(producer_t& producer, size_t budget);
+    std::shared_ptr<producer_t> _add_producer();
+
+    std::atomic<size_t> _ring_size{ default_ring_size };
+
+    std::mutex _mutex;
+    std::vector<std::shared_ptr<producer_t>> _producers;
+    std::atomic<uint64_t> _generation{ 0 };
+
+    std::atomic<bool> _running{ true };
+    log::internal::parker_t _parker;
+    std::thread _thread;
+};
+
+// ────────────────────────────────────────────────────────────────────────────────
+
+inline std::shared_ptr<backend_t> backend_t::instance()
+{
+    // loggers keep a reference so the backend outlives every one of them,
+    // even the ones destroyed with the static logger map
+    static std::shared_ptr<backend_t> backend(new backend_t());
+    return backend;
+}
+
+inline backend_t::backend_t()
+{
+    _thread = std::thread([this] { _run(); });
+}
+
+inline backend_t::~backend_t()
+{
+    _running.store(false, std::memory_order_release);
+    _parker.notify();
+    _thread.join();
+}
+
+// ────────────────────────────────────────────────────────────────────────────────
+
+inline byte_ring_t& backend_t::local_ring()
+{
+    static thread_local thread_handle_t handle;
+    if (!handle.producer)
+        handle.producer = _add_producer();
+    return handle.producer->ring;
+}
+
+inline std::shared_ptr<backend_t::producer_t> backend_t::_add_producer()
+{
+    auto producer = std::make_shared<producer_t>(ring_size(), log::internal::thread_id());
+    std::lock_guard<std::mutex> lock(_mutex);
+    _producers.push_back(producer);
+    _generation.fetch_add(1, std::memory_order_release);
+    return producer;
+}
+
+inline void backend_t::flush()
+{
+    std::vector<std::pair<std::shared_ptr<producer_t>, uint64_t>> targets;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto& producer : _producers)
+            targets.emplace_back(producer, producer->ring.written());
+    }
+
+    log::internal::backoff_t backoff;
+    for (auto& [producer, position] : targets)
+    {
+        while (producer->ring.consumed() < position)
+            backoff.pause();
+    }
+}
+
+// ────────────────────────────────────────────────────────────────────────────────
+
+inline void backend_t::_run()
+{
+    std::vector<std::shared_ptr<producer_t>> producers;
+    uint64_t generation = ~uint64_t(0);
+    log::internal::backoff_t backoff;
+
+    for (;;)
+    {
+        if (_generation.load(std::memory_order_acquire) != generation)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            generation = _generation.load(std::memory_order_relaxed);
+            producers = _producers;
+        }
+
+        bool busy = false;
+        bool retired = false;
+        for (auto& producer : producers)
+        {
+            busy |= _drain(*producer, 256);
+            retired |= producer->retired.load(std::memory_order_acquire);
+        }
+
+        if (retired && !busy)
+        {
+            // a thread is gone and its ring is empty, forget about it
+            std::lock_guard<std::mutex> lock(_mutex);
+            _producers.erase(std::remove_if(_producers.begin(), _producers.end(),
+                                 [](const std::shared_ptr<producer_t>& producer) {
+                                     return producer->retired.load(std::memory_order_acquire)
+                                         && producer->ring.consumed() == producer->ring.written();
+                                 }),
+                _producers.end());
+            _generation.fetch_add(1, std::memory_order_release);
+        }
+
+        if (busy)
+        {
+            backoff.reset();
+            continue;
+        }
+
+        if (!_running.load(std::memory_order_acquire))
+            return;
+        backoff.pause(_parker, [&] {
+            return !_running.load(std::memory_order_acquire) || _generation.load(std::memory_order_acquire) != generation
+                || std::any_of(producers.begin(), producers.end(), [](const std::shared_ptr<producer_t>& producer) { return producer->ring.consumed() != producer->ring.written(); });
+        });
+    }
+}
+
+inline bool backend_t::_drain(producer_t& producer, size_t budget)
+{
+    bool any = false;
+    uint32_t size;
+    while (budget-- > 0)
+    {
+        const char* data = producer.ring.peek(size);
+        if (data == nullptr)
+            break;
+
+        record_header_t header;
+        std::memcpy(&header, data, sizeof(header));
+        try
+        {
+            header.sink->consume(header, producer.thread_id, data + sizeof(header), size - sizeof(header));
+        }
+        catch (...)
+        {
+        }
+        producer.ring.pop(size);
+        any = true;
+    }
+    return any;
+}
+} // namespace pride::log::deferred
@@ -0,0 +1,370 @@
+#pragma once
+
+#include "../fmt.hpp"
+#include "../message.hpp"
+#include "../sevarity.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+namespace pride::log::deferred
+{
+// Wire type of a captured argument. Every C++ argument type maps onto one of
+// these so that a record can be decoded without the types that produced it.
+enum class arg_type_t : uint8_t
+{
+    i32,
+    u32,
+    i64,
+    u64,
+    f64,
+    character,
+    boolean,
+    pointer,
+    string
+};
+
+static constexpr size_t max_arguments = 32;
+
+// Static description of one deferred log statement. It is registered the
+// first time the statement runs and a record only carries its address.
+struct call_site_t
+{
+    call_site_t(sevarity_t level, const char* file, int line, const char* function = nullptr)
+        : level(level)
+        , source{ file, line, function }
+    {}
+
+    call_site_t(const call_site_t&) = delete;
+    call_site_t& operator=(const call_site_t&) = delete;
+
+    sevarity_t level;
+    source_location_t source; // what msg.source points to
+
+    const char* format{ nullptr };
+    const arg_type_t* types{ nullptr };
+    uint8_t arg_count{ 0 };
+    std::atomic<bool> registered{ false };
+};
+
+namespace internal
+{
+    template<typename T>
+    using bare_t = std::remove_cv_t<std::remove_reference_t<T>>;
+
+    template<typename T>
+    constexpr bool is_string_v = std::is_same_v<std::decay_t<bare_t<T>>, const char*> || std::is_same_v<std::decay_t<bare_t<T>>, char*>
+        || std::is_same_v<bare_t<T>, std::string> || std::is_same_v<bare_t<T>, std::string_view> || std::is_same_v<bare_t<T>, fmt::string_view>;
+
+    template<typename T>
+    constexpr arg_type_t arg_type_of()
+    {
+        using type = bare_t<T>;
+        if constexpr (std::is_same_v<type, bool>)
+            return arg_type_t::boolean;
+        else if constexpr (std::is_same_v<type, char>)
+            return arg_type_t::character;
+        else if constexpr (std::is_integral_v<type> && std::is_signed_v<type>)
+            return sizeof(type) <= 4 ? arg_type_t::i32 : arg_type_t::i64;
+        else if constexpr (std::is_integral_v<type>)
+            return sizeof(type) <= 4 ? arg_type_t::u32 : arg_type_t::u64;
+        else if constexpr (std::is_enum_v<type>)
+            return arg_type_of<std::underlying_type_t<type>>();
+        else if constexpr (std::is_floating_point_v<type>)
+            return arg_type_t::f64;
+        else if constexpr (is_string_v<T>)
+            return arg_type_t::string;
+        else if constexpr (std::is_pointer_v<type> || std::is_null_pointer_v<type>)
+            return arg_type_t::pointer;
+        else
+            return arg_type_t::string; // formatted to text when captured
+    }
+
+    template<typename... Args>
+    struct arg_types
+    {
+        static constexpr arg_type_t value[] = { arg_type_of<Args>()..., arg_type_t::boolean };
+    };
+
+    // Arguments are reduced to a fixed width value or a view of some text
+    // before they are encoded. Types fmt has to format for us are turned into
+    // text right away, that is the only capture that costs more than a copy.
+    template<typename T>
+    auto capture(const T& value)
+    {
+        using type = bare_t<T>;
+        constexpr auto wire = arg_type_of<T>();
+        if constexpr (wire == arg_type_t::string && is_string_v<T>)
+        {
+            if constexpr (std::is_same_v<type, std::string> || std::is_same_v<type, std::string_view> || std::is_same_v<type, fmt::string_view>)
+                return std::string_view(value.data(), value.size());
+            else if constexpr (std::is_array_v<type>)
+                return std::string_view(value);
+            else
+                return value == nullptr ? std::string_view() : std::string_view(value);
+        }
+        else if constexpr (wire == arg_type_t::string)
+            return fmt::format("{}", value);
+        else if constexpr (wire == arg_type_t::pointer)
+            return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value));
+        else if constexpr (wire == arg_type_t::i32)
+            return static_cast<int32_t>(value);
+        else if constexpr (wire == arg_type_t::u32)
+            return static_cast<uint32_t>(value);
+        else if constexpr (wire == arg_type_t::i64)
+            return static_cast<int64_t>(value);
+        else if constexpr (wire == arg_type_t::u64)
+            return static_cast<uint64_t>(value);
+        else if constexpr (wire == arg_type_t::f64)
+            return static_cast<double>(value);
+        else
+            return value; // bool, char
+    }
+
+    template<typename T>
+    size_t encoded_size(const T& value)
+    {
+        if constexpr (std::is_same_v<T, std::string_view> || std::is_same_v<T, std::string>)
+            return sizeof(uint32_t) + value.size();
+        else
+            return sizeof(T);
+    }
+
+    template<typename T>
+    char* encode(char* out, const T& value)
+    {
+        if constexpr (std::is_same_v<T, std::string_view> || std::is_same_v<T, std::string>)
+        {
+            auto size = static_cast<uint32_t>(value.size());
+            std::memcpy(out, &size, sizeof(size));
+            std::memcpy(out + sizeof(size), value.data(), size);
+            return out + sizeof(size) + size;
+        }
+        else
+        {
+            std::memcpy(out, &value, sizeof(T));
+            return out + sizeof(T);
+        }
+    }
+
+    template<typename Tuple, size_t... I>
+    size_t encoded_size(const Tuple& values, std::index_sequence<I...>)
+    {
+        return (size_t(0) + ... + encoded_size(std::get<I>(values)));
+    }
+
+    template<typename Tuple, size_t... I>
+    char* encode(char* out, const Tuple& values, std::index_sequence<I...>)
+    {
+        ((out = encode(out, std::get<I>(values))), ...);
+        return out;
+    }
+
+    inline std::mutex& site_mutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+} // namespace internal
+
+// Fills in the parts of a call site that depend on the call itself
+template<typename... Args>
+void register_site(call_site_t& site, const char* format)
+{
+    static_assert(sizeof...(Args) <= max_arguments, "too many arguments for a deferred log statement");
+    if (site.registered.load(std::memory_order_acquire))
+        return;
+
+    std::lock_guard<std::mutex> lock(internal::site_mutex());
+    if (site.registered.load(std::memory_order_relaxed))
+        return;
+    site.format = format;
+    site.types = internal::arg_types<Args...>::value;
+    site.arg_count = static_cast<uint8_t>(sizeof...(Args));
+    site.registered.store(true, std::memory_order_release);
+}
+
+//
+// ─── DECODING ───────────────────────────────────────────────────────────────────
+//
+
+struct decoded_arg_t
+{
+    arg_type_t type{ arg_type_t::i32 };
+    union
+    {
+        int64_t i;
+        uint64_t u;
+        double f;
+        char c;
+        bool b;
+    };
+    std::string_view s;
+
+    decoded_arg_t()
+        : i(0)
+    {}
+};
+
+// Reads `count` arguments of the given types, returns false when the payload
+// is shorter than the types say it is.
+inline bool decode_args(const char* data, size_t size, const arg_type_t* types, size_t count, decoded_arg_t* out)
+{
+    const char* end = data + size;
+    auto read = [&](void* dest, size_t bytes) {
+        if (static_cast<size_t>(end - data) < bytes)
+            return false;
+        std::memcpy(dest, data, bytes);
+        data += bytes;
+        return true;
+    };
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto& arg = out[i];
+        arg.type = types[i];
+        bool ok = true;
+        switch (arg.type)
+        {
+        case arg_type_t::i32:
+        {
+            int32_t value = 0;
+            ok = read(&value, sizeof(value));
+            arg.i = value;
+            break;
+        }
+        case arg_type_t::u32:
+        {
+            uint32_t value = 0;
+            ok = read(&value, sizeof(value));
+            arg.u = value;
+            break;
+        }
+        case arg_type_t::i64: ok = read(&arg.i, sizeof(arg.i)); break;
+        case arg_type_t::u64:
+        case arg_type_t::pointer: ok = read(&arg.u, sizeof(arg.u)); break;
+        case arg_type_t::f64: ok = read(&arg.f, sizeof(arg.f)); break;
+        case arg_type_t::character: ok = read(&arg.c, sizeof(arg.c)); break;
+        case arg_type_t::boolean: ok = read(&arg.b, sizeof(arg.b)); break;
+        case arg_type_t::string:
+        {
+            uint32_t length = 0;
+            ok = read(&length, sizeof(length)) && static_cast<size_t>(end - data) >= length;
+            if (ok)
+            {
+                arg.s = std::string_view(data, length);
+                data += length;
+            }
+            break;
+        }
+        }
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+
+namespace internal
+{
+    template<size_t Size>
+    void format_arg(fmt::basic_memory_buffer<char, Size>& out, const decoded_arg_t& arg, fmt::string_view spec)
+    {
+        if (spec.size() == 0)
+        {
+            switch (arg.type)
+            {
+            case arg_type_t::i32:
+            case arg_type_t::i64: fmt::helper::append_int(static_cast<long long>(arg.i), out); return;
+            case arg_type_t::u32:
+            case arg_type_t::u64: fmt::helper::append_int(static_cast<unsigned long long>(arg.u), out); return;
+            case arg_type_t::character: out.push_back(arg.c); return;
+            case arg_type_t::boolean: fmt::helper::append_str(arg.b ? "true" : "false", out); return;
+            case arg_type_t::string: out.append(arg.s.data(), arg.s.data() + arg.s.size()); return;
+            default: break;
+            }
+            spec = "{}";
+        }
+
+        switch (arg.type)
+        {
+        case arg_type_t::i32:
+        case arg_type_t::i64: fmt::format_to(out, spec, static_cast<long long>(arg.i)); break;
+        case arg_type_t::u32:
+        case arg_type_t::u64: fmt::format_to(out, spec, static_cast<unsigned long long>(arg.u)); break;
+        case arg_type_t::f64: fmt::format_to(out, spec, arg.f); break;
+        case arg_type_t::character: fmt::format_to(out, spec, arg.c); break;
+        case arg_type_t::boolean: fmt::format_to(out, spec, arg.b); break;
+        case arg_type_t::pointer: fmt::format_to(out, spec, reinterpret_cast<const void*>(static_cast<uintptr_t>(arg.u))); break;
+        case arg_type_t::string: fmt::format_to(out, spec, fmt::string_view(arg.s.data(), arg.s.size())); break;
+        }
+    }
+} // namespace internal
+
+// Formats a fmt style format string against decoded arguments. fmt can only
+// take a compile time list of arguments so the fields are formatted one at a
+// time, each with its own "{:spec}".
+template<size_t Size>
+void render(fmt::basic_memory_buffer<char, Size>& out, std::string_view format, const decoded_arg_t* args, size_t count)
+{
+    // "{:spec}" of the field, long specs spill to the heap
+    fmt::basic_memory_buffer<char, 64> spec;
+    size_t next_arg = 0;
+    size_t start = 0;
+    size_t i = 0;
+    const size_t size = format.size();
+    auto literal = [&](size_t end) { out.append(format.data() + start, format.data() + end); };
+
+    while (i < size)
+    {
+        const char c = format[i];
+        if ((c == '{' || c == '}') && i + 1 < size && format[i + 1] == c)
+        {
+            literal(i + 1);
+            i += 2;
+            start = i;
+            continue;
+        }
+        if (c != '{')
+        {
+            ++i;
+            continue;
+        }
+
+        auto close = format.find('}', i);
+        if (close == std::string_view::npos)
+            break;
+        literal(i);
+
+        size_t j = i + 1;
+        size_t index = next_arg++;
+        if (j < close && format[j] >= '0' && format[j] <= '9')
+        {
+            index = 0;
+            while (j < close && format[j] >= '0' && format[j] <= '9')
+                index = index * 10 + static_cast<size_t>(format[j++] - '0');
+        }
+
+        fmt::string_view field;
+        if (j < close && format[j] == ':')
+        {
+            spec.resize(0);
+            spec.push_back('{');
+            spec.append(format.data() + j, format.data() + close);
+            spec.push_back('}');
+            field = fmt::string_view(spec.data(), spec.size());
+        }
+
+        if (index < count)
+            internal::format_arg(out, args[index], field);
+
+        i = close + 1;
+        start = i;
+    }
+    literal(size);
+}
+} // namespace pride::log::deferred
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "../internal/queue.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace pride::log::deferred
+{
+// Single producer / single consumer ring of variable sized records. Every
+// record starts with its size so the consumer can walk the ring, a record
+// never wraps around the end: the producer marks the tail as padding and
+// starts again at the front instead.
+class byte_ring_t
+{
+public:
+    static constexpr size_t alignment = 8;
+    static constexpr uint32_t padding = 0xffffffffu;
+
+    explicit byte_ring_t(size_t capacity)
+        : _capacity(round_up(capacity))
+        , _mask(_capacity - 1)
+        , _data(new char[_capacity])
+    {}
+
+    byte_ring_t(const byte_ring_t&) = delete;
+    byte_ring_t& operator=(const byte_ring_t&) = delete;
+
+    size_t capacity() const { return _capacity; }
+
+    // Producer: room for `size` bytes (the first four are the size of the
+    // record) or nullptr when the consumer has not caught up.
+    char* reserve(size_t size)
+    {
+        size = align(size);
+        const auto offset = _write & _mask;
+        const auto contiguous = _capacity - offset;
+        const auto needed = size <= contiguous ? size : contiguous + size;
+
+        if (_write + needed - _read_cache > _capacity)
+        {
+            _read_cache = _read.load(std::memory_order_acquire);
+            if (_write + needed - _read_cache > _capacity)
+                return nullptr;
+        }
+
+        if (size > contiguous)
+        {
+            std::memcpy(_data.get() + offset, &padding, sizeof(padding));
+            _write += contiguous;
+        }
+        _reserved = size;
+        return _data.get() + (_write & _mask);
+    }
+
+    void commit()
+    {
+        _write += _reserved;
+        _write_index.store(_write, std::memory_order_release);
+    }
+
+    // Consumer: the next record and its size, nullptr when the ring is empty
+    const char* peek(uint32_t& size)
+    {
+        for (;;)
+        {
+            if (_read_local == _write_cache)
+            {
+                _write_cache = _write_index.load(std::memory_order_acquire);
+                if (_read_local == _write_cache)
+                    return nullptr;
+            }
+
+            const char* record = _data.get() + (_read_local & _mask);
+            std::memcpy(&size, record, sizeof(size));
+            if (size != padding)
+                return record;
+
+            _read_local += _capacity - (_read_local & _mask);
+        }
+    }
+
+    void pop(uint32_t size)
+    {
+        _read_local += align(size);
+        _read.store(_read_local, std::memory_order_release);
+    }
+
+    // Position of the producer, used to wait until everything written before
+    // a point in time has been consumed
+    uint64_t written() const { return _write_index.load(std::memory_order_acquire); }
+    uint64_t consumed() const { return _read.load(std::memory_order_acquire); }
+
+private:
+    static size_t round_up(size_t value)
+    {
+        size_t result = 1024;
+        while (result < value)
+            result <<= 1;
+        return result;
+    }
+
+    static size_t align(size_t size) { return (size + alignment - 1) & ~(alignment - 1); }
+
+    const size_t _capacity;
+    const size_t _mask;
+    std::unique_ptr<char[]> _data;
+
+    // producer side
+    alignas(log::internal::cache_line_size) uint64_t _write{ 0 };
+    uint64_t _read_cache{ 0 };
+    size_t _reserved{ 0 };
+    std::atomic<uint64_t> _write_index{ 0 };
+
+    // consumer side
+    alignas(log::internal::cache_line_size) uint64_t _read_local{ 0 };
+    uint64_t _write_cache{ 0 };
+    std::atomic<uint64_t> _read{ 0 };
+};
+} // namespace pride::log::deferred
@@ -0,0 +1,271 @@
+#pragma once
+
+#include "../../os/file.hpp"
+#include "../fmt.hpp"
+#include "../message.hpp"
+#include "backend.hpp"
+#include "codec.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Binary log stream
+//
+//  header  "PRIDEDL2", u32 name size, logger name
+//  site    u8 1, u32 id, u8 level, u32 line, u8 arg count, arg types,
+//          u32 format size, u32 file size, u32 function size, format, file,
+//          function
+//  record  u8 2, u32 site id, u64 thread id, i64 time (ns), u32 args size, args
+//
+// A site is written once, before the first record that uses it. Integers are
+// stored in the byte order of the machine that wrote the stream.
+
+namespace pride::log::deferred
+{
+static constexpr char stream_magic[8] = { 'P', 'R', 'I', 'D', 'E', 'D', 'L', '2' };
+
+enum class entry_kind_t : uint8_t
+{
+    site = 1,
+    record = 2
+};
+
+namespace internal
+{
+    template<typename T>
+    void put(fmt::memory_buffer& buffer, T value)
+    {
+        const char* data = reinterpret_cast<const char*>(&value);
+        buffer.append(data, data + sizeof(T));
+    }
+
+    inline void put(fmt::memory_buffer& buffer, const char* data, size_t size)
+    {
+        buffer.append(data, data + size);
+    }
+} // namespace internal
+
+// ────────────────────────────────────────────────────────────────────────────────
+
+// Writes the records of one logger as they are, only used from the backend
+// thread apart from flush.
+class stream_writer_t
+{
+public:
+    stream_writer_t(const std::string& filename, const std::string& name);
+
+    void write(const record_header_t& header, size_t thread_id, const char* args, size_t size);
+    void flush() { _file.flush(); }
+
+private:
+    uint32_t _site_id(const call_site_t& site);
+
+    os::file_t _file;
+    fmt::memory_buffer _buffer;
+    std::unordered_map<const call_site_t*, uint32_t> _sites;
+};
+
+inline stream_writer_t::stream_writer_t(const std::string& filename, const std::string& name)
+{
+    _file.open(filename, true);
+    internal::put(_buffer, stream_magic, sizeof(stream_magic));
+    internal::put(_buffer, static_cast<uint32_t>(name.size()));
+    internal::put(_buffer, name.data(), name.size());
+    _file.write(_buffer);
+}
+
+inline void stream_writer_t::write(const record_header_t& header, size_t thread_id, const char* args, size_t size)
+{
+    _buffer.resize(0);
+    auto site = _site_id(*header.site);
+    internal::put(_buffer, entry_kind_t::record);
+    internal::put(_buffer, site);
+    internal::put(_buffer, static_cast<uint64_t>(thread_id));
+    internal::put(_buffer, header.time);
+    internal::put(_buffer, static_cast<uint32_t>(size));
+    internal::put(_buffer, args, size);
+    _file.write(_buffer);
+}
+
+inline uint32_t stream_writer_t::_site_id(const call_site_t& site)
+{
+    auto it = _sites.find(&site);
+    if (it != _sites.end())
+        return it->second;
+
+    auto id = static_cast<uint32_t>(_sites.size());
+    _sites.emplace(&site, id);
+
+    const auto& source = site.source;
+    auto format_size = static_cast<uint32_t>(std::strlen(site.format));
+    auto file_size = static_cast<uint32_t>(source.file ? std::strlen(source.file) : 0);
+    auto function_size = static_cast<uint32_t>(source.function ? std::strlen(source.function) : 0);
+    internal::put(_buffer, entry_kind_t::site);
+    internal::put(_buffer, id);
+    internal::put(_buffer, site.level);
+    internal::put(_buffer, static_cast<uint32_t>(source.line));
+    internal::put(_buffer, site.arg_count);
+    internal::put(_buffer, reinterpret_cast<const char*>(site.types), site.arg_count);
+    internal::put(_buffer, format_size);
+    internal::put(_buffer, file_size);
+    internal::put(_buffer, function_size);
+    internal::put(_buffer, site.format, format_size);
+    internal::put(_buffer, source.file, file_size);
+    internal::put(_buffer, source.function, function_size);
+    return id;
+}
+
+// ────────────────────────────────────────────────────────────────────────────────
+
+// Reads a stream written by stream_writer_t back into messages that can be
+// given to any formatter_t.
+class stream_reader_t
+{
+public:
+    struct site_t
+    {
+        sevarity_t level;
+        uint32_t line;
+        std::vector<arg_type_t> types;
+        std::string format;
+        std::string file;
+        std::string function;
+        source_location_t source; // points into file and function
+    };
+
+    explicit stream_reader_t(const std::string& filename);
+
+    // False when the file could not be read or is not a binary log
+    bool good() const { return _good; }
+    const std::string& name() const { return _name; }
+
+    // Decodes the next record into `msg`, false at the end of the stream or
+    // at the first entry that does not make sense.
+    bool next(message_t& msg);
+
+    // Site of the last record returned by next
+    const site_t* site() const { return _site; }
+
+private:
+    template<typename T>
+    bool _get(T& value)
+    {
+        if (_data.size() - _offset < sizeof(T))
+            return false;
+        std::memcpy(&value, _data.data() + _offset, sizeof(T));
+        _offset += sizeof(T);
+        return true;
+    }
+
+    bool _get(std::string& value, size_t size);
+    bool _read_site();
+
+    std::vector<char> _data;
+    size_t _offset{ 0 };
+    bool _good{ false };
+    std::string _name;
+    std::deque<site_t> _sites; // stays put, messages point to the sources
+    const site_t* _site{ nullptr };
+    decoded_arg_t _args[max_arguments];
+};
+
+inline stream_reader_t::stream_reader_t(const std::string& filename)
+{
+    auto file = std::fopen(filename.c_str(), "rb");
+    if (file == nullptr)
+        return;
+
+    char chunk[1 << 16];
+    size_t count;
+    while ((count = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+        _data.insert(_data.end(), chunk, chunk + count);
+    std::fclose(file);
+
+    char magic[sizeof(stream_magic)];
+    uint32_t size = 0;
+    _good = _get(magic) && std::memcmp(magic, stream_magic, sizeof(magic)) == 0 && _get(size) && _get(_name, size);
+}
+
+inline bool stream_reader_t::next(message_t& msg)
+{
+    if (!_good)
+        return false;
+
+    entry_kind_t kind;
+    while (_get(kind))
+    {
+        if (kind == entry_kind_t::site)
+        {
+            if (!_read_site())
+                return false;
+            continue;
+        }
+        if (kind != entry_kind_t::record)
+            return false;
+
+        uint32_t site_id = 0;
+        uint64_t thread_id = 0;
+        int64_t time = 0;
+        uint32_t size = 0;
+        if (!_get(site_id) || !_get(thread_id) || !_get(time) || !_get(size) || site_id >= _sites.size() || _data.size() - _offset < size)
+            return false;
+
+        _site = &_sites[site_id];
+        const char* args = _data.data() + _offset;
+        _offset += size;
+        if (!decode_args(args, size, _site->types.data(), _site->types.size(), _args))
+            return false;
+
+        msg.reset(&_name, _site->level);
+        msg.time = std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(time)));
+        msg.thread_id = static_cast<size_t>(thread_id);
+        msg.source = &_site->source;
+        render(msg.raw, _site->format, _args, _site->types.size());
+        return true;
+    }
+    return false;
+}
+
+inline bool stream_reader_t::_get(std::string& value, size_t size)
+{
+    if (_data.size() - _offset < size)
+        return false;
+    value.assign(_data.data() + _offset, size);
+    _offset += size;
+    return true;
+}
+
+inline bool stream_reader_t::_read_site()
+{
+    uint32_t id = 0;
+    site_t site;
+    uint8_t count = 0;
+    uint32_t format_size = 0;
+    uint32_t file_size = 0;
+    uint32_t function_size = 0;
+    if (!_get(id) || !_get(site.level) || !_get(site.line) || !_get(count) || count > max_arguments)
+        return false;
+
+    site.types.resize(count);
+    for (auto& type : site.types)
+    {
+        if (!_get(type) || type > arg_type_t::string)
+            return false;
+    }
+
+    if (!_get(format_size) || !_get(file_size) || !_get(function_size) || !_get(site.format, format_size) || !_get(site.file, file_size)
+        || !_get(site.function, function_size))
+        return false;
+
+    if (id != _sites.size())
+        return false;
+    auto& added = _sites.emplace_back(std::move(site));
+    added.source = { added.file.c_str(), static_cast<int>(added.line), added.function.c_str() };
+    return true;
+}
+} // namespace pride::log::deferred
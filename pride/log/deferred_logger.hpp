@@ -0,0 +1,172 @@
+#pragma once
+
+#include "deferred/backend.hpp"
+#include "deferred/codec.hpp"
+#include "deferred/stream.hpp"
+#include "internal/backoff.hpp"
+#include "internal/message_pool.hpp"
+#include "internal/time.hpp"
+#include "logger.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <tuple>
+
+namespace pride::log
+{
+// Logger that does not format on the calling thread. A deferred statement
+// copies its arguments in binary form, next to the address of its static call
+// site, into a ring owned by the calling thread. The backend thread formats the
+// records into the channels or, with binary_output, writes them to a file
+// that tools/log-decode turns back into text.
+//
+// Use it through PRIDE_LOG_DEFERRED, the regular log functions still work and
+// format right away.
+class deferred_logger_t : public logger_t, private deferred::sink_t
+{
+public:
+    using ptr = std::shared_ptr<deferred_logger_t>;
+
+    static ptr create(std::string name);
+
+    explicit deferred_logger_t(std::string name);
+    ~deferred_logger_t() override;
+
+    deferred_logger_t(const deferred_logger_t&) = delete;
+    deferred_logger_t& operator=(const deferred_logger_t&) = delete;
+
+    template<typename... Args>
+    void log_deferred(deferred::call_site_t& site, const char* format, const Args&... args);
+
+    // Write the records to a binary file instead of the channels. Has to be
+    // set before the first deferred record.
+    deferred_logger_t& binary_output(const std::string& filename);
+
+protected:
+    void _flush() override;
+
+private:
+    void consume(const deferred::record_header_t& header, size_t thread_id, const char* args, size_t size) override;
+
+    std::shared_ptr<deferred::backend_t> _backend;
+    std::unique_ptr<deferred::stream_writer_t> _writer;
+};
+
+// ────────────────────────────────────────────────────────────────────────────────
+
+inline deferred_logger_t::ptr deferred_logger_t::create(std::string name)
+{
+    auto instance = ptr(new deferred_logger_t(std::move(name)));
+    _register(instance);
+    return instance;
+}
+
+inline deferred_logger_t::deferred_logger_t(std::string name)
+    : logger_t(std::move(name))
+    , _backend(deferred::backend_t::instance())
+{
+}
+
+inline deferred_logger_t::~deferred_logger_t()
+{
+    // no record in a ring may point at this logger once it is gone
+    _backend->flush();
+    if (_writer)
+        _writer->flush();
+    else
+        logger_t::_flush();
+}
+
+inline deferred_logger_t& deferred_logger_t::binary_output(const std::string& filename)
+{
+    _writer = std::make_unique<deferred::stream_writer_t>(filename, name());
+    return *this;
+}
+
+// ────────────────────────────────────────────────────────────────────────────────
+
+template<typename... Args>
+void deferred_logger_t::log_deferred(deferred::call_site_t& site, const char* format, const Args&... args)
+{
+    if (!should_log(site.level))
+        return;
+
+    deferred::register_site<Args...>(site, format);
+
+    constexpr auto sequence = std::index_sequence_for<Args...>();
+    const auto values = std::make_tuple(deferred::internal::capture(args)...);
+    const auto size = sizeof(deferred::record_header_t) + deferred::internal::encoded_size(values, sequence);
+
+    auto& ring = _backend->local_ring();
+    if (size > ring.capacity() / 2)
+    {
+        _counters.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    char* out = ring.reserve(size);
+    if (out == nullptr)
+    {
+        internal::backoff_t backoff;
+        do
+        {
+            backoff.pause();
+            out = ring.reserve(size);
+        } while (out == nullptr);
+    }
+
+    deferred::record_header_t header;
+    header.size = static_cast<uint32_t>(size);
+    header.reserved = 0;
+    header.site = &site;
+    header.sink = this;
+    header.time = std::chrono::duration_cast<std::chrono::nanoseconds>(internal::now().time_since_epoch()).count();
+    std::memcpy(out, &header, sizeof(header));
+    deferred::internal::encode(out + sizeof(header), values, sequence);
+    ring.commit();
+    _backend->notify();
+}
+
+// ────────────────────────────────────────────────────────────────────────────────
+
+inline void deferred_logger_t::_flush()
+{
+    _backend->flush();
+    if (_writer)
+        _writer->flush();
+    else
+        logger_t::_flush();
+}
+
+inline void deferred_logger_t::consume(const deferred::record_header_t& header, size_t thread_id, const char* args, size_t size)
+{
+    if (_writer)
+    {
+        _writer->write(header, thread_id, args, size);
+        return;
+    }
+
+    const auto& site = *header.site;
+    deferred::decoded_arg_t decoded[deferred::max_arguments];
+    if (!deferred::decode_args(args, size, site.types, site.arg_count, decoded))
+        return;
+
+    auto message = internal::message_pool_t::acquire(&name(), site.level);
+    message->time = std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(header.time)));
+    message->thread_id = thread_id;
+    message->source = &site.source;
+    deferred::render(message->raw, site.format, decoded, site.arg_count);
+    _dispatch(*message);
+}
+} // namespace pride::log
+
+// Logs through a deferred_logger_t, the statement gets its own static call site
+#define PRIDE_LOG_DEFERRED(logger, level, ...)                                                          \
+    do                                                                                                  \
+    {                                                                                                   \
+        static ::pride::log::deferred::call_site_t pride_deferred_site{ level, __FILE__, __LINE__, __func__ }; \
+        (logger).log_deferred(pride_deferred_site, __VA_ARGS__);                                        \
+    } while (false)
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "fmt.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace pride::log
+{
+enum class field_type_t : uint8_t
+{
+    i64,
+    u64,
+    f64,
+    boolean,
+    string
+};
+
+// Key and value of a structured field as passed to a log call. It only views
+// the key and text, the record copies what it keeps.
+struct field_t
+{
+    field_t(std::string_view key, bool value)
+        : key(key)
+        , type(field_type_t::boolean)
+        , b(value)
+    {}
+
+    template<typename T, std::enable_if_t<std::is_integral_v<T> && std::is_signed_v<T>, int> = 0>
+    field_t(std::string_view key, T value)
+        : key(key)
+        , type(field_type_t::i64)
+        , i(value)
+    {}
+
+    template<typename T, std::enable_if_t<std::is_integral_v<T> && std::is_unsigned_v<T> && !std::is_same_v<T, bool>, int> = 0>
+    field_t(std::string_view key, T value)
+        : key(key)
+        , type(field_type_t::u64)
+        , u(value)
+    {}
+
+    template<typename T, std::enable_if_t<std::is_floating_point_v<T>, int> = 0>
+    field_t(std::string_view key, T value)
+        : key(key)
+        , type(field_type_t::f64)
+        , f(value)
+    {}
+
+    field_t(std::string_view key, std::string_view value)
+        : key(key)
+        , type(field_type_t::string)
+        , i(0)
+        , text(value)
+    {}
+
+    field_t(std::string_view key, const char* value)
+        : field_t(key, value ? std::string_view(value) : std::string_view())
+    {}
+
+    field_t(std::string_view key, const std::string& value)
+        : field_t(key, std::string_view(value))
+    {}
+
+    std::string_view key;
+    field_type_t type;
+    union
+    {
+        int64_t i;
+        uint64_t u;
+        double f;
+        bool b;
+    };
+    std::string_view text;
+};
+
+using fields_t = std::initializer_list<field_t>;
+
+// Fields of a record. Keys and text are copied into one buffer that keeps its
+// capacity, a recycled record stores fields without touching the heap.
+class field_list_t
+{
+public:
+    void clear()
+    {
+        _entries.clear();
+        _text.resize(0);
+    }
+
+    bool empty() const { return _entries.empty(); }
+    size_t size() const { return _entries.size(); }
+
+    void add(const field_t& field)
+    {
+        entry_t entry;
+        entry.type = field.type;
+        switch (field.type)
+        {
+        case field_type_t::i64: entry.i = field.i; break;
+        case field_type_t::u64: entry.u = field.u; break;
+        case field_type_t::f64: entry.f = field.f; break;
+        case field_type_t::boolean: entry.b = field.b; break;
+        default: break;
+        }
+        entry.key_offset = _store(field.key);
+        entry.key_size = static_cast<uint32_t>(field.key.size());
+        if (field.type == field_type_t::string)
+        {
+            entry.text_offset = _store(field.text);
+            entry.text_size = static_cast<uint32_t>(field.text.size());
+        }
+        _entries.push_back(entry);
+    }
+
+    void add(fields_t fields)
+    {
+        for (auto& field : fields)
+            add(field);
+    }
+
+    // The field at `index`, its views are valid until the list changes
+    field_t operator[](size_t index) const
+    {
+        const auto& entry = _entries[index];
+        std::string_view key(_text.data() + entry.key_offset, entry.key_size);
+        switch (entry.type)
+        {
+        case field_type_t::i64: return field_t(key, entry.i);
+        case field_type_t::u64: return field_t(key, entry.u);
+        case field_type_t::f64: return field_t(key, entry.f);
+        case field_type_t::boolean: return field_t(key, entry.b);
+        default: return field_t(key, std::string_view(_text.data() + entry.text_offset, entry.text_size));
+        }
+    }
+
+private:
+    struct entry_t
+    {
+        field_type_t type{ field_type_t::i64 };
+        uint32_t key_offset{ 0 };
+        uint32_t key_size{ 0 };
+        uint32_t text_offset{ 0 };
+        uint32_t text_size{ 0 };
+        union
+        {
+            int64_t i{ 0 };
+            uint64_t u;
+            double f;
+            bool b;
+        };
+    };
+
+    uint32_t _store(std::string_view text)
+    {
+        auto offset = static_cast<uint32_t>(_text.size());
+        _text.append(text.data(), text.data() + text.size());
+        return offset;
+    }
+
+    std::vector<entry_t> _entries;
+    fmt::basic_memory_buffer<char, 256> _text;
+};
+} // namespace pride::log
@@ -0,0 +1,419 @@
+#pragma once
+
+#include "../ct/string.hpp"
+#include "fmt.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace pride::log
+{
+namespace internal::format_string
+{
+    enum class error_t
+    {
+        none,
+        unmatched_open_brace,
+        unmatched_close_brace,
+        nested_field,
+        mixed_indexing,
+        too_many_arguments,
+    };
+
+    // A run of literal text (arg < 0) or a replacement field. Literal runs
+    // point into the user's string, fields that have a format spec point at
+    // the normalised "{:spec}" text the program keeps for fmt.
+    struct segment_t
+    {
+        size_t begin{ 0 };
+        size_t size{ 0 };
+        int arg{ -1 };
+        bool has_spec{ false };
+        bool has_precision{ false };
+        char type{ 0 };
+    };
+
+    struct layout_t
+    {
+        size_t segments{ 0 };
+        size_t text{ 0 };
+    };
+
+    template<size_t Segments, size_t Text>
+    struct program_t
+    {
+        error_t error{ error_t::none };
+        size_t count{ 0 };
+        size_t arg_count{ 0 };
+        uint64_t used_args{ 0 };
+        segment_t segments[Segments + 1]{};
+        char text[Text + 1]{};
+    };
+
+    constexpr bool is_digit(char c) { return c >= '0' && c <= '9'; }
+    constexpr bool is_align(char c) { return c == '<' || c == '>' || c == '^' || c == '='; }
+    constexpr bool is_alpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+
+    // Walks the format string once. With a null program it only measures how
+    // much room the program needs, the second pass fills it in.
+    template<typename Program>
+    constexpr layout_t parse(const ct::string& str, Program* program)
+    {
+        layout_t layout;
+        size_t next_arg = 0;
+        bool automatic = false;
+        bool manual = false;
+        uint64_t used = 0;
+        size_t arg_count = 0;
+
+        auto fail = [&](error_t error) {
+            if (program != nullptr)
+                program->error = error;
+            return layout;
+        };
+
+        auto literal = [&](size_t begin, size_t end) {
+            if (begin == end)
+                return;
+            if (program != nullptr)
+            {
+                auto& segment = program->segments[layout.segments];
+                segment.begin = begin;
+                segment.size = end - begin;
+            }
+            ++layout.segments;
+        };
+
+        const auto size = str.size;
+        const auto s = str.str;
+        size_t start = 0;
+        size_t i = 0;
+        while (i < size)
+        {
+            const char c = s[i];
+            if (c == '}')
+            {
+                if (i + 1 < size && s[i + 1] == '}')
+                {
+                    literal(start, i + 1);
+                    i += 2;
+                    start = i;
+                    continue;
+                }
+                return fail(error_t::unmatched_close_brace);
+            }
+
+            if (c != '{')
+            {
+                ++i;
+                continue;
+            }
+
+            if (i + 1 < size && s[i + 1] == '{')
+            {
+                literal(start, i + 1);
+                i += 2;
+                start = i;
+                continue;
+            }
+
+            literal(start, i);
+
+            // argument index
+            size_t j = i + 1;
+            size_t index = 0;
+            if (j < size && is_digit(s[j]))
+            {
+                manual = true;
+                while (j < size && is_digit(s[j]))
+                    index = index * 10 + static_cast<size_t>(s[j++] - '0');
+            }
+            else
+            {
+                automatic = true;
+                index = next_arg++;
+            }
+
+            if (manual && automatic)
+                return fail(error_t::mixed_indexing);
+            if (index >= 64)
+                return fail(error_t::too_many_arguments);
+
+            // format spec
+            size_t spec_begin = j;
+            size_t spec_end = j;
+            if (j < size && s[j] == ':')
+            {
+                spec_begin = ++j;
+                while (j < size && s[j] != '}')
+                {
+                    if (s[j] == '{')
+                        return fail(error_t::nested_field);
+                    ++j;
+                }
+                spec_end = j;
+            }
+
+            if (j >= size || s[j] != '}')
+                return fail(error_t::unmatched_open_brace);
+
+            used |= uint64_t(1) << index;
+            if (index + 1 > arg_count)
+                arg_count = index + 1;
+
+            const size_t spec_size = spec_end - spec_begin;
+            if (program != nullptr)
+            {
+                auto& segment = program->segments[layout.segments];
+                segment.arg = static_cast<int>(index);
+                segment.has_spec = spec_size != 0;
+
+                if (segment.has_spec)
+                {
+                    // "{:" spec "}" so fmt never sees the argument index
+                    segment.begin = layout.text;
+                    segment.size = spec_size + 3;
+                    program->text[layout.text] = '{';
+                    program->text[layout.text + 1] = ':';
+                    for (size_t k = 0; k < spec_size; ++k)
+                        program->text[layout.text + 2 + k] = s[spec_begin + k];
+                    program->text[layout.text + 2 + spec_size] = '}';
+
+                    // [[fill]align] may hold a '.' or a letter, skip it
+                    size_t body = spec_begin;
+                    if (spec_size >= 2 && is_align(s[body + 1]))
+                        body += 2;
+                    else if (is_align(s[body]))
+                        body += 1;
+
+                    for (size_t k = body; k < spec_end; ++k)
+                        if (s[k] == '.')
+                            segment.has_precision = true;
+
+                    const char last = s[spec_end - 1];
+                    if (body < spec_end && (is_alpha(last) || last == '%'))
+                        segment.type = last;
+                }
+            }
+
+            if (spec_size != 0)
+                layout.text += spec_size + 3;
+            ++layout.segments;
+
+            i = j + 1;
+            start = i;
+        }
+        literal(start, size);
+
+        if (program != nullptr)
+        {
+            program->count = layout.segments;
+            program->arg_count = arg_count;
+            program->used_args = used;
+        }
+        return layout;
+    }
+
+    template<size_t Segments, size_t Text>
+    constexpr program_t<Segments, Text> compile(const ct::string& str)
+    {
+        program_t<Segments, Text> program;
+        parse(str, &program);
+        return program;
+    }
+
+    constexpr layout_t measure(const ct::string& str)
+    {
+        return parse<program_t<0, 0>>(str, nullptr);
+    }
+
+    //
+    // ─── ARGUMENT TYPES ──────────────────────────────────────────────
+    //
+
+    enum class arg_kind_t
+    {
+        integer,
+        character,
+        boolean,
+        floating,
+        string,
+        pointer,
+        custom
+    };
+
+    template<typename T>
+    constexpr arg_kind_t kind_of()
+    {
+        using type = std::remove_cv_t<std::remove_reference_t<T>>;
+        if constexpr (std::is_same_v<type, bool>)
+            return arg_kind_t::boolean;
+        else if constexpr (std::is_same_v<type, char>)
+            return arg_kind_t::character;
+        else if constexpr (std::is_integral_v<type> || std::is_enum_v<type>)
+            return arg_kind_t::integer;
+        else if constexpr (std::is_floating_point_v<type>)
+            return arg_kind_t::floating;
+        else if constexpr (std::is_same_v<type, std::string> || std::is_same_v<type, std::string_view>
+            || std::is_same_v<type, fmt::string_view> || std::is_same_v<std::decay_t<type>, const char*>
+            || std::is_same_v<std::decay_t<type>, char*>)
+            return arg_kind_t::string;
+        else if constexpr (std::is_pointer_v<type> || std::is_null_pointer_v<type>)
+            return arg_kind_t::pointer;
+        else
+            return arg_kind_t::custom;
+    }
+
+    constexpr bool contains(const char* set, char c)
+    {
+        for (; *set != '\0'; ++set)
+            if (*set == c)
+                return true;
+        return false;
+    }
+
+    constexpr bool accepts(arg_kind_t kind, const segment_t& segment)
+    {
+        const char type = segment.type;
+        constexpr const char* integers = "dxXobBcn";
+        switch (kind)
+        {
+        case arg_kind_t::integer:
+        case arg_kind_t::character:
+        case arg_kind_t::boolean:
+            if (segment.has_precision)
+                return false;
+            return type == 0 || contains(integers, type) || (kind != arg_kind_t::integer && type == 's');
+        case arg_kind_t::floating:
+            return type == 0 || contains("eEfFgGaA%n", type);
+        case arg_kind_t::string:
+            return type == 0 || type == 's';
+        case arg_kind_t::pointer:
+            return (type == 0 || type == 'p') && !segment.has_precision;
+        case arg_kind_t::custom:
+            return true;
+        }
+        return true;
+    }
+
+    // Index of the first field whose spec does not fit its argument, -1 if all do
+    template<typename Program, typename... Args>
+    constexpr int find_type_mismatch(const Program& program)
+    {
+        constexpr arg_kind_t kinds[] = { kind_of<Args>()..., arg_kind_t::custom };
+        for (size_t i = 0; i < program.count; ++i)
+        {
+            const auto& segment = program.segments[i];
+            if (segment.arg < 0 || static_cast<size_t>(segment.arg) >= sizeof...(Args))
+                continue;
+            if (!accepts(kinds[segment.arg], segment))
+                return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    //
+    // ─── OUTPUT ──────────────────────────────────────────────────────
+    //
+
+    // Arguments without a spec skip fmt's parser entirely
+    template<size_t Size, typename T>
+    void append_arg(fmt::basic_memory_buffer<char, Size>& buffer, const T& value)
+    {
+        using type = std::remove_cv_t<std::remove_reference_t<T>>;
+        constexpr auto kind = kind_of<type>();
+        if constexpr (kind == arg_kind_t::boolean)
+            fmt::helper::append_str(value ? "true" : "false", buffer);
+        else if constexpr (kind == arg_kind_t::character)
+            buffer.push_back(value);
+        else if constexpr (kind == arg_kind_t::integer && !std::is_enum_v<type>)
+        {
+            if constexpr (sizeof(type) < sizeof(int))
+                fmt::helper::append_int(static_cast<int>(value), buffer);
+            else
+                fmt::helper::append_int(value, buffer);
+        }
+        else if constexpr (std::is_same_v<type, std::string> || std::is_same_v<type, std::string_view>
+            || std::is_same_v<type, fmt::string_view>)
+            buffer.append(value.data(), value.data() + value.size());
+        else if constexpr (kind == arg_kind_t::string)
+            fmt::helper::append_str(static_cast<const char*>(value), buffer);
+        else
+            fmt::format_to(buffer, "{}", value);
+    }
+} // namespace internal::format_string
+
+// A format string that is parsed into literal runs and argument slots at
+// compile time. The argument count and the format spec of every field are
+// checked against the argument types when format() is instantiated, at run
+// time the output is a fixed sequence of appends. Made with PRIDE_FMT("...").
+template<typename Holder>
+struct format_string_t
+{
+    static constexpr ct::string str = Holder::value();
+    static constexpr auto layout = internal::format_string::measure(str);
+    static constexpr auto program = internal::format_string::compile<layout.segments, layout.text>(str);
+
+    constexpr const char* c_str() const { return str.str; }
+    constexpr size_t size() const { return str.size; }
+
+    template<size_t Size, typename... Args>
+    static void format(fmt::basic_memory_buffer<char, Size>& buffer, const Args&... args)
+    {
+        using internal::format_string::error_t;
+        static_assert(program.error != error_t::unmatched_open_brace, "format string: unmatched '{'");
+        static_assert(program.error != error_t::unmatched_close_brace, "format string: unmatched '}', use '}}' for a literal brace");
+        static_assert(program.error != error_t::nested_field, "format string: nested replacement fields are not supported");
+        static_assert(program.error != error_t::mixed_indexing, "format string: cannot mix automatic and manual argument indexing");
+        static_assert(program.error != error_t::too_many_arguments, "format string: at most 64 arguments are supported");
+        static_assert(program.arg_count <= sizeof...(Args), "format string: not enough arguments for the replacement fields");
+        static_assert(program.arg_count >= sizeof...(Args), "format string: more arguments than replacement fields");
+        static_assert(program.arg_count == 0 || program.used_args == (~uint64_t(0) >> (64 - program.arg_count)), "format string: an argument is never used");
+        static_assert(internal::format_string::find_type_mismatch<decltype(program), Args...>(program) < 0, "format string: format spec does not match the argument type");
+
+        emit(buffer, std::make_index_sequence<program.count>(), std::forward_as_tuple(args...));
+    }
+
+private:
+    template<size_t Size, size_t... I, typename Tuple>
+    static void emit(fmt::basic_memory_buffer<char, Size>& buffer, std::index_sequence<I...>, const Tuple& args)
+    {
+        (emit_segment<I>(buffer, args), ...);
+    }
+
+    template<size_t I, size_t Size, typename Tuple>
+    static void emit_segment(fmt::basic_memory_buffer<char, Size>& buffer, const Tuple& args)
+    {
+        constexpr auto segment = program.segments[I];
+        if constexpr (segment.arg < 0)
+            buffer.append(str.str + segment.begin, str.str + segment.begin + segment.size);
+        else if constexpr (!segment.has_spec)
+            internal::format_string::append_arg(buffer, std::get<static_cast<size_t>(segment.arg)>(args));
+        else
+            fmt::format_to(buffer, fmt::string_view(program.text + segment.begin, segment.size), std::get<static_cast<size_t>(segment.arg)>(args));
+    }
+};
+
+template<typename T>
+struct is_format_string : std::false_type
+{};
+
+template<typename Holder>
+struct is_format_string<format_string_t<Holder>> : std::true_type
+{};
+} // namespace pride::log
+
+// Turns a string literal into a pride::log::format_string_t, the literal has to
+// be visible to the compiler so it can be parsed and checked at compile time.
+#define PRIDE_FMT(literal)                                                     \
+    [] {                                                                       \
+        struct pride_format_holder                                             \
+        {                                                                      \
+            static constexpr ::pride::ct::string value() { return literal; }   \
+        };                                                                     \
+        return ::pride::log::format_string_t<pride_format_holder>{};           \
+    }()
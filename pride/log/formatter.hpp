@@ -2,15 +2,20 @@
 #pragma once
 
 #include "../config/detection/os.hpp"
+#include "../ct/string.hpp"
 #include "fmt.hpp"
 #include "internal/thread.hpp"
 #include "internal/time.hpp"
 #include "message.hpp"
+#include <array>
 #include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <ctime>
 #include <memory>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 namespace pride::log
@@ -20,6 +25,14 @@ class formatter_t
 public:
     virtual ~formatter_t() = default;
     virtual void format(const message_t& msg, fmt::memory_buffer& buffer) = 0;
+
+    // Formatters with the same non empty signature turn a record into the same
+    // text, a logger formats a record once for all the channels sharing one.
+    virtual const std::string& signature() const
+    {
+        static const std::string none;
+        return none;
+    }
 };
 
 class indent_t
@@ -53,125 +66,399 @@ private:
 
 namespace internal
 {
-    class flag_formatter_t
+    inline const char* ampm(const std::tm& t)
     {
-    public:
-        virtual ~flag_formatter_t() = default;
-        virtual void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer) = 0;
-    };
+        return t.tm_hour >= 12 ? "PM" : "AM";
+    }
+
+    inline unsigned int to12h(const std::tm& t)
+    {
+        return t.tm_hour > 12 ? t.tm_hour - 12 : t.tm_hour;
+    }
 
-    //
-    // ─── NAME AND LEVEL FORMAT ───────────────────────────────────────
-    //
+    // ±hh:mm, the offset from UTC of the local time
+    template<size_t Size>
+    inline void append_utc_offset(const std::tm& t, fmt::basic_memory_buffer<char, Size>& buffer)
+    {
+        auto minutes = utc_offset_minutes(t);
+        buffer.push_back(minutes < 0 ? '-' : '+');
+        if (minutes < 0)
+            minutes = -minutes;
+        fmt::helper::pad2(static_cast<int>(minutes / 60), buffer);
+        buffer.push_back(':');
+        fmt::helper::pad2(static_cast<int>(minutes % 60), buffer);
+    }
 
-    class name_formatter_t : public flag_formatter_t
+    inline const char* short_filename(const char* filename)
     {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
+        const char* result = filename;
+        for (auto it = filename; *it; ++it)
         {
-            fmt::helper::append_str(*msg.names, buffer);
+            if (*it == '/' || *it == '\\')
+                result = it + 1;
         }
-    };
+        return result;
+    }
+} // namespace internal
 
-    class level_formatter_t : public flag_formatter_t
-    {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
-        {
-            fmt::helper::append_str(internal::to_long_name(msg.sevarity), buffer);
-            //fmt::helper::append_str(pride::log::internal::sevarity::to_long_name(msg.sevarity), buffer);
+// A pattern is compiled once into a flat array of instructions. A record runs
+// through them with one call per instruction through a constant table indexed
+// by the op, literal text is copied straight out of the pattern. Consecutive
+// instructions whose output only changes with the second of the record sit
+// behind a cached run, rendered once a second. %+, the default pattern, is a
+// single instruction with a cache of its own.
+namespace internal::pattern
+{
+#if defined(PRIDE_OS_WINDOWS)
+    static constexpr const char* default_eol = "\r\n";
+#else
+    static constexpr const char* default_eol = "\n";
+#endif
+
+    static constexpr std::array<const char*, 7> short_days{ { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" } };
+    static constexpr std::array<const char*, 7> long_days{ { "Sunday", "Monday", "Tueday", "Wednesday", "Thursday", "Friday", "Saturday" } };
+    static constexpr const char* full_separator = "] [";
+    static constexpr std::array<const char*, 12> short_months{ { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sept", "Oct", "Nov", "Dec" } };
+
+    enum class op_t : uint8_t
+    {
+        literal,         // text of the pattern
+        name,            // %n logger name
+        level,           // %l long level name
+        short_level,     // %L short level name
+        thread_id,       // %t
+        process_id,      // %P
+        indent,          // %i
+        message,         // %v
+        source_location, // %@ src/main.cpp:42
+        source_filename, // %g src/main.cpp
+        short_filename,  // %s main.cpp
+        source_line,     // %# 42
+        source_function, // %! main
+        short_weekday,   // %a Mon
+        long_weekday,    // %A Monday
+        short_month,     // %b and %B Jun
+        date_time,       // %c Mon Jun 17 12:14:32 2018
+        year_2_digit,    // %C 18
+        year_4_digit,    // %Y 2018
+        short_date,      // %D 09/14/18
+        month,           // %m 01-12
+        day,             // %d 01-31
+        hours_24,        // %H 00-23
+        hours_12,        // %I 01-12
+        minutes,         // %M 00-59
+        seconds,         // %S 00-59
+        milliseconds,    // %e 000-999
+        microseconds,    // %f 000000-999999
+        nanoseconds,     // %F 000000000-999999999
+        epoch_seconds,   // %E seconds since epoch
+        ampm,            // %p AM or PM
+        time_12,         // %r 03:24:02 PM
+        time_24,         // %R 23:53
+        iso_8601_time,   // %T 23:53:02
+        utc_offset,      // %z +02:00
+        full_date,       // [2018-06-17 12:14:32. of %+
+        full_tail,       // 042] [info] message of %+
+        full,            // %+ as one instruction, the date cached at `begin`
+        cached_run,      // the next `size` instructions, rendered once a second
+    };
+
+    // Literals are the `size` characters at `begin` in the pattern. The flags
+    // that are not cached copy the `size` characters at `begin` first, the
+    // literal text in front of them. A cached run keeps its text in the cache
+    // at `begin`.
+    struct instruction_t
+    {
+        op_t op{ op_t::literal };
+        uint32_t begin{ 0 };
+        uint32_t size{ 0 };
+    };
+
+    // True when the output only changes with the second of the record
+    constexpr bool per_second(op_t op)
+    {
+        switch (op)
+        {
+        case op_t::literal:
+        case op_t::short_weekday:
+        case op_t::long_weekday:
+        case op_t::short_month:
+        case op_t::date_time:
+        case op_t::year_2_digit:
+        case op_t::year_4_digit:
+        case op_t::short_date:
+        case op_t::month:
+        case op_t::day:
+        case op_t::hours_24:
+        case op_t::hours_12:
+        case op_t::minutes:
+        case op_t::seconds:
+        case op_t::epoch_seconds:
+        case op_t::ampm:
+        case op_t::time_12:
+        case op_t::time_24:
+        case op_t::iso_8601_time:
+        case op_t::utc_offset:
+        case op_t::full_date:
+            return true;
+        default:
+            return false;
         }
-    };
+    }
 
-    class short_level_formatter_t : public flag_formatter_t
+    // The instruction of a flag, literal for the flags that print themselves
+    constexpr op_t flag_op(char flag)
     {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
+        switch (flag)
         {
-            fmt::helper::append_str(internal::to_short_name(msg.sevarity), buffer);
+        case 'n': return op_t::name;
+        case 'l': return op_t::level;
+        case 'L': return op_t::short_level;
+        case 't': return op_t::thread_id;
+        case 'P': return op_t::process_id;
+        case 'i': return op_t::indent;
+        case 'v': return op_t::message;
+        case '@': return op_t::source_location;
+        case 'g': return op_t::source_filename;
+        case 's': return op_t::short_filename;
+        case '#': return op_t::source_line;
+        case '!': return op_t::source_function;
+        case 'a': return op_t::short_weekday;
+        case 'A': return op_t::long_weekday;
+        case 'b': return op_t::short_month;
+        case 'B': return op_t::short_month;
+        case 'c': return op_t::date_time;
+        case 'C': return op_t::year_2_digit;
+        case 'Y': return op_t::year_4_digit;
+        case 'D': return op_t::short_date;
+        case 'm': return op_t::month;
+        case 'd': return op_t::day;
+        case 'H': return op_t::hours_24;
+        case 'I': return op_t::hours_12;
+        case 'M': return op_t::minutes;
+        case 'S': return op_t::seconds;
+        case 'e': return op_t::milliseconds;
+        case 'f': return op_t::microseconds;
+        case 'F': return op_t::nanoseconds;
+        case 'E': return op_t::epoch_seconds;
+        case 'p': return op_t::ampm;
+        case 'r': return op_t::time_12;
+        case 'R': return op_t::time_24;
+        case 'T': return op_t::iso_8601_time;
+        case 'z': return op_t::utc_offset;
+        default: return op_t::literal;
         }
-    };
+    }
 
-    class indent_formatter_t : public flag_formatter_t
+    template<size_t N>
+    struct program_t
     {
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
-        {
-            fmt::helper::append_str(indent_t::str(), buffer);
-        }
-    };
+        size_t count{ 0 };
+        size_t caches{ 0 };
+        instruction_t instructions[N + 1]{};
 
-    //
-    // ─── DATE TIME PATTERN ───────────────────────────────────────────
-    //
+        constexpr size_t size() const { return count; }
+        constexpr instruction_t& operator[](size_t i) { return instructions[i]; }
+        constexpr void push(const instruction_t& instruction) { instructions[count++] = instruction; }
+    };
 
-    static const char* ampm(const tm& t)
+    struct dynamic_program_t
     {
-        return t.tm_hour >= 12 ? "PM" : "AM";
-    }
+        std::vector<instruction_t> instructions;
+        size_t caches{ 0 };
 
-    static unsigned int to12h(const tm& t)
+        size_t size() const { return instructions.size(); }
+        instruction_t& operator[](size_t i) { return instructions[i]; }
+        void push(const instruction_t& instruction) { instructions.push_back(instruction); }
+    };
+
+    // Upper bound of the instructions a pattern compiles to: at most one per
+    // character and a cached run in front of every flag
+    constexpr size_t max_instructions(size_t size)
     {
-        return t.tm_hour > 12 ? t.tm_hour - 12 : t.tm_hour;
+        return size + size / 2 + 1;
     }
 
-    class short_weekday_formatter_t : public flag_formatter_t
+    template<typename Program>
+    constexpr void compile(const char* pattern, size_t size, Program& program)
     {
-    public:
-        static constexpr std::array<const char*, 7> days{ { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" } };
+        size_t run_start = 0;
+        size_t run_length = 0;
+        bool run_cached = false;
 
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
-        {
-            fmt::helper::append_str(days[tm_time.tm_wday], buffer);
-        }
-    };
+        auto emit = [&](op_t op, size_t begin, size_t length) {
+            const auto count = program.size();
+            if (op == op_t::literal && count > 0)
+            {
+                auto& last = program[count - 1];
+                if (last.op == op_t::literal && last.begin + last.size == begin)
+                {
+                    last.size += static_cast<uint32_t>(length);
+                    return;
+                }
+            }
 
-    class long_weekday_formatter_t : public flag_formatter_t
-    {
-    public:
-        static constexpr std::array<const char*, 7> days{ { "Sunday", "Monday", "Tueday", "Wednesday", "Thursday", "Friday", "Saturday" } };
+            if (op == op_t::full)
+            {
+                program.push(instruction_t{ op, static_cast<uint32_t>(program.caches++), 0 });
+                run_length = 0;
+                return;
+            }
+
+            if (!per_second(op))
+            {
+                // literal text that is not cached becomes the prefix of the
+                // flag after it, one instruction less to dispatch
+                if (run_length > 0 && !run_cached && program[count - 1].op == op_t::literal)
+                    program[count - 1].op = op;
+                else
+                    program.push(instruction_t{ op, 0, 0 });
+                run_length = 0;
+                return;
+            }
+
+            program.push(instruction_t{ op, static_cast<uint32_t>(begin), static_cast<uint32_t>(length) });
+
+            if (run_length == 0)
+            {
+                run_start = count;
+                run_cached = false;
+            }
+            ++run_length;
+
+            // a run of literal text is copied as fast as a cache is, a run
+            // that renders a flag is cached from its first flag on
+            if (!run_cached && op != op_t::literal)
+            {
+                program.push(instruction_t{});
+                for (auto i = program.size() - 1; i > run_start; --i)
+                    program[i] = program[i - 1];
+                program[run_start] = instruction_t{ op_t::cached_run, static_cast<uint32_t>(program.caches++), 0 };
+                run_cached = true;
+            }
+            if (run_cached)
+                program[run_start].size = static_cast<uint32_t>(run_length);
+        };
 
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
+        size_t i = 0;
+        while (i < size)
         {
-            fmt::helper::append_str(days[tm_time.tm_wday], buffer);
+            if (pattern[i] != '%')
+            {
+                auto end = i;
+                while (end < size && pattern[end] != '%')
+                    ++end;
+                emit(op_t::literal, i, end - i);
+                i = end;
+                continue;
+            }
+
+            // a '%' that ends the pattern prints nothing
+            if (i + 1 == size)
+                break;
+
+            const char flag = pattern[i + 1];
+            if (flag == '+')
+                emit(op_t::full, 0, 0);
+            else
+            {
+                auto op = flag_op(flag);
+                if (op == op_t::literal)
+                    emit(op_t::literal, i, 2);
+                else
+                    emit(op, 0, 0);
+            }
+            i += 2;
         }
-    };
+    }
 
-    class short_month_formatter_t : public flag_formatter_t
+    template<size_t N>
+    constexpr program_t<N> compile(const ct::string& pattern)
     {
-    public:
-        static constexpr std::array<const char*, 12> monhths{ { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sept", "Oct", "Nov", "Dec" } };
+        program_t<N> program;
+        compile(pattern.str, pattern.size, program);
+        return program;
+    }
 
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
-        {
-            fmt::helper::append_str(monhths[tm_time.tm_mon], buffer);
-        }
+    // Text of a cached run and the second it was rendered for
+    struct run_cache_t
+    {
+        std::chrono::seconds seconds{ std::chrono::seconds::min() };
+        fmt::memory_buffer text;
     };
 
-    class long_month_formatter_t : public flag_formatter_t
+    template<op_t Op, size_t Size>
+    inline void append(const instruction_t& instruction, const char* pattern, const message_t& msg, const std::tm& tm_time, fmt::basic_memory_buffer<char, Size>& buffer)
     {
-    public:
-        static constexpr std::array<const char*, 12> monhths{ { "January", "February", "March", "April", "May", "June", "July", "August", "September", "October", "November", "December" } };
+        using namespace std::chrono;
 
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
+        if constexpr (!per_second(Op))
         {
-            fmt::helper::append_str(monhths[tm_time.tm_mon], buffer);
+            if (instruction.size != 0)
+                buffer.append(pattern + instruction.begin, pattern + instruction.begin + instruction.size);
         }
-    };
 
-    class date_time_formatter_t : public flag_formatter_t
-    {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
+        if constexpr (Op == op_t::literal)
+            buffer.append(pattern + instruction.begin, pattern + instruction.begin + instruction.size);
+        else if constexpr (Op == op_t::name)
+            fmt::helper::append_str(*msg.names, buffer);
+        else if constexpr (Op == op_t::level)
+            fmt::helper::append_str(to_long_name(msg.sevarity), buffer);
+        else if constexpr (Op == op_t::short_level)
+            fmt::helper::append_str(to_short_name(msg.sevarity), buffer);
+        else if constexpr (Op == op_t::thread_id)
+            fmt::helper::pad6(msg.thread_id, buffer);
+        else if constexpr (Op == op_t::process_id)
+            fmt::helper::append_int(process_id(), buffer);
+        else if constexpr (Op == op_t::indent)
+        {
+            for (auto n = indent_t::multiplier() * indent_t::level(); n > 0; --n)
+                buffer.push_back(indent_t::character());
+        }
+        else if constexpr (Op == op_t::message)
+            fmt::helper::append_buffer(msg.raw, buffer);
+        else if constexpr (Op == op_t::source_location)
+        {
+            if (!msg.source)
+                return;
+            fmt::helper::append_str(msg.source->file, buffer);
+            buffer.push_back(':');
+            fmt::helper::append_int(msg.source->line, buffer);
+        }
+        else if constexpr (Op == op_t::source_filename)
+        {
+            if (msg.source)
+                fmt::helper::append_str(msg.source->file, buffer);
+        }
+        else if constexpr (Op == op_t::short_filename)
+        {
+            if (msg.source)
+                fmt::helper::append_str(internal::short_filename(msg.source->file), buffer);
+        }
+        else if constexpr (Op == op_t::source_line)
+        {
+            if (msg.source)
+                fmt::helper::append_int(msg.source->line, buffer);
+        }
+        else if constexpr (Op == op_t::source_function)
+        {
+            if (msg.source)
+                fmt::helper::append_str(msg.source->function, buffer);
+        }
+        else if constexpr (Op == op_t::short_weekday)
+            fmt::helper::append_str(short_days[tm_time.tm_wday], buffer);
+        else if constexpr (Op == op_t::long_weekday)
+            fmt::helper::append_str(long_days[tm_time.tm_wday], buffer);
+        else if constexpr (Op == op_t::short_month)
+            fmt::helper::append_str(short_months[tm_time.tm_mon], buffer);
+        else if constexpr (Op == op_t::date_time)
         {
-            // Date
-            fmt::helper::append_str(short_weekday_formatter_t::days[tm_time.tm_wday], buffer);
+            fmt::helper::append_str(short_days[tm_time.tm_wday], buffer);
             buffer.push_back(' ');
-            fmt::helper::append_str(short_month_formatter_t::monhths[tm_time.tm_mon], buffer);
+            fmt::helper::append_str(short_months[tm_time.tm_mon], buffer);
             buffer.push_back(' ');
             fmt::helper::append_int(tm_time.tm_mday, buffer);
             buffer.push_back(' ');
-
-            // Time
             fmt::helper::pad2(tm_time.tm_hour, buffer);
             buffer.push_back(':');
             fmt::helper::pad2(tm_time.tm_min, buffer);
@@ -180,31 +467,11 @@ namespace internal
             buffer.push_back(' ');
             fmt::helper::append_int(tm_time.tm_year + 1900, buffer);
         }
-    };
-
-    class year_2_digit_formatter_t : public flag_formatter_t
-    {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
-        {
+        else if constexpr (Op == op_t::year_2_digit)
             fmt::helper::pad2(tm_time.tm_year % 100, buffer);
-        }
-    };
-
-    class year_4_digit_formatter_t : public flag_formatter_t
-    {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
-        {
+        else if constexpr (Op == op_t::year_4_digit)
             fmt::helper::append_int(tm_time.tm_year + 1900, buffer);
-        }
-    };
-
-    // Short MM/DD/YY date, equivalent to %m/%d/%y 08/23/01
-    class short_date_formatter_t : public flag_formatter_t
-    {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
+        else if constexpr (Op == op_t::short_date)
         {
             fmt::helper::pad2(tm_time.tm_mon + 1, buffer);
             buffer.push_back('/');
@@ -212,131 +479,39 @@ namespace internal
             buffer.push_back('/');
             fmt::helper::pad2(tm_time.tm_year % 100, buffer);
         }
-    };
-
-    class number_month_formatter_t : public flag_formatter_t
-    {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
-        {
+        else if constexpr (Op == op_t::month)
             fmt::helper::pad2(tm_time.tm_mon + 1, buffer);
-        }
-    };
-
-    class number_day_formatter_t : public flag_formatter_t
-    {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
-        {
+        else if constexpr (Op == op_t::day)
             fmt::helper::pad2(tm_time.tm_mday, buffer);
-        }
-    };
-
-    class military_time_hours_formatter_t : public flag_formatter_t
-    {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
-        {
+        else if constexpr (Op == op_t::hours_24)
             fmt::helper::pad2(tm_time.tm_hour, buffer);
-        }
-    };
-
-    class twelve_hour_formatter_t : public flag_formatter_t
-    {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
-        {
+        else if constexpr (Op == op_t::hours_12)
             fmt::helper::pad2(to12h(tm_time), buffer);
-        }
-    };
-
-    class minute_formatter_t : public flag_formatter_t
-    {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
-        {
+        else if constexpr (Op == op_t::minutes)
             fmt::helper::pad2(tm_time.tm_min, buffer);
-        }
-    };
-
-    class second_formatter_t : public flag_formatter_t
-    {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
-        {
+        else if constexpr (Op == op_t::seconds)
             fmt::helper::pad2(tm_time.tm_sec, buffer);
-        }
-    };
-
-    class milisecond_formatter_t : public flag_formatter_t
-    {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
+        else if constexpr (Op == op_t::milliseconds)
         {
-            auto duration = msg.time.time_since_epoch();
-            auto milisec = std::chrono::duration_cast<std::chrono::milliseconds>(duration).count() % 1000;
+            auto milisec = duration_cast<std::chrono::milliseconds>(msg.time.time_since_epoch()).count() % 1000;
             fmt::helper::pad3(static_cast<int>(milisec), buffer);
         }
-    };
-
-    class microsecond_formatter_t : public flag_formatter_t
-    {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
-        {
-            auto duration = msg.time.time_since_epoch();
-            auto microsec = std::chrono::duration_cast<std::chrono::microseconds>(duration).count() % 1000000;
-            fmt::helper::pad3(static_cast<int>(microsec), buffer);
-        }
-    };
-
-    class nanosecond_formatter_t : public flag_formatter_t
-    {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
-        {
-            auto duration = msg.time.time_since_epoch();
-            auto microsec = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() % 1000000000;
-            fmt::helper::pad3(static_cast<int>(microsec), buffer);
-        }
-    };
-
-    class seconds_since_epoch_formatter_t : public flag_formatter_t
-    {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
+        else if constexpr (Op == op_t::microseconds)
         {
-            auto duration = msg.time.time_since_epoch();
-            auto seconds = std::chrono::duration_cast<std::chrono::seconds>(duration).count();
-            fmt::helper::append_int(seconds, buffer);
+            auto microsec = duration_cast<std::chrono::microseconds>(msg.time.time_since_epoch()).count() % 1000000;
+            fmt::helper::pad6(static_cast<size_t>(microsec), buffer);
         }
-    };
-
-    class ampm_formatter_t : public flag_formatter_t
-    {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
+        else if constexpr (Op == op_t::nanoseconds)
         {
-            fmt::helper::append_str(ampm(tm_time), buffer);
+            auto nanosec = duration_cast<std::chrono::nanoseconds>(msg.time.time_since_epoch()).count() % 1000000000;
+            fmt::helper::pad3(static_cast<int>(nanosec / 1000000), buffer);
+            fmt::helper::pad6(static_cast<size_t>(nanosec % 1000000), buffer);
         }
-    };
-
-    class twenty_four_hour_time_formatter_t : public flag_formatter_t
-    {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
-        {
-            fmt::helper::pad2(tm_time.tm_hour, buffer);
-            buffer.push_back(':');
-            fmt::helper::pad2(tm_time.tm_min, buffer);
-            fmt::helper::append_str(ampm(tm_time), buffer);
-        }
-    };
-
-    class twelve_hour_time_formatter_t : public flag_formatter_t
-    {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
+        else if constexpr (Op == op_t::epoch_seconds)
+            fmt::helper::append_int(duration_cast<std::chrono::seconds>(msg.time.time_since_epoch()).count(), buffer);
+        else if constexpr (Op == op_t::ampm)
+            fmt::helper::append_str(internal::ampm(tm_time), buffer);
+        else if constexpr (Op == op_t::time_12)
         {
             fmt::helper::pad2(to12h(tm_time), buffer);
             buffer.push_back(':');
@@ -344,169 +519,166 @@ namespace internal
             buffer.push_back(':');
             fmt::helper::pad2(tm_time.tm_sec, buffer);
             buffer.push_back(' ');
-            fmt::helper::append_str(ampm(tm_time), buffer);
+            fmt::helper::append_str(internal::ampm(tm_time), buffer);
         }
-    };
-
-    class iso_8601_time_formatter_t : public flag_formatter_t
-    {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
+        else if constexpr (Op == op_t::time_24)
         {
             fmt::helper::pad2(tm_time.tm_hour, buffer);
             buffer.push_back(':');
             fmt::helper::pad2(tm_time.tm_min, buffer);
-            buffer.push_back(':');
-            fmt::helper::pad2(tm_time.tm_sec, buffer);
+            fmt::helper::append_str(internal::ampm(tm_time), buffer);
         }
-    };
-
-    class iso_8601_time_from_utc_formatter_t : public flag_formatter_t
-    {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
+        else if constexpr (Op == op_t::iso_8601_time)
         {
-            // @Todo:
-        }
-    };
-
-    //
-    // ─── THREAD AND PROECSS ──────────────────────────────────────────
-    //
-
-    class thread_id_formatter_t : public flag_formatter_t
-    {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
-        {
-            fmt::helper::pad6(msg.thread_id, buffer);
-        }
-    };
-
-    class pid_formatter_t : public flag_formatter_t
-    {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
-        {
-            // @Todo:
+            fmt::helper::pad2(tm_time.tm_hour, buffer);
+            buffer.push_back(':');
+            fmt::helper::pad2(tm_time.tm_min, buffer);
+            buffer.push_back(':');
+            fmt::helper::pad2(tm_time.tm_sec, buffer);
         }
-    };
-
-    //
-    // ─── RAW MESSAGE ─────────────────────────────────────────────────
-    //
-
-    class message_formatter_t : public flag_formatter_t
-    {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
+        else if constexpr (Op == op_t::utc_offset)
+            internal::append_utc_offset(tm_time, buffer);
+        else if constexpr (Op == op_t::full_date)
         {
+            buffer.push_back('[');
+            fmt::helper::append_int(tm_time.tm_year + 1900, buffer);
+            buffer.push_back('-');
+            fmt::helper::pad2(tm_time.tm_mon + 1, buffer);
+            buffer.push_back('-');
+            fmt::helper::append_int(tm_time.tm_mday, buffer);
+            buffer.push_back(' ');
+            fmt::helper::append_int(tm_time.tm_hour, buffer);
+            buffer.push_back(':');
+            fmt::helper::append_int(tm_time.tm_min, buffer);
+            buffer.push_back(':');
+            fmt::helper::append_int(tm_time.tm_sec, buffer);
+            buffer.push_back('.');
+        }
+        else if constexpr (Op == op_t::full_tail)
+        {
+            // always three digits, written without going through format_int
+            auto milisec = static_cast<unsigned>(duration_cast<std::chrono::milliseconds>(msg.time.time_since_epoch()).count() % 1000);
+            const char digits[3] = { static_cast<char>('0' + milisec / 100), static_cast<char>('0' + milisec / 10 % 10), static_cast<char>('0' + milisec % 10) };
+            buffer.append(digits, digits + 3);
+            buffer.append(full_separator, full_separator + 3);
+            fmt::helper::append_str(to_long_name(msg.sevarity), buffer);
+            buffer.append(full_separator, full_separator + 2);
             fmt::helper::append_buffer(msg.raw, buffer);
         }
-    };
-
-    class single_char_formatter_t : public flag_formatter_t
-    {
-    public:
-        explicit single_char_formatter_t(char ch)
-            : _ch(ch)
-        {}
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
-        {
-            buffer.push_back(_ch);
-        }
-
-    private:
-        char _ch;
-    };
+    }
 
-    class aggregate_formatter_t : public flag_formatter_t
+    // %+: the date part is rendered into `cache` once a second
+    template<size_t Size>
+    inline void append_full(const instruction_t& instruction, const char* pattern, const message_t& msg, const std::tm& tm_time, std::chrono::seconds seconds, run_cache_t& cache, fmt::basic_memory_buffer<char, Size>& buffer)
     {
-    public:
-        aggregate_formatter_t() = default;
-
-        void add_ch(char ch)
-        {
-            _str += ch;
-        }
-
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
+        if (cache.seconds != seconds)
         {
-            fmt::helper::append_str(_str, buffer);
+            cache.text.resize(0);
+            append<op_t::full_date>(instruction, pattern, msg, tm_time, cache.text);
+            cache.seconds = seconds;
         }
+        fmt::helper::append_buffer(cache.text, buffer);
+        append<op_t::full_tail>(instruction, pattern, msg, tm_time, buffer);
+    }
 
-    private:
-        std::string _str;
-    };
-
-    class full_formatter_t : public flag_formatter_t
-    {
-    public:
-        void format(const message_t& msg, const std::tm& tm_time, fmt::memory_buffer& buffer)
-        {
-            auto duration = msg.time.time_since_epoch();
-            std::chrono::seconds seconds = std::chrono::duration_cast<std::chrono::seconds>(duration);
-
-            if (_cache_timestamp != seconds || _cached_datetime.size() == 0)
+    template<size_t Size>
+    using append_t = void (*)(const instruction_t&, const char*, const message_t&, const std::tm&, fmt::basic_memory_buffer<char, Size>&);
+
+    // The append of every op, in the order of op_t. %+ and cached runs are
+    // left to run(), they need the caches of the formatter.
+    template<size_t Size>
+    inline constexpr append_t<Size> appends[] = {
+        &append<op_t::literal, Size>,
+        &append<op_t::name, Size>,
+        &append<op_t::level, Size>,
+        &append<op_t::short_level, Size>,
+        &append<op_t::thread_id, Size>,
+        &append<op_t::process_id, Size>,
+        &append<op_t::indent, Size>,
+        &append<op_t::message, Size>,
+        &append<op_t::source_location, Size>,
+        &append<op_t::source_filename, Size>,
+        &append<op_t::short_filename, Size>,
+        &append<op_t::source_line, Size>,
+        &append<op_t::source_function, Size>,
+        &append<op_t::short_weekday, Size>,
+        &append<op_t::long_weekday, Size>,
+        &append<op_t::short_month, Size>,
+        &append<op_t::date_time, Size>,
+        &append<op_t::year_2_digit, Size>,
+        &append<op_t::year_4_digit, Size>,
+        &append<op_t::short_date, Size>,
+        &append<op_t::month, Size>,
+        &append<op_t::day, Size>,
+        &append<op_t::hours_24, Size>,
+        &append<op_t::hours_12, Size>,
+        &append<op_t::minutes, Size>,
+        &append<op_t::seconds, Size>,
+        &append<op_t::milliseconds, Size>,
+        &append<op_t::microseconds, Size>,
+        &append<op_t::nanoseconds, Size>,
+        &append<op_t::epoch_seconds, Size>,
+        &append<op_t::ampm, Size>,
+        &append<op_t::time_12, Size>,
+        &append<op_t::time_24, Size>,
+        &append<op_t::iso_8601_time, Size>,
+        &append<op_t::utc_offset, Size>,
+        &append<op_t::full_date, Size>,
+        &append<op_t::full_tail, Size>,
+        nullptr,
+        nullptr,
+    };
+    static_assert(sizeof(appends<1>) / sizeof(appends<1>[0]) == static_cast<size_t>(op_t::cached_run) + 1, "an op has no append");
+
+    // Runs the instructions in [it, end). A cached run is rendered into its
+    // cache when the record is from another second than the cached text.
+    template<size_t Size>
+    inline void run(const instruction_t* it, const instruction_t* end, const char* pattern, const message_t& msg, const std::tm& tm_time, run_cache_t* caches, fmt::basic_memory_buffer<char, Size>& buffer)
+    {
+        for (; it != end; ++it)
+        {
+            if (it->op < op_t::full)
             {
-                _cached_datetime.resize(0);
-                _cached_datetime.push_back('[');
-                fmt::helper::append_int(tm_time.tm_year + 1900, _cached_datetime);
-                _cached_datetime.push_back('-');
-
-                fmt::helper::pad2(tm_time.tm_mon + 1, _cached_datetime);
-                _cached_datetime.push_back('-');
-
-                fmt::helper::append_int(tm_time.tm_mday, _cached_datetime);
-                _cached_datetime.push_back(' ');
-
-                fmt::helper::append_int(tm_time.tm_hour, _cached_datetime);
-                _cached_datetime.push_back(':');
-
-                fmt::helper::append_int(tm_time.tm_min, _cached_datetime);
-                _cached_datetime.push_back(':');
-
-                fmt::helper::append_int(tm_time.tm_sec, _cached_datetime);
-                _cached_datetime.push_back('.');
-
-                _cache_timestamp = seconds;
+                appends<Size>[static_cast<size_t>(it->op)](*it, pattern, msg, tm_time, buffer);
+                continue;
             }
-            fmt::helper::append_buffer(_cached_datetime, buffer);
 
-            auto milisec = std::chrono::duration_cast<std::chrono::milliseconds>(duration).count() % 1000;
-            if (milisec != _milisec_cache_timestamp || _cached_miliseconds.size() == 0)
+            auto& cache = caches[it->begin];
+            auto seconds = std::chrono::duration_cast<std::chrono::seconds>(msg.time.time_since_epoch());
+            if (it->op == op_t::full)
             {
-                _cached_miliseconds.resize(0);
-                fmt::helper::pad3(static_cast<int>(milisec), _cached_miliseconds);
-                _cached_miliseconds.push_back(']');
-                _cached_miliseconds.push_back(' ');
-                _milisec_cache_timestamp = milisec;
+                append_full(*it, pattern, msg, tm_time, seconds, cache, buffer);
+                continue;
             }
-            fmt::helper::append_buffer(_cached_miliseconds, buffer);
 
-            buffer.push_back('[');
-            fmt::helper::append_str(internal::to_long_name(msg.sevarity), buffer);
-            buffer.push_back(']');
-            buffer.push_back(' ');
-            fmt::helper::append_buffer(msg.raw, buffer);
+            if (cache.seconds != seconds)
+            {
+                cache.text.resize(0);
+                run(it + 1, it + 1 + it->size, pattern, msg, tm_time, caches, cache.text);
+                cache.seconds = seconds;
+            }
+            fmt::helper::append_buffer(cache.text, buffer);
+            it += it->size;
         }
+    }
 
-    private:
-        std::chrono::seconds _cache_timestamp{ 0 };
-        std::chrono::milliseconds::rep _milisec_cache_timestamp{ 0 };
-        fmt::basic_memory_buffer<char, 128> _cached_datetime;
-        fmt::basic_memory_buffer<char, 8> _cached_miliseconds;
-    };
-} // namespace internal
+    inline std::tm local_time(const message_t& msg)
+    {
+        return internal::local_time(std::chrono::system_clock::to_time_t(msg.time));
+    }
+} // namespace internal::pattern
 
 class pattern_formatter_t : public formatter_t
 {
 public:
-    explicit pattern_formatter_t(const std::string& pattern, std::string eol = _defualt_eol)
-        : _eol(std::move(eol))
+    explicit pattern_formatter_t(const std::string& pattern, std::string eol = internal::pattern::default_eol)
+        : _pattern(pattern)
+        , _eol(std::move(eol))
+        , _signature(pattern + '\0' + _eol)
     {
         std::memset(&_cached_tm, 0, sizeof(_cached_tm));
-        compile_pattern(pattern);
+        internal::pattern::compile(_pattern.data(), _pattern.size(), _program);
+        _caches.resize(_program.caches);
     }
     pattern_formatter_t(const pattern_formatter_t&) = delete;
     pattern_formatter_t& operator=(const pattern_formatter_t&) = delete;
@@ -516,171 +688,121 @@ public:
         auto seconds = std::chrono::duration_cast<std::chrono::seconds>(msg.time.time_since_epoch());
         if (seconds != _last_log_seconds)
         {
-            _cached_tm = get_time(msg);
+            _cached_tm = internal::pattern::local_time(msg);
             _last_log_seconds = seconds;
         }
 
-        for (auto& f : _formatters)
-            f->format(msg, _cached_tm, buffer);
-
+        const auto& program = _program.instructions;
+        internal::pattern::run(program.data(), program.data() + program.size(), _pattern.data(), msg, _cached_tm, _caches.data(), buffer);
         fmt::helper::append_str(_eol, buffer);
     }
 
+    const std::string& signature() const override { return _signature; }
+
 private:
-    void handle_flag(char flag)
+    const std::string _pattern;
+    const std::string _eol;
+    const std::string _signature;
+    std::tm _cached_tm;
+    std::chrono::seconds _last_log_seconds{ std::chrono::seconds::min() };
+    internal::pattern::dynamic_program_t _program;
+    std::vector<internal::pattern::run_cache_t> _caches;
+};
+
+// A pattern known at compile time, made with PRIDE_PATTERN("...")
+template<typename Holder>
+struct pattern_string_t
+{
+    static constexpr ct::string str = Holder::value();
+};
+
+// Formats like pattern_formatter_t but the pattern is compiled at compile
+// time. Every instruction is a template argument, a record goes through
+// straight line code with no dispatch at all.
+template<typename Holder>
+class static_pattern_formatter_t : public formatter_t
+{
+public:
+    explicit static_pattern_formatter_t(pattern_string_t<Holder>, std::string eol = internal::pattern::default_eol)
+        : _eol(std::move(eol))
+        , _signature(std::string(str.str, str.size) + '\0' + _eol)
     {
-        switch (flag)
+        std::memset(&_cached_tm, 0, sizeof(_cached_tm));
+    }
+    static_pattern_formatter_t(const static_pattern_formatter_t&) = delete;
+    static_pattern_formatter_t& operator=(const static_pattern_formatter_t&) = delete;
+
+    void format(const message_t& msg, fmt::memory_buffer& buffer) override
+    {
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(msg.time.time_since_epoch());
+        if (seconds != _last_log_seconds)
         {
-        case 'n': // logger name
-            _formatters.emplace_back(new internal::name_formatter_t());
-            break;
-        case 'l': // long level name
-            _formatters.emplace_back(new internal::level_formatter_t());
-            break;
-        case 'L': // short level name
-            _formatters.emplace_back(new internal::short_level_formatter_t());
-            break;
-        case 't': // thread id
-            _formatters.emplace_back(new internal::thread_id_formatter_t());
-            break;
-        case 'P': // process id
-            _formatters.emplace_back(new internal::pid_formatter_t());
-            break;
-        case 'i': // indent
-            _formatters.emplace_back(new internal::indent_formatter_t());
-            break;
-        // case 'i': // message counter
-        //     _formatters.emplace_back(new internal::message_counter_formatter_t()) ; break;
-        case 'v': // message
-            _formatters.emplace_back(new internal::message_formatter_t());
-            break;
-        case '+': // full decault message
-            _formatters.emplace_back(new internal::full_formatter_t());
-            break;
-
-        case 'a': // abrev weekday names
-            _formatters.emplace_back(new internal::short_weekday_formatter_t());
-            break;
-        case 'A': // full weekday names
-            _formatters.emplace_back(new internal::long_weekday_formatter_t());
-            break;
-        case 'b': // abrev month name
-            _formatters.emplace_back(new internal::short_month_formatter_t());
-            break;
-        case 'B': // full month name
-            _formatters.emplace_back(new internal::short_month_formatter_t());
-            break;
-
-        case 'c': // date and time (Mon Jun 17 12:14:32 2018)
-            _formatters.emplace_back(new internal::date_time_formatter_t());
-            break;
-        case 'C': // year in 2 digits (18)
-            _formatters.emplace_back(new internal::year_2_digit_formatter_t());
-            break;
-        case 'Y': // year 4 digits (2018)
-            _formatters.emplace_back(new internal::year_4_digit_formatter_t());
-            break;
-        case 'D': // short date MM/DD/YY date eq %m/%d/%y 09/14/18
-            _formatters.emplace_back(new internal::short_date_formatter_t());
-            break;
-        case 'm': // month in number 1-12
-            _formatters.emplace_back(new internal::number_month_formatter_t());
-            break;
-        case 'd': // day in number 1-31
-            _formatters.emplace_back(new internal::number_day_formatter_t());
-            break;
-
-        case 'H': // hours in 24 hour format 1-24
-            _formatters.emplace_back(new internal::military_time_hours_formatter_t());
-            break;
-        case 'I': // hours in a 12 hour format 1-12
-            _formatters.emplace_back(new internal::twelve_hour_formatter_t());
-            break;
-        case 'M': // minutes 0-59
-            _formatters.emplace_back(new internal::minute_formatter_t());
-            break;
-        case 'S': // seconds 0-59
-            _formatters.emplace_back(new internal::second_formatter_t());
-            break;
-        case 'e': // miliseconds 000 - 999
-            _formatters.emplace_back(new internal::milisecond_formatter_t());
-            break;
-        case 'f': // microseconds 000000 - 999999
-            _formatters.emplace_back(new internal::microsecond_formatter_t());
-            break;
-        case 'F': // nanoseconds 000000 - 999999
-            _formatters.emplace_back(new internal::nanosecond_formatter_t());
-            break;
-        case 'E': // seconds since epoch
-            _formatters.emplace_back(new internal::seconds_since_epoch_formatter_t());
-            break;
-
-        case 'p': // seconds since epoch
-            _formatters.emplace_back(new internal::ampm_formatter_t());
-            break;
-        case 'r': // 12 hour clock 03:24:02 am
-            _formatters.emplace_back(new internal::twelve_hour_time_formatter_t());
-            break;
-        case 'R': // 24 hour clock 23:53 eq %H:%M
-            _formatters.emplace_back(new internal::twenty_four_hour_time_formatter_t());
-            break;
-        case 'T': // iso 8601 time format (HH:MM:SS) eq %H:%M:%S
-            _formatters.emplace_back(new internal::iso_8601_time_formatter_t());
-            break;
-        case 'z': // iso 8601 offset from UTC in time zone
-            _formatters.emplace_back(new internal::iso_8601_time_from_utc_formatter_t());
-            break;
+            _cached_tm = internal::pattern::local_time(msg);
+            _last_log_seconds = seconds;
+        }
 
-        default:
-            _formatters.emplace_back(new internal::single_char_formatter_t('%'));
-            _formatters.emplace_back(new internal::single_char_formatter_t(flag));
-            break;
-        };
+        emit<0>(msg, seconds, buffer);
+        fmt::helper::append_str(_eol, buffer);
     }
 
-    void compile_pattern(const std::string pattern)
+    const std::string& signature() const override { return _signature; }
+
+private:
+    static constexpr ct::string str = Holder::value();
+    static constexpr auto program = internal::pattern::compile<internal::pattern::max_instructions(str.size)>(str);
+
+    template<size_t I>
+    void emit(const message_t& msg, std::chrono::seconds seconds, fmt::memory_buffer& buffer)
     {
-        auto end = pattern.end();
-        std::unique_ptr<internal::aggregate_formatter_t> user_chars;
-        for (auto it = pattern.begin(); it != end; ++it)
+        if constexpr (I < program.count)
         {
-            if (*it == '%')
+            constexpr auto instruction = program.instructions[I];
+            if constexpr (instruction.op == internal::pattern::op_t::cached_run)
             {
-                if (user_chars)
-                    _formatters.push_back(std::move(user_chars));
-
-                if (++it != end)
-                    handle_flag(*it);
-                else
-                    break;
+                auto& cache = _caches[instruction.begin];
+                if (cache.seconds != seconds)
+                {
+                    cache.text.resize(0);
+                    emit_run<I + 1>(msg, cache.text, std::make_index_sequence<instruction.size>());
+                    cache.seconds = seconds;
+                }
+                fmt::helper::append_buffer(cache.text, buffer);
+                emit<I + 1 + instruction.size>(msg, seconds, buffer);
+            }
+            else if constexpr (instruction.op == internal::pattern::op_t::full)
+            {
+                internal::pattern::append_full(program.instructions[I], str.str, msg, _cached_tm, seconds, _caches[instruction.begin], buffer);
+                emit<I + 1>(msg, seconds, buffer);
             }
             else
             {
-                if (!user_chars)
-                    user_chars = std::unique_ptr<internal::aggregate_formatter_t>(new internal::aggregate_formatter_t());
-                user_chars->add_ch(*it);
+                internal::pattern::append<instruction.op>(program.instructions[I], str.str, msg, _cached_tm, buffer);
+                emit<I + 1>(msg, seconds, buffer);
             }
         }
-
-        if (user_chars)
-            _formatters.push_back(std::move(user_chars));
     }
 
-    std::tm get_time(const message_t& msg)
+    template<size_t Begin, size_t... K>
+    void emit_run(const message_t& msg, fmt::memory_buffer& text, std::index_sequence<K...>)
     {
-        return internal::local_time(std::chrono::system_clock::to_time_t(msg.time));
-        //return internal::local_time(std::chrono::system_clock::to_time_t(msg.time));
+        (internal::pattern::append<program.instructions[Begin + K].op>(program.instructions[Begin + K], str.str, msg, _cached_tm, text), ...);
     }
 
-#if defined(PRIDE_OS_WINDOWS)
-    static constexpr const char* _defualt_eol = "\r\n";
-#else
-    static constexpr const char* _defualt_eol = "\n";
-#endif
-
     const std::string _eol;
+    const std::string _signature;
     std::tm _cached_tm;
-    std::chrono::seconds _last_log_seconds;
-    std::vector<std::unique_ptr<internal::flag_formatter_t>> _formatters;
+    std::chrono::seconds _last_log_seconds{ std::chrono::seconds::min() };
+    std::array<internal::pattern::run_cache_t, program.caches> _caches;
 };
 } // namespace pride::log
+
+// Turns a string literal into a pride::log::pattern_string_t, compiled into a
+// static_pattern_formatter_t by channel_t::pattern and logger_t::set_pattern
+#define PRIDE_PATTERN(literal)                                                 \
+    [] {                                                                       \
+        struct pride_pattern_holder                                            \
+        {                                                                      \
+            static constexpr ::pride::ct::string value() { return literal; }   \
+        };                                                                     \
+        return ::pride::log::pattern_string_t<pride_pattern_holder>{};         \
+    }()
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "../../config/detection/compiler.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#if defined(PRIDE_COMPILER_MSVC)
+#    include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#    include <immintrin.h>
+#endif
+
+namespace pride::log::internal
+{
+inline void cpu_relax()
+{
+#if defined(PRIDE_COMPILER_MSVC) || defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+// Where an idle consumer sleeps until a producer has something for it.
+// Producers call notify() after every push, which is a fence and a load
+// unless a consumer is parked. The consumer counts itself as parked before
+// it checks for work, and the producer publishes before it looks for parked
+// consumers, so one of them always sees the other.
+class parker_t
+{
+public:
+    // Sleeps until notify() unless ready() is true once the consumer is
+    // counted as parked
+    template<typename Ready>
+    void park(Ready&& ready)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _parked.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        _wake.wait(lock, ready);
+        _parked.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void notify()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_parked.load(std::memory_order_relaxed) == 0)
+            return;
+
+        // a consumer between its check and its wait holds the mutex
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+        }
+        _wake.notify_all();
+    }
+
+private:
+    std::atomic<uint32_t> _parked{ 0 };
+    std::mutex _mutex;
+    std::condition_variable _wake;
+};
+
+// Spin, then yield, then sleep. Used by the lock free queues so that an idle
+// consumer does not burn a core. A consumer with a parker_t parks on it
+// instead of sleeping, and producers only signal a parked consumer.
+class backoff_t
+{
+public:
+    void pause()
+    {
+        if (_count < spin_limit)
+        {
+            for (uint32_t i = 0; i < (1u << _count); ++i)
+                cpu_relax();
+        }
+        else if (_count < yield_limit)
+        {
+            std::this_thread::yield();
+        }
+        else
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(sleep_us));
+        }
+
+        if (_count < yield_limit)
+            ++_count;
+    }
+
+    // Like pause(), but parks on `parker` until ready() where it would sleep
+    template<typename Ready>
+    void pause(parker_t& parker, Ready&& ready)
+    {
+        if (is_sleeping())
+            parker.park(ready);
+        else
+            pause();
+    }
+
+    void reset() { _count = 0; }
+    bool is_sleeping() const { return _count >= yield_limit; }
+
+private:
+    static constexpr uint32_t spin_limit = 6;
+    static constexpr uint32_t yield_limit = 16;
+    static constexpr uint32_t sleep_us = 200;
+
+    uint32_t _count{ 0 };
+};
+} // namespace pride::log::internal
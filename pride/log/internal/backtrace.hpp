@@ -0,0 +1,183 @@
+#pragma once
+
+#include "../deferred/codec.hpp"
+#include "../fmt.hpp"
+#include "../message.hpp"
+#include "../sevarity.hpp"
+#include "message_pool.hpp"
+#include "thread.hpp"
+#include "time.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace pride::log::internal
+{
+// Ring of the last records a logger rejected, kept in the encoded form of the
+// deferred logger (format string and raw argument bytes) so storing one is a
+// copy. They are formatted only when the ring is dumped.
+//
+// Threads store into one of a few rings picked by their thread id, each with
+// a flag of its own that only a dump or a thread with the same ring contends
+// for. A dump takes every ring, merges them by time and keeps the last
+// `capacity` records. Each ring holds up to `capacity` records, allocated
+// the first time a thread stores into it.
+class backtrace_t
+{
+public:
+    static constexpr size_t ring_count = 16;
+
+    explicit backtrace_t(size_t capacity)
+        : _capacity(capacity > 0 ? capacity : 1)
+    {}
+
+    backtrace_t(const backtrace_t&) = delete;
+    backtrace_t& operator=(const backtrace_t&) = delete;
+
+    size_t capacity() const { return _capacity; }
+
+    // Records a dump would log
+    size_t size() const
+    {
+        size_t count = 0;
+        for (auto& ring : _rings)
+        {
+            ring.lock();
+            count += ring.count;
+            ring.unlock();
+        }
+        return std::min(count, _capacity);
+    }
+
+    template<typename... Args>
+    void push(sevarity_t level, const source_location_t* source, std::string_view format, const Args&... args)
+    {
+        if constexpr (sizeof...(Args) > deferred::max_arguments)
+            return;
+        else
+        {
+            // types fmt has to format are turned into text here, outside the lock
+            auto captured = std::make_tuple(deferred::internal::capture(args)...);
+            auto sequence = std::index_sequence_for<Args...>();
+            auto size = deferred::internal::encoded_size(captured, sequence);
+            auto time = internal::now();
+            auto thread = internal::thread_id();
+
+            auto& ring = _rings[_ring_of(thread)];
+            ring.lock();
+            if (ring.entries.empty())
+                ring.entries.resize(_capacity);
+
+            auto& entry = ring.entries[(ring.head + ring.count) % _capacity];
+            if (ring.count == _capacity)
+                ring.head = (ring.head + 1) % _capacity;
+            else
+                ++ring.count;
+
+            entry.level = level;
+            entry.time = time;
+            entry.thread_id = thread;
+            entry.source = source;
+            entry.types = deferred::internal::arg_types<Args...>::value;
+            entry.arg_count = static_cast<uint8_t>(sizeof...(Args));
+            entry.format_size = format.size();
+            entry.data.resize(format.size() + size);
+            std::memcpy(entry.data.data(), format.data(), format.size());
+            deferred::internal::encode(entry.data.data() + format.size(), captured, sequence);
+            ring.unlock();
+        }
+    }
+
+    // Formats the stored records oldest first and empties the rings
+    std::vector<message_ptr> drain(const std::string* names)
+    {
+        std::lock_guard<std::mutex> lock(_drain_mutex);
+        for (auto& ring : _rings)
+            ring.lock();
+
+        _order.clear();
+        for (auto& ring : _rings)
+            for (size_t i = 0; i < ring.count; ++i)
+                _order.push_back(&ring.entries[(ring.head + i) % _capacity]);
+        std::stable_sort(_order.begin(), _order.end(), [](const entry_t* a, const entry_t* b) { return a->time < b->time; });
+        auto first = _order.size() > _capacity ? _order.size() - _capacity : 0;
+
+        std::vector<message_ptr> records;
+        records.reserve(_order.size() - first);
+        deferred::decoded_arg_t decoded[deferred::max_arguments];
+        for (auto i = first; i < _order.size(); ++i)
+        {
+            const auto& entry = *_order[i];
+            const char* args = entry.data.data() + entry.format_size;
+            if (!deferred::decode_args(args, entry.data.size() - entry.format_size, entry.types, entry.arg_count, decoded))
+                continue;
+
+            auto message = message_pool_t::acquire(names, entry.level);
+            message->time = entry.time;
+            message->thread_id = entry.thread_id;
+            message->source = entry.source;
+            message->backtrace = true;
+            deferred::render(message->raw, std::string_view(entry.data.data(), entry.format_size), decoded, entry.arg_count);
+            records.push_back(std::move(message));
+        }
+
+        for (auto& ring : _rings)
+        {
+            ring.head = 0;
+            ring.count = 0;
+            ring.unlock();
+        }
+        return records;
+    }
+
+private:
+    struct entry_t
+    {
+        sevarity_t level{ sevarity_t::trace };
+        std::chrono::system_clock::time_point time;
+        size_t thread_id{ 0 };
+        const source_location_t* source{ nullptr };
+        const deferred::arg_type_t* types{ nullptr };
+        uint8_t arg_count{ 0 };
+        size_t format_size{ 0 };
+
+        // format string followed by the encoded arguments, keeps its capacity
+        fmt::basic_memory_buffer<char, 256> data;
+    };
+
+    struct alignas(64) ring_t
+    {
+        void lock() const
+        {
+            while (busy.exchange(true, std::memory_order_acquire))
+                std::this_thread::yield();
+        }
+        void unlock() const { busy.store(false, std::memory_order_release); }
+
+        mutable std::atomic<bool> busy{ false };
+        std::vector<entry_t> entries;
+        size_t head{ 0 };
+        size_t count{ 0 };
+    };
+
+    // thread ids are often aligned addresses, mix them before taking bits
+    static size_t _ring_of(size_t thread)
+    {
+        return static_cast<size_t>((static_cast<uint64_t>(thread) * 0x9E3779B97F4A7C15ull) >> 60) % ring_count;
+    }
+
+    const size_t _capacity;
+    std::array<ring_t, ring_count> _rings;
+    std::mutex _drain_mutex;
+    std::vector<const entry_t*> _order; // of a drain, under _drain_mutex
+};
+} // namespace pride::log::internal
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "../../hash/crc.hpp"
+#include "../fmt.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Layout of the segment files written by channels::binary_file and read by
+// binary_reader_t. Integers are stored in the byte order of the host.
+//
+//   segment_header_t
+//   frame_header_t + payload, padded to 8 bytes     <- records and logger names
+//   ...
+//   index_entry_t[index_count]                      <- footer, only in sealed segments
+//   name entries: uint64 id, uint32 size, text, padded to 8 bytes
+//   segment_trailer_t
+//
+// A segment that was not sealed (the process died) has no footer. Readers scan
+// it from the start and stop at the first frame that does not check out.
+namespace pride::log::internal::binary
+{
+constexpr char segment_magic[8] = { 'P', 'R', 'I', 'D', 'E', 'L', 'O', 'G' };
+constexpr char trailer_magic[8] = { 'P', 'R', 'I', 'D', 'E', 'E', 'N', 'D' };
+constexpr uint32_t version = 1;
+
+enum class frame_kind_t : uint8_t
+{
+    record = 1,
+    name = 2 // payload is the name of `logger`, written before its first record
+};
+
+struct segment_header_t
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t index;
+    int64_t created; // nanoseconds since the epoch
+};
+
+struct frame_header_t
+{
+    uint32_t size; // whole frame with the header and the padding
+    uint32_t crc;  // crc32 of everything after this field up to the padding
+    int64_t time;  // nanoseconds since the epoch
+    uint64_t thread;
+    uint64_t logger;
+    uint32_t length; // payload bytes
+    frame_kind_t kind;
+    uint8_t level;
+    uint16_t reserved;
+};
+
+// Records before `offset` are all older than or as old as `newest`, `oldest`
+// is the oldest record from `offset` up to the next entry. Entries are
+// written every index interval bytes, a reader starts at the last entry whose
+// `newest` is before the time it looks for and stops at the first entry after
+// which every record is newer than the range.
+struct index_entry_t
+{
+    int64_t newest;
+    int64_t oldest;
+    uint64_t offset;
+};
+
+struct segment_trailer_t
+{
+    char magic[8];
+    uint64_t footer;
+    uint32_t index_count;
+    uint32_t name_count;
+    int64_t first; // oldest record
+    int64_t last;  // newest record
+    uint32_t crc;  // crc32 of the footer and the trailer up to this field
+    uint32_t reserved;
+};
+
+static_assert(sizeof(segment_header_t) == 32, "segment header layout");
+static_assert(sizeof(frame_header_t) == 40, "frame header layout");
+static_assert(sizeof(index_entry_t) == 24, "index entry layout");
+static_assert(sizeof(segment_trailer_t) == 48, "segment trailer layout");
+
+constexpr size_t align(size_t size)
+{
+    return (size + 7) & ~size_t(7);
+}
+
+inline uint32_t crc(const void* data, size_t size, uint32_t seed = 0)
+{
+    return hash::crc32(static_cast<const uint8_t*>(data), size, seed);
+}
+
+inline uint32_t frame_crc(const frame_header_t& frame, const char* payload)
+{
+    constexpr size_t skip = offsetof(frame_header_t, time);
+    auto value = crc(reinterpret_cast<const char*>(&frame) + skip, sizeof(frame) - skip);
+    return crc(payload, frame.length, value);
+}
+
+// app.plog -> app.00000003.plog, a name without an extension gets the index appended
+inline std::string segment_name(const std::string& filename, uint64_t index)
+{
+    auto dot = filename.find_last_of('.');
+    auto slash = filename.find_last_of("/\\");
+    if (dot == std::string::npos || dot == 0 || (slash != std::string::npos && dot < slash + 2))
+        return fmt::format("{}.{:08}", filename, index);
+    return fmt::format("{}.{:08}{}", filename.substr(0, dot), index, filename.substr(dot));
+}
+} // namespace pride::log::internal::binary
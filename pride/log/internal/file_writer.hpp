@@ -0,0 +1,509 @@
+#pragma once
+
+#include "../../os/file.hpp"
+#include "uring.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pride::log::internal
+{
+// What a sync waits for: nothing, the data (fdatasync) or the data and all
+// metadata (fsync)
+enum class file_sync_t
+{
+    none,
+    data,
+    full,
+};
+
+// Writes whole buffers to a file off the calling thread. The writer owns
+// `buffer_count` buffers: acquire() takes a free one, submit() queues it to
+// be written after everything submitted before and returns at once, and the
+// buffer is free again when the write is done. Every write has its own offset
+// so they may finish in any order. acquire, submit, sync and wait are called
+// by one thread at a time.
+class file_writer_t
+{
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    file_writer_t(os::raw_file_t& file, size_t buffer_size, size_t buffer_count)
+        : _file(file)
+        , _buffer_size(buffer_size)
+        , _buffer_count(std::max<size_t>(buffer_count, 1))
+        , _buffers(new char[_buffer_size * _buffer_count])
+        , _offset(file.size())
+    {
+        for (size_t i = _buffer_count; i > 0; --i)
+            _free.push_back(i - 1);
+    }
+
+    virtual ~file_writer_t() = default;
+
+    file_writer_t(const file_writer_t&) = delete;
+    file_writer_t& operator=(const file_writer_t&) = delete;
+
+    size_t buffer_size() const { return _buffer_size; }
+    size_t buffer_count() const { return _buffer_count; }
+    char* data(size_t buffer) const { return _buffers.get() + buffer * _buffer_size; }
+
+    // Index of a free buffer, waits for a write to finish when all of them
+    // are in flight
+    size_t acquire()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _changed.wait(lock, [this] { return !_free.empty(); });
+        auto buffer = _free.back();
+        _free.pop_back();
+        return buffer;
+    }
+
+    // Queues the first `size` bytes of the buffer
+    void submit(size_t buffer, size_t size)
+    {
+        _write(buffer, size, _begin(size));
+    }
+
+    // Gives back a buffer that was acquired but holds nothing to write
+    void release(size_t buffer)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _free.push_back(buffer);
+        _changed.notify_all();
+    }
+
+    // Writes `buffer` when one is given, waits for every write submitted so
+    // far and then syncs the file. False when the sync failed.
+    bool sync(file_sync_t mode, size_t buffer = npos, size_t size = 0)
+    {
+        return _sync(mode, buffer, size, buffer == npos ? 0 : _begin(size));
+    }
+
+    // Waits until no write is in flight
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _changed.wait(lock, [this] { return _in_flight == 0; });
+    }
+
+    // Writes handed to the backend, and the ones among them that failed
+    uint64_t submissions() const { return _submissions.load(std::memory_order_relaxed); }
+    uint64_t failures() const { return _failures.load(std::memory_order_relaxed); }
+
+    virtual bool uses_uring() const { return false; }
+
+protected:
+    virtual void _write(size_t buffer, size_t size, uint64_t offset) = 0;
+    virtual bool _sync(file_sync_t mode, size_t buffer, size_t size, uint64_t offset) = 0;
+
+    // the backend calls this once a write is over, successful or not
+    void _done(size_t buffer, bool ok)
+    {
+        if (!ok)
+            _failures.fetch_add(1, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _free.push_back(buffer);
+        --_in_flight;
+        _changed.notify_all();
+    }
+
+    os::raw_file_t& _file;
+    std::mutex _mutex;
+    std::condition_variable _changed;
+
+private:
+    uint64_t _begin(size_t size)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            ++_in_flight;
+        }
+        _submissions.fetch_add(1, std::memory_order_relaxed);
+
+        auto offset = _offset;
+        _offset += size;
+        return offset;
+    }
+
+    const size_t _buffer_size;
+    const size_t _buffer_count;
+    std::unique_ptr<char[]> _buffers;
+    std::vector<size_t> _free;
+    size_t _in_flight = 0;
+    uint64_t _offset;
+
+    std::atomic<uint64_t> _submissions{ 0 };
+    std::atomic<uint64_t> _failures{ 0 };
+};
+
+// ─── THREAD POOL ─────────────────────────────────────────────────────────────────
+
+// Positioned writes from a few worker threads, for when there is no io_uring
+class thread_writer_t : public file_writer_t
+{
+public:
+    thread_writer_t(os::raw_file_t& file, size_t buffer_size, size_t buffer_count, size_t threads)
+        : file_writer_t(file, buffer_size, buffer_count)
+    {
+        for (size_t i = 0; i < std::max<size_t>(threads, 1); ++i)
+            _threads.emplace_back([this] { _work(); });
+    }
+
+    ~thread_writer_t() override
+    {
+        wait();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _queued.notify_all();
+        for (auto& thread : _threads)
+            thread.join();
+    }
+
+protected:
+    void _write(size_t buffer, size_t size, uint64_t offset) override
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _jobs.push_back({ buffer, size, offset });
+        }
+        _queued.notify_one();
+    }
+
+    bool _sync(file_sync_t mode, size_t buffer, size_t size, uint64_t offset) override
+    {
+        if (buffer != npos)
+            _write(buffer, size, offset);
+        wait();
+        return mode == file_sync_t::none || _file.sync(mode == file_sync_t::data);
+    }
+
+private:
+    struct job_t
+    {
+        size_t buffer;
+        size_t size;
+        uint64_t offset;
+    };
+
+    void _work()
+    {
+        for (;;)
+        {
+            job_t job;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _queued.wait(lock, [this] { return _stopping || !_jobs.empty(); });
+                if (_jobs.empty())
+                    return;
+                job = _jobs.front();
+                _jobs.pop_front();
+            }
+            _done(job.buffer, _file.write_at(data(job.buffer), job.size, job.offset));
+        }
+    }
+
+    std::condition_variable _queued;
+    std::deque<job_t> _jobs;
+    bool _stopping = false;
+    std::vector<std::thread> _threads;
+};
+
+// ─── IO_URING ────────────────────────────────────────────────────────────────────
+
+#if defined(PRIDE_LOG_URING)
+// Writes submitted to an io_uring from registered buffers, completions
+// reaped on a thread of its own. A sync is an fsync linked behind the last
+// write, which drains everything submitted before it.
+class uring_writer_t : public file_writer_t
+{
+public:
+    uring_writer_t(os::raw_file_t& file, size_t buffer_size, size_t buffer_count)
+        : file_writer_t(file, buffer_size, buffer_count)
+        , _states(this->buffer_count())
+    {
+        // room for a write per buffer, a resubmission per buffer and the sync
+        if (!_ring.open(static_cast<unsigned>(_states.size() * 2 + 2)))
+            return;
+
+        std::vector<iovec> buffers(_states.size());
+        for (size_t i = 0; i < buffers.size(); ++i)
+            buffers[i] = { data(i), this->buffer_size() };
+        _fixed = _ring.register_buffers(buffers.data(), static_cast<unsigned>(buffers.size()));
+
+        // plain writes came with 5.6, an older kernel that cannot pin the
+        // buffers is left to the writer threads
+        if (!_fixed && !_ring.supports(IORING_OP_WRITE))
+        {
+            _ring.close();
+            return;
+        }
+
+        _reaper = std::thread([this] { _reap(); });
+    }
+
+    ~uring_writer_t() override
+    {
+        if (!ready())
+            return;
+
+        wait();
+        {
+            std::lock_guard<std::mutex> lock(_ring_mutex);
+            if (_broken)
+            {
+                _reaper.join();
+                return;
+            }
+            auto sqe = _next();
+            sqe->opcode = IORING_OP_NOP;
+            sqe->user_data = stop_tag;
+            _ring.submit();
+        }
+        _reaper.join();
+    }
+
+    // False when io_uring could not be set up, nothing may be written then
+    bool ready() const { return _ring.is_open(); }
+
+    bool uses_uring() const override { return true; }
+
+    // Whether the buffers are registered with the kernel
+    bool fixed() const { return _fixed; }
+
+protected:
+    void _write(size_t buffer, size_t size, uint64_t offset) override
+    {
+        {
+            std::lock_guard<std::mutex> lock(_ring_mutex);
+            if (!_broken)
+            {
+                _states[buffer] = { offset, size, 0, true };
+                _prepare(buffer, 0);
+                _ring.submit();
+                return;
+            }
+        }
+        _done(buffer, false);
+    }
+
+    bool _sync(file_sync_t mode, size_t buffer, size_t size, uint64_t offset) override
+    {
+        if (mode == file_sync_t::none)
+        {
+            if (buffer != npos)
+                _write(buffer, size, offset);
+            wait();
+            return true;
+        }
+
+        auto resubmits = _resubmits.load(std::memory_order_acquire);
+        {
+            std::unique_lock<std::mutex> lock(_ring_mutex);
+            if (_broken)
+            {
+                lock.unlock();
+                if (buffer != npos)
+                    _done(buffer, false);
+                return false;
+            }
+            if (buffer != npos)
+            {
+                _states[buffer] = { offset, size, 0, true };
+                _prepare(buffer, IOSQE_IO_DRAIN | IOSQE_IO_LINK);
+            }
+            _prepare_sync(mode, buffer == npos ? IOSQE_IO_DRAIN : 0);
+            _ring.submit();
+        }
+
+        auto result = _wait_sync();
+        wait();
+
+        // a short write breaks the link and its rest goes out after the
+        // fsync, so sync once more behind it
+        if (result == -ECANCELED || _resubmits.load(std::memory_order_acquire) != resubmits)
+        {
+            {
+                std::lock_guard<std::mutex> lock(_ring_mutex);
+                if (_broken)
+                    return false;
+                _prepare_sync(mode, IOSQE_IO_DRAIN);
+                _ring.submit();
+            }
+            result = _wait_sync();
+        }
+        return result == 0;
+    }
+
+private:
+    static constexpr uint64_t stop_tag = ~uint64_t(0);
+    static constexpr uint64_t sync_tag = ~uint64_t(0) - 1;
+
+    struct state_t
+    {
+        uint64_t offset;
+        size_t size;
+        size_t written;
+        bool queued;
+    };
+
+    io_uring_sqe* _next()
+    {
+        io_uring_sqe* sqe;
+        while ((sqe = _ring.next()) == nullptr)
+        {
+            _ring.submit();
+            std::this_thread::yield();
+        }
+        return sqe;
+    }
+
+    // queues what is left of the buffer's write
+    void _prepare(size_t buffer, uint8_t flags)
+    {
+        const auto& state = _states[buffer];
+        auto sqe = _next();
+        sqe->opcode = _fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+        sqe->flags = flags;
+        sqe->fd = _file.descriptor();
+        sqe->addr = reinterpret_cast<uint64_t>(data(buffer) + state.written);
+        sqe->len = static_cast<uint32_t>(state.size - state.written);
+        sqe->off = state.offset + state.written;
+        sqe->buf_index = static_cast<uint16_t>(_fixed ? buffer : 0);
+        sqe->user_data = buffer;
+    }
+
+    void _prepare_sync(file_sync_t mode, uint8_t flags)
+    {
+        auto sqe = _next();
+        sqe->opcode = IORING_OP_FSYNC;
+        sqe->flags = flags;
+        sqe->fd = _file.descriptor();
+        sqe->fsync_flags = mode == file_sync_t::data ? IORING_FSYNC_DATASYNC : 0;
+        sqe->user_data = sync_tag;
+    }
+
+    int _wait_sync()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _changed.wait(lock, [this] { return _synced; });
+        _synced = false;
+        return _sync_result;
+    }
+
+    void _reap()
+    {
+        bool stopping = false;
+        while (!stopping)
+        {
+            auto reaped = _ring.reap(true, [&](uint64_t tag, int result) {
+                if (tag == stop_tag)
+                    stopping = true;
+                else if (tag == sync_tag)
+                    _synced_with(result);
+                else
+                    _complete(static_cast<size_t>(tag), result);
+            });
+            if (reaped < 0)
+            {
+                _break();
+                return;
+            }
+        }
+    }
+
+    void _synced_with(int result)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _sync_result = result;
+        _synced = true;
+        _changed.notify_all();
+    }
+
+    // The ring cannot be waited on any more. What is in flight fails, and so
+    // does everything submitted from here on.
+    void _break()
+    {
+        std::vector<size_t> failed;
+        {
+            std::lock_guard<std::mutex> lock(_ring_mutex);
+            _broken = true;
+            for (size_t i = 0; i < _states.size(); ++i)
+                if (_states[i].queued)
+                {
+                    _states[i].queued = false;
+                    failed.push_back(i);
+                }
+        }
+        for (auto buffer : failed)
+            _done(buffer, false);
+        _synced_with(-EIO);
+    }
+
+    // the buffer's state is only touched under the ring lock, the kernel
+    // orders the rest but thread checkers cannot see that
+    void _complete(size_t buffer, int result)
+    {
+        bool ok;
+        {
+            std::lock_guard<std::mutex> lock(_ring_mutex);
+            auto& state = _states[buffer];
+            if (result > 0)
+                state.written += static_cast<size_t>(result);
+
+            if (result == -EINTR || result == -EAGAIN || (result > 0 && state.written < state.size))
+            {
+                _resubmits.fetch_add(1, std::memory_order_release);
+                _prepare(buffer, 0);
+                _ring.submit();
+                return;
+            }
+            ok = result >= 0 && state.written == state.size;
+            state.queued = false;
+        }
+        _done(buffer, ok);
+    }
+
+    uring_t _ring;
+    bool _fixed = false;
+    bool _broken = false; // under the ring lock
+    std::mutex _ring_mutex;
+    std::vector<state_t> _states;
+    std::atomic<uint64_t> _resubmits{ 0 };
+    bool _synced = false;
+    int _sync_result = 0;
+    std::thread _reaper;
+};
+#endif
+
+// io_uring where the kernel offers it, otherwise `threads` writer threads
+inline std::unique_ptr<file_writer_t> make_file_writer(os::raw_file_t& file, size_t buffer_size, size_t buffer_count, size_t threads, bool use_uring = true)
+{
+#if defined(PRIDE_LOG_URING)
+    if (use_uring)
+    {
+        auto writer = std::make_unique<uring_writer_t>(file, buffer_size, buffer_count);
+        if (writer->ready())
+            return writer;
+    }
+#else
+    (void)use_uring;
+#endif
+
+#if defined(PRIDE_OS_WINDOWS)
+    // write_at seeks there, a second thread would race the first
+    threads = 1;
+#endif
+    return std::make_unique<thread_writer_t>(file, buffer_size, buffer_count, threads);
+}
+} // namespace pride::log::internal
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace pride::log::internal
+{
+// Background thread that calls a flush function every period. Used by the
+// channels that hold records back so they still reach their output when no
+// more records come in.
+class periodic_flusher_t
+{
+public:
+    periodic_flusher_t() = default;
+    periodic_flusher_t(const periodic_flusher_t&) = delete;
+    periodic_flusher_t& operator=(const periodic_flusher_t&) = delete;
+
+    ~periodic_flusher_t()
+    {
+        stop();
+    }
+
+    // Restarts the thread with a new period, zero only stops it
+    void start(std::chrono::milliseconds period, std::function<void()> flush)
+    {
+        stop();
+        if (period.count() <= 0)
+            return;
+
+        _running = true;
+        _thread = std::thread([this, period, flush = std::move(flush)] {
+            std::unique_lock<std::mutex> lock(_mutex);
+            while (_running)
+            {
+                if (_cv.wait_for(lock, period, [this] { return !_running; }))
+                    break;
+                flush();
+            }
+        });
+    }
+
+    void stop()
+    {
+        if (!_thread.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _running = false;
+        }
+        _cv.notify_one();
+        _thread.join();
+    }
+
+private:
+    std::thread _thread;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    bool _running{ false };
+};
+} // namespace pride::log::internal
@@ -0,0 +1,223 @@
+#pragma once
+
+#include "../message.hpp"
+#include "../sevarity.hpp"
+#include "time.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+
+namespace pride::log
+{
+// How many records each call site of a logger may log. A call site is the
+// statement of a PRIDE_LOG macro or the format string of a log call.
+struct limits_t
+{
+    double rate{ 0 };     // records per second, zero is unlimited
+    double burst{ 1 };    // records logged back to back before the rate applies
+    uint32_t sample{ 1 }; // log one record in every `sample`
+
+    // records at or above this level are never limited
+    sevarity_t exempt{ sevarity_t::off };
+
+    // how often the number of suppressed records is logged for call sites
+    // that went quiet, zero only reports when the call site logs again
+    std::chrono::milliseconds report{ 1000 };
+
+    // call sites tracked, records of the ones that do not fit are not limited
+    size_t sites{ 1024 };
+};
+
+namespace internal
+{
+    // Stands in for the "{}" format of the plain string and value overloads,
+    // which have no format string of their own to key on. A string literal
+    // is keyed on its address, other strings on their text. Values that are
+    // not strings have no key and are never limited.
+    struct value_site_t
+    {
+        const char* literal{ nullptr };
+        std::string_view text;
+
+        explicit operator std::string_view() const { return text; }
+    };
+
+    template<typename T>
+    value_site_t value_site(const T& value)
+    {
+        if constexpr (std::is_convertible_v<const T&, const char*>)
+            return { value, value };
+        else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+            return { nullptr, std::string_view(value) };
+        else
+            return {};
+    }
+
+    // Call site key of a log call without a source location
+    template<typename Format>
+    const void* site_of(const Format& format)
+    {
+        if constexpr (std::is_same_v<Format, const char*> || std::is_same_v<Format, char*>)
+            return format;
+        else if constexpr (std::is_same_v<Format, std::string_view>)
+            return format.data();
+        else if constexpr (std::is_same_v<Format, value_site_t>)
+        {
+            if (format.literal != nullptr)
+                return format.literal;
+            if (format.text.data() == nullptr)
+                return nullptr;
+            // never zero, which marks a free slot
+            auto hash = std::hash<std::string_view>()(format.text) | 1;
+            return reinterpret_cast<const void*>(static_cast<uintptr_t>(hash));
+        }
+        else
+            return nullptr;
+    }
+
+    // Token bucket and sampling state per call site in a fixed open addressing
+    // table. Call sites claim a slot with a compare and swap, admission is a
+    // few atomic operations on the slot and never locks.
+    class limiter_t
+    {
+    public:
+        static constexpr size_t max_probe = 16;
+        static constexpr size_t max_text = 48;
+
+        explicit limiter_t(const limits_t& limits)
+            : _limits(limits)
+            , _interval(limits.rate > 0 ? static_cast<int64_t>(1e9 / limits.rate) : 0)
+            , _tolerance(static_cast<int64_t>(std::max(1.0, limits.burst) * static_cast<double>(_interval)))
+        {
+            size_t capacity = 16;
+            while (capacity < limits.sites)
+                capacity *= 2;
+            _mask = capacity - 1;
+            _sites.reset(new site_t[capacity]);
+        }
+
+        limiter_t(const limiter_t&) = delete;
+        limiter_t& operator=(const limiter_t&) = delete;
+
+        const limits_t& limits() const { return _limits; }
+
+        // True when the record may be logged. `suppressed` receives the
+        // records of the call site suppressed since it last logged.
+        template<typename Format>
+        bool admit(const void* key, sevarity_t level, const source_location_t* source, const Format& format, uint64_t& suppressed)
+        {
+            suppressed = 0;
+            if (key == nullptr || level >= _limits.exempt)
+                return true;
+
+            auto site = _find(key, level, source, format);
+            if (site == nullptr)
+                return true;
+
+            if (_limits.sample > 1 && site->seen.fetch_add(1, std::memory_order_relaxed) % _limits.sample != 0)
+            {
+                site->suppressed.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            if (_interval > 0 && !_take_token(*site))
+            {
+                site->suppressed.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            if (site->suppressed.load(std::memory_order_relaxed) != 0)
+                suppressed = site->suppressed.exchange(0, std::memory_order_relaxed);
+            return true;
+        }
+
+        // Calls fn(level, source, text, count) for every call site with
+        // suppressed records and resets their counts
+        template<typename Fn>
+        void report(Fn&& fn)
+        {
+            for (size_t i = 0; i <= _mask; ++i)
+            {
+                auto& site = _sites[i];
+                if (!site.ready.load(std::memory_order_acquire) || site.suppressed.load(std::memory_order_relaxed) == 0)
+                    continue;
+                if (auto count = site.suppressed.exchange(0, std::memory_order_relaxed))
+                    fn(site.level, site.source, std::string_view(site.text, site.text_size), count);
+            }
+        }
+
+    private:
+        struct alignas(64) site_t
+        {
+            std::atomic<uintptr_t> key{ 0 };
+            std::atomic<int64_t> tat{ 0 }; // theoretical arrival time of the next record
+            std::atomic<uint64_t> seen{ 0 };
+            std::atomic<uint64_t> suppressed{ 0 };
+
+            // written once by the thread that claims the slot
+            std::atomic<bool> ready{ false };
+            sevarity_t level{ sevarity_t::trace };
+            const source_location_t* source{ nullptr };
+            size_t text_size{ 0 };
+            char text[max_text];
+        };
+
+        template<typename Format>
+        site_t* _find(const void* key, sevarity_t level, const source_location_t* source, const Format& format)
+        {
+            auto value = reinterpret_cast<uintptr_t>(key);
+            auto index = static_cast<size_t>((value >> 4) * 0x9E3779B97F4A7C15ull);
+            for (size_t probe = 0; probe < max_probe; ++probe)
+            {
+                auto& site = _sites[(index + probe) & _mask];
+                auto current = site.key.load(std::memory_order_acquire);
+                if (current == value)
+                    return &site;
+                if (current != 0)
+                    continue;
+
+                if (site.key.compare_exchange_strong(current, value, std::memory_order_acq_rel))
+                {
+                    site.level = level;
+                    site.source = source;
+                    std::string_view text(format);
+                    site.text_size = std::min(text.size(), sizeof(site.text));
+                    std::memcpy(site.text, text.data(), site.text_size);
+                    site.ready.store(true, std::memory_order_release);
+                    return &site;
+                }
+                if (current == value)
+                    return &site;
+            }
+            return nullptr;
+        }
+
+        // generic cell rate algorithm, a token bucket kept in one timestamp
+        bool _take_token(site_t& site)
+        {
+            const auto now = coarse_steady_ns();
+            auto tat = site.tat.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                auto next = std::max(tat, now) + _interval;
+                if (next - now > _tolerance)
+                    return false;
+                if (site.tat.compare_exchange_weak(tat, next, std::memory_order_relaxed))
+                    return true;
+            }
+        }
+
+        const limits_t _limits;
+        const int64_t _interval;
+        const int64_t _tolerance;
+        size_t _mask{ 0 };
+        std::unique_ptr<site_t[]> _sites;
+    };
+} // namespace internal
+} // namespace pride::log
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "../message.hpp"
+#include "../sevarity.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace pride::log
+{
+namespace internal
+{
+    class message_pool_t;
+
+    struct pooled_message_t : public message_t
+    {
+        pooled_message_t* next{ nullptr };
+        message_pool_t* owner{ nullptr };
+    };
+
+    struct message_releaser_t
+    {
+        void operator()(message_t* msg) const;
+    };
+} // namespace internal
+
+// Owning handle to a recycled message. Destroying it hands the record back to
+// the pool of the thread that acquired it, from whichever thread that is.
+using message_ptr = std::unique_ptr<message_t, internal::message_releaser_t>;
+
+namespace internal
+{
+    // Per thread free list of message records. The owning thread pushes and
+    // pops its local list without any synchronisation, other threads (the
+    // async workers) return records through a lock free stack that the owner
+    // takes over in one exchange when the local list runs dry. Records keep
+    // the capacity their buffer has grown to, so in steady state logging does
+    // not touch the heap at all.
+    class message_pool_t
+    {
+    public:
+        static message_ptr acquire(const std::string* names, sevarity_t level);
+        static void release(pooled_message_t* msg);
+
+        message_pool_t(const message_pool_t&) = delete;
+        message_pool_t& operator=(const message_pool_t&) = delete;
+
+    private:
+        message_pool_t() = default;
+        ~message_pool_t() = default;
+
+        // Closes the pool of the thread when it exits. Records still in
+        // flight are deleted by whoever releases them and the last one out
+        // deletes the pool.
+        struct thread_handle_t
+        {
+            message_pool_t* pool;
+            ~thread_handle_t() { pool->close(); }
+        };
+
+        static message_pool_t& local();
+        static pooled_message_t* closed() { return reinterpret_cast<pooled_message_t*>(uintptr_t(1)); }
+
+        pooled_message_t* pop();
+        void close();
+        void unref(size_t count);
+        static size_t destroy_list(pooled_message_t* msg);
+
+        inline static thread_local message_pool_t* _current = nullptr;
+
+        pooled_message_t* _free{ nullptr };
+        alignas(64) std::atomic<pooled_message_t*> _remote{ nullptr };
+        std::atomic<size_t> _refs{ 1 }; // one per record plus one for the owning thread
+    };
+
+    // ────────────────────────────────────────────────────────────────────────────────
+
+    inline void message_releaser_t::operator()(message_t* msg) const
+    {
+        message_pool_t::release(static_cast<pooled_message_t*>(msg));
+    }
+
+    // ────────────────────────────────────────────────────────────────────────────────
+
+    inline message_ptr message_pool_t::acquire(const std::string* names, sevarity_t level)
+    {
+        auto msg = local().pop();
+        msg->reset(names, level);
+        return message_ptr(msg);
+    }
+
+    inline void message_pool_t::release(pooled_message_t* msg)
+    {
+        auto pool = msg->owner;
+        if (pool == _current)
+        {
+            msg->next = pool->_free;
+            pool->_free = msg;
+            return;
+        }
+
+        auto head = pool->_remote.load(std::memory_order_relaxed);
+        do
+        {
+            if (head == closed())
+            {
+                delete msg;
+                pool->unref(1);
+                return;
+            }
+            msg->next = head;
+        } while (!pool->_remote.compare_exchange_weak(head, msg, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    // ────────────────────────────────────────────────────────────────────────────────
+
+    inline message_pool_t& message_pool_t::local()
+    {
+        static thread_local thread_handle_t handle{ _current = new message_pool_t() };
+        return *handle.pool;
+    }
+
+    inline pooled_message_t* message_pool_t::pop()
+    {
+        if (_free == nullptr && _remote.load(std::memory_order_relaxed) != nullptr)
+            _free = _remote.exchange(nullptr, std::memory_order_acquire);
+
+        auto msg = _free;
+        if (msg != nullptr)
+        {
+            _free = msg->next;
+            msg->next = nullptr;
+            return msg;
+        }
+
+        msg = new pooled_message_t();
+        msg->owner = this;
+        _refs.fetch_add(1, std::memory_order_relaxed);
+        return msg;
+    }
+
+    inline void message_pool_t::close()
+    {
+        _current = nullptr;
+        auto count = destroy_list(_free);
+        _free = nullptr;
+        count += destroy_list(_remote.exchange(closed(), std::memory_order_acquire));
+        unref(count + 1);
+    }
+
+    inline void message_pool_t::unref(size_t count)
+    {
+        if (_refs.fetch_sub(count, std::memory_order_acq_rel) == count)
+            delete this;
+    }
+
+    inline size_t message_pool_t::destroy_list(pooled_message_t* msg)
+    {
+        size_t count = 0;
+        while (msg != nullptr)
+        {
+            auto next = msg->next;
+            delete msg;
+            msg = next;
+            ++count;
+        }
+        return count;
+    }
+} // namespace internal
+} // namespace pride::log
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace pride::log::internal
+{
+static constexpr size_t cache_line_size = 64;
+
+// Bounded lock free multi producer / multi consumer queue.
+// Based on Dmitry Vyukov's bounded mpmc queue, every cell carries a sequence
+// number so that producers and consumers only contend on their own index.
+// http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+template<typename T>
+class mpmc_queue_t
+{
+public:
+    explicit mpmc_queue_t(size_t capacity)
+        : _capacity(round_up(capacity))
+        , _mask(_capacity - 1)
+        , _cells(new cell_t[_capacity])
+    {
+        for (size_t i = 0; i < _capacity; ++i)
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    mpmc_queue_t(const mpmc_queue_t&) = delete;
+    mpmc_queue_t& operator=(const mpmc_queue_t&) = delete;
+
+    bool try_push(T&& value)
+    {
+        cell_t* cell;
+        size_t pos = _tail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            cell = &_cells[pos & _mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0)
+            {
+                if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+                return false; // full
+            else
+                pos = _tail.load(std::memory_order_relaxed);
+        }
+
+        cell->data = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T& value)
+    {
+        cell_t* cell;
+        size_t pos = _head.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            cell = &_cells[pos & _mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0)
+            {
+                if (_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+                return false; // empty
+            else
+                pos = _head.load(std::memory_order_relaxed);
+        }
+
+        value = std::move(cell->data);
+        cell->sequence.store(pos + _mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t capacity() const { return _capacity; }
+
+    // Only a snapshot, other threads can change it before the caller looks at it
+    size_t size() const
+    {
+        auto tail = _tail.load(std::memory_order_relaxed);
+        auto head = _head.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    static size_t round_up(size_t value)
+    {
+        size_t result = 2;
+        while (result < value)
+            result <<= 1;
+        return result;
+    }
+
+    struct cell_t
+    {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    const size_t _capacity;
+    const size_t _mask;
+    std::unique_ptr<cell_t[]> _cells;
+
+    alignas(cache_line_size) std::atomic<size_t> _tail{ 0 };
+    alignas(cache_line_size) std::atomic<size_t> _head{ 0 };
+};
+} // namespace pride::log::internal
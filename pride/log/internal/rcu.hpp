@@ -0,0 +1,204 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace pride::log::internal
+{
+// Epoch based reclamation for the configuration that is read on every record
+// (channel lists, formatters).
+//
+// Readers enter a read section, load the current pointer and use it without
+// taking a lock. Writers publish a replacement with an atomic store and
+// retire the old object, which is deleted once every reader that could still
+// hold it has left its read section. Read sections nest and only the
+// outermost one touches shared memory.
+//
+// Each thread owns a slot holding the epoch it entered at, zero while it is
+// outside of a read section. Retiring bumps the global epoch and tags the
+// object with the new value, an object is free to delete when every busy slot
+// entered at or after its epoch.
+class rcu_t
+{
+public:
+    class read_guard_t
+    {
+    public:
+        read_guard_t()
+            : _rcu(rcu_t::instance())
+        {
+            _rcu._enter();
+        }
+        ~read_guard_t() { _rcu._leave(); }
+
+        read_guard_t(const read_guard_t&) = delete;
+        read_guard_t& operator=(const read_guard_t&) = delete;
+
+    private:
+        rcu_t& _rcu;
+    };
+
+    // Never destroyed, threads may still leave their read sections while the
+    // program shuts down
+    static rcu_t& instance()
+    {
+        static rcu_t* rcu = new rcu_t();
+        return *rcu;
+    }
+
+    rcu_t(const rcu_t&) = delete;
+    rcu_t& operator=(const rcu_t&) = delete;
+
+    // Deletes `object` once no reader can hold it anymore
+    template<typename T>
+    void retire(const T* object)
+    {
+        if (object)
+            _retire(const_cast<T*>(object), [](void* ptr) { delete static_cast<T*>(ptr); });
+    }
+
+    // Deletes the retired objects no reader can hold anymore. Retiring does
+    // this as well, a reader that held an object at that point delays it to
+    // the next call.
+    void reclaim()
+    {
+        std::vector<retired_t> ready;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _collect(ready);
+        }
+        for (auto& item : ready)
+            item.destroy(item.object);
+    }
+
+    // Retired objects that are waiting for readers
+    size_t pending() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _retired.size();
+    }
+
+private:
+    struct alignas(64) slot_t
+    {
+        std::atomic<uint64_t> epoch{ 0 };
+        std::atomic<bool> used{ false };
+        slot_t* next{ nullptr };
+    };
+
+    struct retired_t
+    {
+        uint64_t epoch;
+        void* object;
+        void (*destroy)(void*);
+    };
+
+    // returns the slot to the list when the thread exits
+    struct thread_state_t
+    {
+        ~thread_state_t()
+        {
+            if (slot)
+            {
+                slot->epoch.store(0, std::memory_order_release);
+                slot->used.store(false, std::memory_order_release);
+            }
+        }
+
+        slot_t* slot{ nullptr };
+        uint32_t depth{ 0 };
+    };
+
+    rcu_t() = default;
+
+    static thread_state_t& _local()
+    {
+        static thread_local thread_state_t state;
+        return state;
+    }
+
+    void _enter()
+    {
+        auto& state = _local();
+        if (state.depth++ > 0)
+            return;
+        if (!state.slot)
+            state.slot = _acquire_slot();
+
+        // seq_cst so the store is ordered before the loads of the pointers
+        // this section reads, a writer that scans the slots after publishing
+        // either sees the epoch or the reader sees the new pointer
+        state.slot->epoch.store(_epoch.load(std::memory_order_acquire), std::memory_order_seq_cst);
+    }
+
+    void _leave()
+    {
+        auto& state = _local();
+        if (--state.depth == 0)
+            state.slot->epoch.store(0, std::memory_order_release);
+    }
+
+    slot_t* _acquire_slot()
+    {
+        for (auto slot = _slots.load(std::memory_order_acquire); slot; slot = slot->next)
+        {
+            bool expected = false;
+            if (!slot->used.load(std::memory_order_relaxed) && slot->used.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                return slot;
+        }
+
+        auto slot = new slot_t();
+        slot->used.store(true, std::memory_order_relaxed);
+        slot->next = _slots.load(std::memory_order_relaxed);
+        while (!_slots.compare_exchange_weak(slot->next, slot, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+        return slot;
+    }
+
+    void _retire(void* object, void (*destroy)(void*))
+    {
+        std::vector<retired_t> ready;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto epoch = _epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+            _retired.push_back({ epoch, object, destroy });
+            _collect(ready);
+        }
+
+        // outside of the lock, destroying an object may retire others
+        for (auto& item : ready)
+            item.destroy(item.object);
+    }
+
+    // under _mutex
+    void _collect(std::vector<retired_t>& ready)
+    {
+        uint64_t oldest = UINT64_MAX;
+        for (auto slot = _slots.load(std::memory_order_acquire); slot; slot = slot->next)
+        {
+            auto epoch = slot->epoch.load(std::memory_order_seq_cst);
+            if (epoch != 0 && epoch < oldest)
+                oldest = epoch;
+        }
+
+        auto keep = _retired.begin();
+        for (auto& item : _retired)
+        {
+            if (item.epoch <= oldest)
+                ready.push_back(item);
+            else
+                *keep++ = item;
+        }
+        _retired.erase(keep, _retired.end());
+    }
+
+    std::atomic<uint64_t> _epoch{ 1 };
+    std::atomic<slot_t*> _slots{ nullptr };
+
+    mutable std::mutex _mutex;
+    std::vector<retired_t> _retired;
+};
+} // namespace pride::log::internal
@@ -0,0 +1,190 @@
+#pragma once
+
+#include "../../ct/hash.hpp"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pride::log
+{
+class logger_t;
+
+// Registry key of a logger name. Built from a string literal the name is
+// hashed at compile time, see PRIDE_LOGGER. The key keeps a view of the name,
+// which the registry compares as two names can have the same hash.
+struct logger_key_t
+{
+    // A char array holding a shorter name is hashed up to its terminator
+    template<size_t N>
+    constexpr logger_key_t(const char (&name)[N])
+        : logger_key_t(name, _length(name, N))
+    {}
+
+    constexpr logger_key_t(const char* name, size_t size)
+        : value(ct::fnv1a(name, size))
+        , name(name, size)
+    {
+        // zero marks an empty slot in the registry
+        if (value == 0)
+            value = 1;
+    }
+
+    explicit constexpr logger_key_t(std::string_view name)
+        : logger_key_t(name.data(), name.size())
+    {}
+
+    // A key that was already computed, from logger_key_t::value, and the
+    // name it was computed from
+    constexpr logger_key_t(hash_t hashed, std::string_view name)
+        : value(hashed)
+        , name(name)
+    {}
+
+    hash_t value;
+    std::string_view name;
+
+private:
+    static constexpr size_t _length(const char* name, size_t capacity)
+    {
+        size_t size = 0;
+        while (size < capacity && name[size] != '\0')
+            ++size;
+        return size;
+    }
+};
+} // namespace pride::log
+
+namespace pride::log::internal
+{
+// Named loggers, looked up without taking a lock.
+//
+// Open addressing table keyed on the name hash. Lookups load the table and
+// probe its slots with acquire loads. Registering takes a mutex, publishes new
+// entries with a release store and replaces the table with one twice the size
+// when it is half full. Entries and old tables are kept until the end of the
+// program, so a reader that loaded them never sees them go away. A logger
+// that is replaced by one with the same name stays alive for the same reason.
+class registry_t
+{
+    struct entry_t
+    {
+        hash_t key;
+        std::string name;
+        std::shared_ptr<logger_t> logger;
+    };
+
+    struct table_t
+    {
+        explicit table_t(size_t capacity)
+            : mask(capacity - 1)
+            , slots(new std::atomic<const entry_t*>[capacity])
+        {
+            for (size_t i = 0; i < capacity; ++i)
+                slots[i].store(nullptr, std::memory_order_relaxed);
+        }
+
+        const size_t mask;
+        std::unique_ptr<std::atomic<const entry_t*>[]> slots;
+    };
+
+public:
+    static constexpr size_t initial_capacity = 64;
+
+    static registry_t& instance()
+    {
+        static registry_t registry;
+        return registry;
+    }
+
+    logger_t* find(logger_key_t key) const
+    {
+        const table_t* table = _table.load(std::memory_order_acquire);
+        for (size_t i = key.value & table->mask;; i = (i + 1) & table->mask)
+        {
+            const entry_t* entry = table->slots[i].load(std::memory_order_acquire);
+            if (!entry)
+                return nullptr;
+            if (entry->key == key.value && entry->name == key.name)
+                return entry->logger.get();
+        }
+    }
+
+    logger_t* find(std::string_view name) const { return find(logger_key_t(name)); }
+
+    // Adds the logger under `name`, replacing a logger registered with the
+    // same name. Names with the same hash take slots of their own, lookups
+    // tell them apart by the name.
+    void insert(const std::string& name, std::shared_ptr<logger_t> logger)
+    {
+        insert(logger_key_t(name), std::move(logger));
+    }
+
+    // Same with the key already computed, it has to be the key of its name
+    // for string lookups to find it
+    void insert(logger_key_t key, std::shared_ptr<logger_t> logger)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        std::string name(key.name);
+        table_t* table = _table.load(std::memory_order_relaxed);
+        size_t i = key.value & table->mask;
+        for (const entry_t* entry; (entry = table->slots[i].load(std::memory_order_relaxed)); i = (i + 1) & table->mask)
+        {
+            if (entry->key == key.value && entry->name == name)
+                break;
+        }
+
+        bool replaced = table->slots[i].load(std::memory_order_relaxed) != nullptr;
+        _entries.emplace_back(new entry_t{ key.value, name, std::move(logger) });
+        table->slots[i].store(_entries.back().get(), std::memory_order_release);
+
+        if (!replaced && ++_size * 2 > table->mask + 1)
+            _grow();
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _size;
+    }
+
+private:
+    registry_t()
+    {
+        _tables.emplace_back(new table_t(initial_capacity));
+        _table.store(_tables.back().get(), std::memory_order_release);
+    }
+
+    // under _mutex
+    void _grow()
+    {
+        const table_t* old = _table.load(std::memory_order_relaxed);
+        auto table = std::make_unique<table_t>((old->mask + 1) * 2);
+        for (size_t i = 0; i <= old->mask; ++i)
+        {
+            const entry_t* entry = old->slots[i].load(std::memory_order_relaxed);
+            if (!entry)
+                continue;
+
+            size_t j = entry->key & table->mask;
+            while (table->slots[j].load(std::memory_order_relaxed))
+                j = (j + 1) & table->mask;
+            table->slots[j].store(entry, std::memory_order_relaxed);
+        }
+
+        _table.store(table.get(), std::memory_order_release);
+        _tables.push_back(std::move(table));
+    }
+
+    std::atomic<table_t*> _table{ nullptr };
+
+    mutable std::mutex _mutex;
+    size_t _size{ 0 };
+    std::vector<std::unique_ptr<entry_t>> _entries;
+    std::vector<std::unique_ptr<table_t>> _tables;
+};
+} // namespace pride::log::internal
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "../../config/detection/os.hpp"
+#include "queue.hpp"
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+#if defined(PRIDE_OS_LINUX)
+#    include <linux/futex.h>
+#    include <sys/syscall.h>
+#    include <time.h>
+#    include <unistd.h>
+#endif
+
+// Layout of the shared memory ring written by channels::shm_ring and read by
+// shm_reader_t. Integers are stored in the byte order of the host, writer and
+// collector run on the same machine.
+//
+//   header_t, padded to header_size
+//   records, capacity bytes
+//
+// Records are record_t + logger name + source file + function + message,
+// padded to 8 bytes. A record never wraps: when it does not fit before the end
+// of the ring the writer puts a wrap marker there (only the first 8 bytes of a
+// record_t) and starts the record at the beginning.
+namespace pride::log::internal::shm
+{
+constexpr char magic[8] = { 'P', 'R', 'I', 'D', 'E', 'S', 'H', 'M' };
+constexpr uint32_t version = 2;
+
+// The cursors only grow, a cursor modulo the capacity is an offset into the
+// records. The writer moves `write` once a record is complete, everything
+// before it may be read. The collector moves `read` once it took a record,
+// the writer may reuse everything before it. Each side is a single thread or
+// process at a time, neither ever waits for a lock the other holds. An idle
+// collector sets `parked` and waits on it, the writer clears it and wakes the
+// collector after a record.
+struct header_t
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t capacity; // a power of two
+    uint64_t writer;   // process id of the last writer
+
+    alignas(cache_line_size) std::atomic<uint64_t> write;
+    std::atomic<uint64_t> sequence; // number of the next record
+    std::atomic<uint64_t> dropped;  // records the writer had no room for
+
+    alignas(cache_line_size) std::atomic<uint64_t> read;
+    std::atomic<uint32_t> parked; // a futex on Linux
+};
+
+enum class record_kind_t : uint8_t
+{
+    record = 1,
+    wrap = 2 // the rest of the ring is unused, the next record is at its start
+};
+
+struct record_t
+{
+    uint32_t size; // whole record with the padding
+    uint16_t name_length;
+    record_kind_t kind;
+    uint8_t level;
+    uint64_t sequence; // dropped records use up their number, a gap is a loss
+    int64_t time;      // nanoseconds since the epoch
+    uint64_t thread;
+    uint32_t length; // message bytes
+    uint32_t line;
+    uint16_t file_length;
+    uint16_t function_length;
+    uint32_t reserved;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the ring needs lock free 64 bit atomics");
+static_assert(sizeof(record_t) == 48, "record layout");
+
+constexpr size_t wrap_size = 8;
+constexpr size_t header_size = (sizeof(header_t) + cache_line_size - 1) & ~(cache_line_size - 1);
+
+constexpr size_t align(size_t size)
+{
+    return (size + 7) & ~size_t(7);
+}
+
+// Bytes of shared memory for a ring with `capacity` bytes of records
+constexpr size_t memory_size(size_t capacity)
+{
+    return header_size + capacity;
+}
+
+// Writer: wakes the collector after a record when it is parked. The
+// collector sets `parked` before it looks at `write` and the writer moves
+// `write` before it looks at `parked`, so one of them always sees the other.
+inline void wake(header_t& header)
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (header.parked.load(std::memory_order_relaxed) == 0)
+        return;
+    header.parked.store(0, std::memory_order_relaxed);
+#if defined(PRIDE_OS_LINUX)
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&header.parked), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+}
+
+// Collector: waits until the writer moves past `write` or `timeout` passed.
+// Without a futex it looks every millisecond.
+inline void park(header_t& header, uint64_t write, std::chrono::milliseconds timeout)
+{
+#if defined(PRIDE_OS_LINUX)
+    header.parked.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (header.write.load(std::memory_order_relaxed) == write)
+    {
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+        timespec wait{ static_cast<time_t>(seconds.count()), static_cast<long>(std::chrono::nanoseconds(timeout - seconds).count()) };
+        ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&header.parked), FUTEX_WAIT, 1, &wait, nullptr, 0);
+    }
+    header.parked.store(0, std::memory_order_relaxed);
+#else
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (header.write.load(std::memory_order_acquire) == write && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+}
+
+inline bool valid(const header_t& header, size_t memory)
+{
+    return std::memcmp(header.magic, magic, sizeof(magic)) == 0 && header.version == version && header.header_size == header_size &&
+           header.capacity >= 64 && (header.capacity & (header.capacity - 1)) == 0 && memory_size(header.capacity) <= memory;
+}
+} // namespace pride::log::internal::shm
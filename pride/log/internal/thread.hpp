@@ -36,4 +36,13 @@ inline size_t thread_id()
     static thread_local const size_t tid = _thread_id();
     return tid;
 }
+
+inline int process_id()
+{
+#if defined(PRIDE_OS_WINDOWS)
+    return static_cast<int>(::GetCurrentProcessId());
+#else
+    return static_cast<int>(::getpid());
+#endif
+}
 } // namespace pride::log::internal
@@ -3,16 +3,31 @@
 
 #include "../../config/detection/os.hpp"
 #include "../../config/include/windows.hpp"
+#include "../clock.hpp"
 #include <chrono>
+#include <cstdint>
 #include <ctime>
 #include <string>
 #include <thread>
 
+#if defined(PRIDE_OS_LINUX)
+#    include <time.h>
+#endif
+
 namespace pride::log::internal
 {
-inline std::chrono::system_clock::time_point now()
+// Monotonic nanoseconds for rate decisions. On Linux this is the coarse
+// clock, a few times cheaper than a precise read and only as fine as the
+// scheduler tick.
+inline int64_t coarse_steady_ns()
 {
-    return std::chrono::system_clock::now();
+#if defined(PRIDE_OS_LINUX)
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
 }
 
 inline std::tm local_time(const std::time_t& tt)
@@ -49,6 +64,24 @@ inline std::tm gm_time()
     return gm_time(n);
 }
 
+// Minutes east of UTC of a local time, daylight saving time included
+inline long utc_offset_minutes(const std::tm& tm)
+{
+#if defined(PRIDE_OS_WINDOWS)
+    long seconds = 0;
+    _get_timezone(&seconds);
+    if (tm.tm_isdst > 0)
+    {
+        long bias = 0;
+        _get_dstbias(&bias);
+        seconds += bias;
+    }
+    return -seconds / 60;
+#else
+    return static_cast<long>(tm.tm_gmtoff / 60);
+#endif
+}
+
 inline bool operator==(const std::tm& tm1, const std::tm& tm2)
 {
     return (tm1.tm_sec == tm2.tm_sec && tm1.tm_min == tm2.tm_min && tm1.tm_hour == tm2.tm_hour && tm1.tm_mday == tm2.tm_mday && tm1.tm_mon == tm2.tm_mon && tm1.tm_year == tm2.tm_year && tm1.tm_isdst == tm2.tm_isdst);
@@ -0,0 +1,181 @@
+#pragma once
+
+#include "../../config/detection/compiler.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#    define PRIDE_LOG_TSC
+#    if defined(PRIDE_COMPILER_MSVC)
+#        include <intrin.h>
+#    else
+#        include <cpuid.h>
+#        include <x86intrin.h>
+#    endif
+#endif
+
+namespace pride::log::internal
+{
+// Wall time read from the cycle counter of the cpu.
+//
+// The counter rate is measured against the steady clock and the counter is
+// anchored to the system clock. Readers convert the ticks since the anchor
+// with one multiply. The first reader to see the anchor older than the resync
+// interval takes a new one, which measures the rate again over the whole
+// interval and picks up any change of the system clock (ntp slewing, the
+// clock being set). Readers load the anchor through a sequence lock so they
+// never wait on the thread that moves it.
+class tsc_clock_t
+{
+public:
+    static constexpr std::chrono::nanoseconds default_resync_interval = std::chrono::seconds(1);
+
+    // True when the cpu has a counter that runs at a constant rate in every
+    // power state and can be read without a system call
+    static bool supported()
+    {
+#if defined(PRIDE_LOG_TSC) && defined(PRIDE_COMPILER_MSVC)
+        int info[4];
+        __cpuid(info, 0x80000000);
+        if (static_cast<unsigned>(info[0]) < 0x80000007)
+            return false;
+        __cpuid(info, 0x80000007);
+        return (info[3] & (1 << 8)) != 0;
+#elif defined(PRIDE_LOG_TSC)
+        unsigned eax, ebx, ecx, edx;
+        if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) == 0)
+            return false;
+        return (edx & (1u << 8)) != 0;
+#else
+        return false;
+#endif
+    }
+
+    static uint64_t ticks()
+    {
+#if defined(PRIDE_LOG_TSC)
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    // True once the first anchor is complete, the sequence is odd while it
+    // is written
+    bool calibrated() const { return _sequence.load(std::memory_order_acquire) >= 2; }
+
+    // Measures the rate of the counter, blocks for about 10 milliseconds the
+    // first time. Later calls return at once, calls racing the first one
+    // return once it is done.
+    void calibrate()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (calibrated())
+            return;
+        auto start = _sample();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        _publish(start, _sample());
+    }
+
+    void resync_interval(std::chrono::nanoseconds interval)
+    {
+        _resync_ns.store(interval.count(), std::memory_order_relaxed);
+        auto ns_per_tick = _ns_per_tick.load(std::memory_order_relaxed);
+        if (ns_per_tick > 0)
+            _resync_ticks.store(static_cast<uint64_t>(static_cast<double>(interval.count()) / ns_per_tick), std::memory_order_relaxed);
+    }
+
+    std::chrono::system_clock::time_point now()
+    {
+        uint64_t anchor_ticks;
+        int64_t anchor_ns;
+        double ns_per_tick;
+        uint32_t sequence;
+        do
+        {
+            sequence = _sequence.load(std::memory_order_acquire);
+            anchor_ticks = _anchor_ticks.load(std::memory_order_relaxed);
+            anchor_ns = _anchor_ns.load(std::memory_order_relaxed);
+            ns_per_tick = _ns_per_tick.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((sequence & 1) != 0 || sequence != _sequence.load(std::memory_order_relaxed));
+
+        // not calibrated yet, there is no rate to convert the ticks with
+        if (sequence == 0)
+            return std::chrono::system_clock::now();
+
+        // the counters of two cores can be a few ticks apart
+        auto current = ticks();
+        auto elapsed = current > anchor_ticks ? current - anchor_ticks : 0;
+        if (elapsed >= _resync_ticks.load(std::memory_order_relaxed))
+            _resync();
+
+        auto ns = anchor_ns + static_cast<int64_t>(static_cast<double>(elapsed) * ns_per_tick);
+        return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(ns)));
+    }
+
+private:
+    struct sample_t
+    {
+        uint64_t ticks;
+        int64_t wall_ns;
+        int64_t steady_ns;
+    };
+
+    // Both clocks read between two reads of the counter, taken at the middle
+    static sample_t _sample()
+    {
+        auto before = ticks();
+        auto wall = std::chrono::system_clock::now().time_since_epoch();
+        auto steady = std::chrono::steady_clock::now().time_since_epoch();
+        auto after = ticks();
+        return sample_t{ before + (after - before) / 2, std::chrono::duration_cast<std::chrono::nanoseconds>(wall).count(), std::chrono::duration_cast<std::chrono::nanoseconds>(steady).count() };
+    }
+
+    void _resync()
+    {
+        std::unique_lock<std::mutex> lock(_mutex, std::try_to_lock);
+        if (!lock.owns_lock())
+            return;
+
+        // another thread can have moved the anchor since it was read
+        auto current = _sample();
+        auto anchor = _anchor_ticks.load(std::memory_order_relaxed);
+        if (current.ticks < anchor || current.ticks - anchor < _resync_ticks.load(std::memory_order_relaxed))
+            return;
+        _publish(_last, current);
+    }
+
+    // Called with the mutex held
+    void _publish(const sample_t& from, const sample_t& to)
+    {
+        auto ns_per_tick = static_cast<double>(to.steady_ns - from.steady_ns) / static_cast<double>(to.ticks - from.ticks);
+        auto sequence = _sequence.load(std::memory_order_relaxed);
+        _sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        _anchor_ticks.store(to.ticks, std::memory_order_relaxed);
+        _anchor_ns.store(to.wall_ns, std::memory_order_relaxed);
+        _ns_per_tick.store(ns_per_tick, std::memory_order_relaxed);
+        _sequence.store(sequence + 2, std::memory_order_release);
+
+        _resync_ticks.store(static_cast<uint64_t>(static_cast<double>(_resync_ns.load(std::memory_order_relaxed)) / ns_per_tick), std::memory_order_relaxed);
+        _last = to;
+    }
+
+    std::atomic<uint32_t> _sequence{ 0 }; // odd while the anchor moves
+    std::atomic<uint64_t> _anchor_ticks{ 0 };
+    std::atomic<int64_t> _anchor_ns{ 0 };
+    std::atomic<double> _ns_per_tick{ 0 };
+    std::atomic<uint64_t> _resync_ticks{ std::numeric_limits<uint64_t>::max() };
+    std::atomic<int64_t> _resync_ns{ default_resync_interval.count() };
+
+    std::mutex _mutex;
+    sample_t _last{}; // sample the anchor was taken from
+};
+
+inline tsc_clock_t tsc_clock;
+} // namespace pride::log::internal
@@ -0,0 +1,227 @@
+#pragma once
+
+#include "../../config/detection/os.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(PRIDE_OS_LINUX) && defined(__has_include)
+#    if __has_include(<linux/io_uring.h>)
+#        define PRIDE_LOG_URING
+#    endif
+#endif
+
+#if defined(PRIDE_LOG_URING)
+#    include <cerrno>
+#    include <linux/io_uring.h>
+#    include <sys/mman.h>
+#    include <sys/syscall.h>
+#    include <sys/uio.h>
+#    include <unistd.h>
+#endif
+
+namespace pride::log::internal
+{
+#if defined(PRIDE_LOG_URING)
+// The part of io_uring the file channels use, spoken to through the raw
+// system calls so there is nothing to link. The submission side and the
+// completion side can be used from two different threads, each of them by
+// one thread at a time.
+class uring_t
+{
+public:
+    uring_t() = default;
+    uring_t(const uring_t&) = delete;
+    uring_t& operator=(const uring_t&) = delete;
+
+    ~uring_t()
+    {
+        close();
+    }
+
+    // Fails when the kernel has no io_uring or it is switched off
+    bool open(unsigned entries)
+    {
+        close();
+
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        auto fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0)
+            return false;
+        _fd = fd;
+
+        _sq_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        _cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single)
+            _sq_map_size = _cq_map_size = std::max(_sq_map_size, _cq_map_size);
+
+        _sq_map = _map(_sq_map_size, IORING_OFF_SQ_RING);
+        _cq_map = single ? _sq_map : _map(_cq_map_size, IORING_OFF_CQ_RING);
+        _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        _sqes = static_cast<io_uring_sqe*>(_map(_sqes_size, IORING_OFF_SQES));
+        if (!_sq_map || !_cq_map || !_sqes)
+        {
+            close();
+            return false;
+        }
+
+        auto sq = static_cast<char*>(_sq_map);
+        _sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        _sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        _sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        _sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        _sq_entries = params.sq_entries;
+        _sq_local_tail = *_sq_tail;
+
+        auto cq = static_cast<char*>(_cq_map);
+        _cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        _cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        _cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        _cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    void close()
+    {
+        if (_sqes)
+            ::munmap(_sqes, _sqes_size);
+        if (_cq_map && _cq_map != _sq_map)
+            ::munmap(_cq_map, _cq_map_size);
+        if (_sq_map)
+            ::munmap(_sq_map, _sq_map_size);
+        if (_fd >= 0)
+            ::close(_fd);
+
+        _sqes = nullptr;
+        _sq_map = _cq_map = nullptr;
+        _fd = -1;
+    }
+
+    bool is_open() const { return _fd >= 0; }
+
+    // Pins the buffers so IORING_OP_WRITE_FIXED can skip mapping them on
+    // every write. Fails when they go over RLIMIT_MEMLOCK.
+    bool register_buffers(const iovec* buffers, unsigned count)
+    {
+        return ::syscall(__NR_io_uring_register, _fd, IORING_REGISTER_BUFFERS, buffers, count) == 0;
+    }
+
+    // Whether the kernel knows the operation. Kernels older than 5.6 cannot
+    // be asked and only have the operations of the first io_uring (nop,
+    // readv, writev, fsync and the fixed buffer reads and writes).
+    bool supports(uint8_t opcode) const
+    {
+        constexpr unsigned count = 256;
+        alignas(io_uring_probe) char storage[sizeof(io_uring_probe) + count * sizeof(io_uring_probe_op)];
+        std::memset(storage, 0, sizeof(storage));
+        auto probe = reinterpret_cast<io_uring_probe*>(storage);
+        if (::syscall(__NR_io_uring_register, _fd, IORING_REGISTER_PROBE, probe, count) != 0)
+            return opcode <= IORING_OP_WRITE_FIXED;
+        return opcode <= probe->last_op && (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED) != 0;
+    }
+
+    // Cleared submission entry to fill in, nullptr when the queue is full
+    io_uring_sqe* next()
+    {
+        auto head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+        if (_sq_local_tail - head >= _sq_entries)
+            return nullptr;
+
+        auto index = _sq_local_tail & _sq_mask;
+        auto sqe = &_sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        _sq_array[index] = index;
+        ++_sq_local_tail;
+        return sqe;
+    }
+
+    // Hands the entries taken with next() to the kernel
+    bool submit()
+    {
+        auto pending = _sq_local_tail - *_sq_tail;
+        __atomic_store_n(_sq_tail, _sq_local_tail, __ATOMIC_RELEASE);
+        while (pending > 0)
+        {
+            auto taken = _enter(pending, 0, 0);
+            if (taken < 0)
+            {
+                // EBUSY means the completion queue is full, the reaper is
+                // already emptying it
+                if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+                    continue;
+                return false;
+            }
+            pending -= static_cast<unsigned>(taken);
+        }
+        return true;
+    }
+
+    // Calls `done(user_data, result)` for each completion there is. With
+    // `wait` it blocks until there is at least one. Returns how many there
+    // were, or -1 with errno set when the wait failed and no completion will
+    // come.
+    template<typename Done>
+    int reap(bool wait, Done&& done)
+    {
+        int count = 0;
+        for (;;)
+        {
+            auto head = *_cq_head;
+            auto tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+            if (head == tail)
+            {
+                if (count > 0 || !wait)
+                    return count;
+                // EAGAIN and EBUSY mean completions are held back in the
+                // overflow list, they are flushed once the queue is read
+                if (_enter(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+                    return -1;
+                continue;
+            }
+
+            for (; head != tail; ++head, ++count)
+            {
+                const auto& cqe = _cqes[head & _cq_mask];
+                done(cqe.user_data, cqe.res);
+            }
+            __atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+        }
+    }
+
+private:
+    void* _map(size_t size, uint64_t offset)
+    {
+        auto p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, static_cast<off_t>(offset));
+        return p == MAP_FAILED ? nullptr : p;
+    }
+
+    int _enter(unsigned submit, unsigned wait_for, unsigned flags)
+    {
+        return static_cast<int>(::syscall(__NR_io_uring_enter, _fd, submit, wait_for, flags, nullptr, 0));
+    }
+
+    int _fd = -1;
+
+    void* _sq_map = nullptr;
+    size_t _sq_map_size = 0;
+    unsigned* _sq_head = nullptr;
+    unsigned* _sq_tail = nullptr;
+    unsigned* _sq_array = nullptr;
+    unsigned _sq_mask = 0;
+    unsigned _sq_entries = 0;
+    unsigned _sq_local_tail = 0;
+    io_uring_sqe* _sqes = nullptr;
+    size_t _sqes_size = 0;
+
+    void* _cq_map = nullptr;
+    size_t _cq_map_size = 0;
+    unsigned* _cq_head = nullptr;
+    unsigned* _cq_tail = nullptr;
+    unsigned _cq_mask = 0;
+    io_uring_cqe* _cqes = nullptr;
+};
+#endif
+} // namespace pride::log::internal
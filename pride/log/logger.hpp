@@ -1,27 +1,63 @@
 
 #pragma once
 
+#include "../utility/scope_guard.hpp"
 #include "../utility/shareable.hpp"
 #include "channel.hpp"
 #include "fmt.hpp"
+#include "format_string.hpp"
+#include "internal/backtrace.hpp"
+#include "internal/flusher.hpp"
+#include "internal/limiter.hpp"
+#include "internal/message_pool.hpp"
+#include "internal/rcu.hpp"
+#include "internal/registry.hpp"
 #include "message.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
 namespace pride::log
 {
+// Snapshot of the record counters of a logger. Only loggers that queue their
+// records (async_logger_t) move these, a synchronous logger has nothing to
+// drop.
+struct logger_stats_t
+{
+    uint64_t enqueued{ 0 };
+    uint64_t dropped{ 0 };
+    uint64_t overwritten{ 0 };
+};
+
+class field_logger_t;
+
 class logger_t : public shareable<logger_t>
 {
 public:
     // using ptr = std::shared_ptr<logger_t>;
-    virtual ~logger_t() = default;
+    using channel_list_t = std::vector<channel_t::ptr>;
+
+    virtual ~logger_t();
 
     // ─────────────────────────────────────────────────────────────────
 
     static logger_t::ptr create(std::string name);
 
+    // Registered logger with this name or nullptr. Lookups do not lock and
+    // the logger stays registered until the end of the program. A string
+    // literal or a logger_key_t skips hashing the name, see PRIDE_LOGGER.
+    static logger_t* get(std::string_view name);
+    static logger_t* get(logger_key_t key);
+
+    template<size_t N>
+    static logger_t* get(const char (&name)[N]) { return get(logger_key_t(name)); }
+
     // ─────────────────────────────────────────────────────────────────
 
     template<typename... Args>
@@ -48,6 +84,51 @@ public:
     void crit(const char* fmt, const Args&... args);
 
     // ─────────────────────────────────────────────────────────────────
+    // Compile time format strings, see PRIDE_FMT
+
+    template<typename Holder, typename... Args>
+    void log(sevarity_t level, const format_string_t<Holder>& fmt, const Args&... args);
+
+    template<typename Holder, typename... Args>
+    void trace(const format_string_t<Holder>& fmt, const Args&... args);
+
+    template<typename Holder, typename... Args>
+    void debug(const format_string_t<Holder>& fmt, const Args&... args);
+
+    template<typename Holder, typename... Args>
+    void info(const format_string_t<Holder>& fmt, const Args&... args);
+
+    template<typename Holder, typename... Args>
+    void warn(const format_string_t<Holder>& fmt, const Args&... args);
+
+    template<typename Holder, typename... Args>
+    void error(const format_string_t<Holder>& fmt, const Args&... args);
+
+    template<typename Holder, typename... Args>
+    void crit(const format_string_t<Holder>& fmt, const Args&... args);
+
+    // ─────────────────────────────────────────────────────────────────
+    // Records with structured fields, see json_formatter_t and
+    // logfmt_formatter_t. logger.with({ { "user", name }, { "id", 42 } })
+    // returns a logger_t like view that adds the fields to every call.
+
+    template<typename... Args>
+    void log(sevarity_t level, fields_t fields, const char* fmt, const Args&... args);
+
+    field_logger_t with(fields_t fields);
+
+    // ─────────────────────────────────────────────────────────────────
+    // Records that carry their call site, see PRIDE_LOG
+
+    template<typename... Args>
+    void log(const source_location_t& source, sevarity_t level, const char* fmt, const Args&... args);
+
+    template<typename Holder, typename... Args>
+    void log(const source_location_t& source, sevarity_t level, const format_string_t<Holder>& fmt, const Args&... args);
+
+    // ─────────────────────────────────────────────────────────────────
+    // A single value. Limits key string literals on their address and other
+    // strings on their text, values that are not strings are never limited.
 
     template<typename T>
     void log(sevarity_t level, const T&);
@@ -73,17 +154,39 @@ public:
     // ─────────────────────────────────────────────────────────────────
 
     void flush();
-    bool should_log(sevarity_t level) { return level >= _sevarity; }
+    bool should_log(sevarity_t level) const { return level >= _sevarity.load(std::memory_order_relaxed); }
+
+    // True when a record is logged or kept for the backtrace
+    bool should_record(sevarity_t level) const { return should_log(level) || level >= _backtrace_level.load(std::memory_order_relaxed); }
+
+    // Keeps the last `records` records that are below the level of the
+    // logger, stored unformatted. They are logged ahead of the next record at
+    // or above `trigger` and by dump_backtrace.
+    logger_t& enable_backtrace(size_t records, sevarity_t trigger = sevarity_t::error);
+    logger_t& disable_backtrace();
+    void dump_backtrace();
+
+    // Rate limits and samples the records of every call site, see limits_t.
+    // The records a call site loses are counted and logged as one
+    // "suppressed N similar messages" record.
+    logger_t& limits(const limits_t& limits);
+    logger_t& clear_limits();
 
     template<typename Formatter, typename... Args>
     logger_t& set_formatter(const Args&&... args);
     logger_t& set_pattern(const std::string& pattern);
+    template<typename Holder>
+    logger_t& set_pattern(pattern_string_t<Holder> pattern);
 
     // ─────────────────────────────────────────────────────────────────
+    // The channel list, levels and formatters can change while other threads
+    // log. Logging never locks, it works on a snapshot of the channel list
+    // that is replaced as a whole and deleted once no thread uses it.
 
     template<typename Channel, typename... Args>
     logger_t& add_channel(Args&&... args);
     logger_t& add_channel(const channel_t::ptr& channel);
+    logger_t& remove_channel(const channel_t::ptr& channel);
 
     logger_t& name(std::string name)
     {
@@ -92,36 +195,77 @@ public:
     }
     logger_t& sevarity(sevarity_t level)
     {
-        _sevarity = level;
+        _sevarity.store(level, std::memory_order_relaxed);
         return *this;
     }
     logger_t& flush_on(sevarity_t level)
     {
-        _flush_on = level;
+        _flush_on.store(level, std::memory_order_relaxed);
         return *this;
     }
 
     // ─────────────────────────────────────────────────────────────────
 
     const std::string& name() { return _name; }
-    const std::vector<channel_t::ptr>& channels() { return _channels; }
-    sevarity_t sevarity() { return _sevarity; }
-    sevarity_t flush_on() { return _flush_on; }
+    channel_list_t channels() const;
+    sevarity_t sevarity() const { return _sevarity.load(std::memory_order_relaxed); }
+    sevarity_t flush_on() const { return _flush_on.load(std::memory_order_relaxed); }
+
+    logger_stats_t stats() const;
+    void reset_stats();
 
     // private:
     logger_t(std::string name);
     logger_t(const logger_t&) = delete;
     logger_t& operator=(const logger_t&) = delete;
 
-private:
-    virtual void _proecss(const message_t& msg);
+protected:
+    static void _register(const logger_t::ptr& logger);
+
+    virtual void _proecss(message_ptr& msg);
     virtual void _flush();
 
-    inline static std::unordered_map<std::string, logger_t::ptr> _loggers;
+    void _dispatch(const message_t& msg);
+
+    // Decides what happens to a record before it is formatted. Returns false
+    // when the record is not logged, it may still go to the backtrace.
+    template<typename Format, typename... Args>
+    bool _admit(sevarity_t level, const source_location_t* source, const Format& format, const Args&... args);
+
+    // Derived loggers stop the thread that reports suppressed records before
+    // they tear down what _proecss uses
+    void _stop_reporting() { _reporter.stop(); }
+
+    struct counters_t
+    {
+        alignas(64) std::atomic<uint64_t> enqueued{ 0 };
+        std::atomic<uint64_t> dropped{ 0 };
+        std::atomic<uint64_t> overwritten{ 0 };
+    };
+    counters_t _counters;
+
+private:
+    // publishes `channels` and retires the current list, under _config_mutex
+    void _replace_channels(const channel_list_t* channels);
+
     std::string _name;
-    std::vector<channel_t::ptr> _channels;
-    sevarity_t _sevarity{ sevarity_t::info };
-    sevarity_t _flush_on{ sevarity_t::off };
+    std::atomic<const channel_list_t*> _channels;
+    std::atomic<sevarity_t> _sevarity{ sevarity_t::info };
+    std::atomic<sevarity_t> _flush_on{ sevarity_t::off };
+
+    // off while there is no backtrace
+    std::atomic<sevarity_t> _backtrace_level{ sevarity_t::off };
+    std::atomic<sevarity_t> _backtrace_trigger{ sevarity_t::off };
+    std::atomic<internal::backtrace_t*> _backtrace{ nullptr };
+
+    void _log_suppressed(sevarity_t level, const source_location_t* source, std::string_view text, uint64_t count);
+    void _report_suppressed();
+
+    std::atomic<internal::limiter_t*> _limiter{ nullptr };
+    internal::periodic_flusher_t _reporter;
+
+    // serializes the changes to the channel list
+    std::mutex _config_mutex;
 };
 
 // ────────────────────────────────────────────────────────────────────────────────
@@ -129,39 +273,103 @@ private:
 inline logger_t::ptr logger_t::create(std::string name)
 {
     auto instance = logger_t::make_new(std::move(name));
-    _loggers.insert({ name, instance });
+    _register(instance);
     return instance;
 }
 
+inline logger_t* logger_t::get(std::string_view name)
+{
+    return internal::registry_t::instance().find(name);
+}
+
+inline logger_t* logger_t::get(logger_key_t key)
+{
+    return internal::registry_t::instance().find(key);
+}
+
 // ────────────────────────────────────────────────────────────────────────────────
 
 inline logger_t::logger_t(std::string name)
     : _name(std::move(name))
+    , _channels(new channel_list_t())
 {
 }
 
+inline logger_t::~logger_t()
+{
+    _reporter.stop();
+    delete _limiter.load(std::memory_order_relaxed);
+    delete _channels.load(std::memory_order_relaxed);
+    delete _backtrace.load(std::memory_order_relaxed);
+}
+
+inline void logger_t::_register(const logger_t::ptr& logger)
+{
+    internal::registry_t::instance().insert(logger->name(), logger);
+}
+
+// ────────────────────────────────────────────────────────────────────────────────
+
+template<typename Format, typename... Args>
+bool logger_t::_admit(sevarity_t level, const source_location_t* source, const Format& format, const Args&... args)
+{
+    if (!should_log(level))
+    {
+        if (level >= _backtrace_level.load(std::memory_order_relaxed))
+        {
+            internal::rcu_t::read_guard_t guard;
+            if (auto backtrace = _backtrace.load(std::memory_order_seq_cst))
+            {
+                if constexpr (std::is_same_v<Format, internal::value_site_t>)
+                    backtrace->push(level, source, "{}", args...);
+                else
+                    backtrace->push(level, source, format, args...);
+            }
+        }
+        return false;
+    }
+
+    // statements of the macros are keyed on their call site, others on the
+    // address of their format string, see internal::value_site for the rest
+    uint64_t suppressed = 0;
+    if (_limiter.load(std::memory_order_relaxed))
+    {
+        internal::rcu_t::read_guard_t guard;
+        auto limiter = _limiter.load(std::memory_order_seq_cst);
+        const void* site = source ? static_cast<const void*>(source) : internal::site_of(format);
+        if (limiter && !limiter->admit(site, level, source, format, suppressed))
+            return false;
+    }
+
+    if (level >= _backtrace_trigger.load(std::memory_order_relaxed))
+        dump_backtrace();
+    if (suppressed > 0)
+        _log_suppressed(level, source, {}, suppressed);
+    return true;
+}
+
 // ────────────────────────────────────────────────────────────────────────────────
 
 template<typename... Args>
 void logger_t::log(sevarity_t level, const char* msg, const Args&... args)
 {
-    if (!should_log(level))
+    if (!_admit(level, nullptr, msg, args...))
         return;
 
     // try to log and catch std::exception and anything else
-    message_t message(&_name, level);
-    fmt::format_to(message.raw, msg, args...);
+    auto message = internal::message_pool_t::acquire(&_name, level);
+    fmt::format_to(message->raw, msg, args...);
     _proecss(message);
 }
 
 inline void logger_t::log(sevarity_t level, const char* msg)
 {
-    if (!should_log(level))
+    if (!_admit(level, nullptr, internal::value_site(msg), msg))
         return;
 
     // try to log and catch std::exception and anything else
-    message_t message(&_name, level);
-    fmt::format_to(message.raw, "{}", msg);
+    auto message = internal::message_pool_t::acquire(&_name, level);
+    fmt::format_to(message->raw, "{}", msg);
     _proecss(message);
 }
 
@@ -203,14 +411,143 @@ void logger_t::crit(const char* fmt, const Args&... args)
 
 // ────────────────────────────────────────────────────────────────────────────────
 
+template<typename Holder, typename... Args>
+void logger_t::log(sevarity_t level, const format_string_t<Holder>& fmt, const Args&... args)
+{
+    if (!_admit(level, nullptr, std::string_view(fmt.c_str(), fmt.size()), args...))
+        return;
+
+    auto message = internal::message_pool_t::acquire(&_name, level);
+    format_string_t<Holder>::format(message->raw, args...);
+    _proecss(message);
+}
+
+template<typename Holder, typename... Args>
+void logger_t::trace(const format_string_t<Holder>& fmt, const Args&... args)
+{
+    log(sevarity_t::trace, fmt, args...);
+}
+
+template<typename Holder, typename... Args>
+void logger_t::debug(const format_string_t<Holder>& fmt, const Args&... args)
+{
+    log(sevarity_t::debug, fmt, args...);
+}
+
+template<typename Holder, typename... Args>
+void logger_t::info(const format_string_t<Holder>& fmt, const Args&... args)
+{
+    log(sevarity_t::info, fmt, args...);
+}
+
+template<typename Holder, typename... Args>
+void logger_t::warn(const format_string_t<Holder>& fmt, const Args&... args)
+{
+    log(sevarity_t::warn, fmt, args...);
+}
+
+template<typename Holder, typename... Args>
+void logger_t::error(const format_string_t<Holder>& fmt, const Args&... args)
+{
+    log(sevarity_t::error, fmt, args...);
+}
+
+template<typename Holder, typename... Args>
+void logger_t::crit(const format_string_t<Holder>& fmt, const Args&... args)
+{
+    log(sevarity_t::critical, fmt, args...);
+}
+
+// ────────────────────────────────────────────────────────────────────────────────
+
+template<typename... Args>
+void logger_t::log(const source_location_t& source, sevarity_t level, const char* msg, const Args&... args)
+{
+    if (!_admit(level, &source, msg, args...))
+        return;
+
+    auto message = internal::message_pool_t::acquire(&_name, level);
+    message->source = &source;
+    fmt::format_to(message->raw, msg, args...);
+    _proecss(message);
+}
+
+template<typename Holder, typename... Args>
+void logger_t::log(const source_location_t& source, sevarity_t level, const format_string_t<Holder>& fmt, const Args&... args)
+{
+    if (!_admit(level, &source, std::string_view(fmt.c_str(), fmt.size()), args...))
+        return;
+
+    auto message = internal::message_pool_t::acquire(&_name, level);
+    message->source = &source;
+    format_string_t<Holder>::format(message->raw, args...);
+    _proecss(message);
+}
+
+// ────────────────────────────────────────────────────────────────────────────────
+
+template<typename... Args>
+void logger_t::log(sevarity_t level, fields_t fields, const char* msg, const Args&... args)
+{
+    if (!_admit(level, nullptr, msg, args...))
+        return;
+
+    auto message = internal::message_pool_t::acquire(&_name, level);
+    message->fields.add(fields);
+    fmt::format_to(message->raw, msg, args...);
+    _proecss(message);
+}
+
+// Only lives for the statement it is used in, it keeps a view of the fields
+class field_logger_t
+{
+public:
+    field_logger_t(logger_t& logger, fields_t fields)
+        : _logger(logger)
+        , _fields(fields)
+    {}
+
+    template<typename... Args>
+    void log(sevarity_t level, const char* fmt, const Args&... args) { _logger.log(level, _fields, fmt, args...); }
+
+    template<typename... Args>
+    void trace(const char* fmt, const Args&... args) { log(sevarity_t::trace, fmt, args...); }
+
+    template<typename... Args>
+    void debug(const char* fmt, const Args&... args) { log(sevarity_t::debug, fmt, args...); }
+
+    template<typename... Args>
+    void info(const char* fmt, const Args&... args) { log(sevarity_t::info, fmt, args...); }
+
+    template<typename... Args>
+    void warn(const char* fmt, const Args&... args) { log(sevarity_t::warn, fmt, args...); }
+
+    template<typename... Args>
+    void error(const char* fmt, const Args&... args) { log(sevarity_t::error, fmt, args...); }
+
+    template<typename... Args>
+    void crit(const char* fmt, const Args&... args) { log(sevarity_t::critical, fmt, args...); }
+
+private:
+    logger_t& _logger;
+    fields_t _fields;
+};
+
+inline field_logger_t logger_t::with(fields_t fields)
+{
+    return field_logger_t(*this, fields);
+}
+
+// ────────────────────────────────────────────────────────────────────────────────
+
 template<typename T>
 void logger_t::log(sevarity_t level, const T& value)
 {
-    if (!should_log(level))
+    if (!_admit(level, nullptr, internal::value_site(value), value))
         return;
 
-    message_t message(&_name, level);
-    fmt::format_to(message.raw, "{}", value);
+    auto message = internal::message_pool_t::acquire(&_name, level);
+    fmt::format_to(message->raw, "{}", value);
     _proecss(message);
 }
 
@@ -223,25 +560,25 @@ void logger_t::trace(const T& msg)
 template<typename T>
 void logger_t::debug(const T& msg)
 {
-    log(sevarity_t::trace, msg);
+    log(sevarity_t::debug, msg);
 }
 
 template<typename T>
 void logger_t::info(const T& msg)
 {
-    log(sevarity_t::trace, msg);
+    log(sevarity_t::info, msg);
 }
 
 template<typename T>
 void logger_t::warn(const T& msg)
 {
-    log(sevarity_t::trace, msg);
+    log(sevarity_t::warn, msg);
 }
 
 template<typename T>
 void logger_t::error(const T& msg)
 {
-    log(sevarity_t::trace, msg);
+    log(sevarity_t::error, msg);
 }
 
 template<typename T>
@@ -255,20 +592,44 @@ void logger_t::crit(const T& msg)
 template<typename Channel, typename... Args>
 logger_t& logger_t::add_channel(Args&&... args)
 {
-    _channels.push_back(std::make_shared<Channel>(std::forward<Args>(args)...));
-    return *this;
+    return add_channel(std::make_shared<Channel>(std::forward<Args>(args)...));
 }
 
 inline logger_t& logger_t::add_channel(const channel_t::ptr& channel)
 {
-    _channels.push_back(channel);
+    std::lock_guard<std::mutex> lock(_config_mutex);
+    auto channels = new channel_list_t(*_channels.load(std::memory_order_relaxed));
+    channels->push_back(channel);
+    _replace_channels(channels);
     return *this;
 }
 
+inline logger_t& logger_t::remove_channel(const channel_t::ptr& channel)
+{
+    std::lock_guard<std::mutex> lock(_config_mutex);
+    auto channels = new channel_list_t(*_channels.load(std::memory_order_relaxed));
+    channels->erase(std::remove(channels->begin(), channels->end(), channel), channels->end());
+    _replace_channels(channels);
+    return *this;
+}
+
+inline logger_t::channel_list_t logger_t::channels() const
+{
+    internal::rcu_t::read_guard_t guard;
+    return *_channels.load(std::memory_order_seq_cst);
+}
+
+inline void logger_t::_replace_channels(const channel_list_t* channels)
+{
+    auto old = _channels.exchange(channels, std::memory_order_seq_cst);
+    internal::rcu_t::instance().retire(old);
+}
+
 template<typename Formatter, typename... Args>
 logger_t& logger_t::set_formatter(const Args&&... args)
 {
-    for (auto& channel : _channels)
+    internal::rcu_t::read_guard_t guard;
+    for (auto& channel : *_channels.load(std::memory_order_seq_cst))
     {
         auto fmt = std::make_unique<Formatter>(std::forward<Args>(args)...);
         channel->formatter(std::move(fmt));
@@ -278,16 +639,145 @@ logger_t& logger_t::set_formatter(const Args&&... args)
 
 inline logger_t& logger_t::set_pattern(const std::string& pattern)
 {
-    for (auto& channel : _channels)
+    internal::rcu_t::read_guard_t guard;
+    for (auto& channel : *_channels.load(std::memory_order_seq_cst))
+        channel->pattern(pattern);
+    return *this;
+}
+
+template<typename Holder>
+logger_t& logger_t::set_pattern(pattern_string_t<Holder> pattern)
+{
+    internal::rcu_t::read_guard_t guard;
+    for (auto& channel : *_channels.load(std::memory_order_seq_cst))
         channel->pattern(pattern);
     return *this;
 }
 
 // ────────────────────────────────────────────────────────────────────────────────
 
-inline void logger_t::_proecss(const message_t& msg)
+inline logger_t& logger_t::enable_backtrace(size_t records, sevarity_t trigger)
+{
+    std::lock_guard<std::mutex> lock(_config_mutex);
+    auto old = _backtrace.exchange(new internal::backtrace_t(records), std::memory_order_seq_cst);
+    internal::rcu_t::instance().retire(old);
+    _backtrace_trigger.store(trigger, std::memory_order_relaxed);
+    _backtrace_level.store(sevarity_t::trace, std::memory_order_relaxed);
+    return *this;
+}
+
+inline logger_t& logger_t::disable_backtrace()
+{
+    std::lock_guard<std::mutex> lock(_config_mutex);
+    _backtrace_level.store(sevarity_t::off, std::memory_order_relaxed);
+    _backtrace_trigger.store(sevarity_t::off, std::memory_order_relaxed);
+    auto old = _backtrace.exchange(nullptr, std::memory_order_seq_cst);
+    internal::rcu_t::instance().retire(old);
+    return *this;
+}
+
+inline void logger_t::dump_backtrace()
+{
+    internal::rcu_t::read_guard_t guard;
+    auto backtrace = _backtrace.load(std::memory_order_seq_cst);
+    if (!backtrace)
+        return;
+
+    for (auto& record : backtrace->drain(&_name))
+        _proecss(record);
+}
+
+inline logger_t& logger_t::limits(const limits_t& limits)
+{
+    std::lock_guard<std::mutex> lock(_config_mutex);
+    _reporter.stop();
+    auto old = _limiter.exchange(new internal::limiter_t(limits), std::memory_order_seq_cst);
+    internal::rcu_t::instance().retire(old);
+    _reporter.start(limits.report, [this] { _report_suppressed(); });
+    return *this;
+}
+
+inline logger_t& logger_t::clear_limits()
+{
+    std::lock_guard<std::mutex> lock(_config_mutex);
+    _reporter.stop();
+    auto old = _limiter.exchange(nullptr, std::memory_order_seq_cst);
+    internal::rcu_t::instance().retire(old);
+    return *this;
+}
+
+inline void logger_t::_log_suppressed(sevarity_t level, const source_location_t* source, std::string_view text, uint64_t count)
 {
-    for (auto& channel : _channels)
+    auto message = internal::message_pool_t::acquire(&_name, level);
+    message->source = source;
+    fmt::format_to(message->raw, "suppressed {} similar messages", count);
+    if (!text.empty())
+        fmt::format_to(message->raw, ": {}", fmt::string_view(text.data(), text.size()));
+    _proecss(message);
+}
+
+inline void logger_t::_report_suppressed()
+{
+    internal::rcu_t::read_guard_t guard;
+    if (auto limiter = _limiter.load(std::memory_order_seq_cst))
+    {
+        limiter->report([this](sevarity_t level, const source_location_t* source, std::string_view text, uint64_t count) {
+            _log_suppressed(level, source, text, count);
+        });
+    }
+}
+
+// ────────────────────────────────────────────────────────────────────────────────
+
+inline logger_stats_t logger_t::stats() const
+{
+    logger_stats_t result;
+    result.enqueued = _counters.enqueued.load(std::memory_order_relaxed);
+    result.dropped = _counters.dropped.load(std::memory_order_relaxed);
+    result.overwritten = _counters.overwritten.load(std::memory_order_relaxed);
+    return result;
+}
+
+inline void logger_t::reset_stats()
+{
+    _counters.enqueued.store(0, std::memory_order_relaxed);
+    _counters.dropped.store(0, std::memory_order_relaxed);
+    _counters.overwritten.store(0, std::memory_order_relaxed);
+}
+
+// ────────────────────────────────────────────────────────────────────────────────
+
+inline void logger_t::flush()
+{
+    _flush();
+}
+
+// ────────────────────────────────────────────────────────────────────────────────
+
+inline void logger_t::_proecss(message_ptr& msg)
+{
+    _dispatch(*msg);
+}
+
+inline void logger_t::_dispatch(const message_t& msg)
+{
+    // text of every distinct format signature seen for this record, formatted
+    // by the first channel of the group and handed to the others
+    constexpr size_t max_groups = 8;
+    static thread_local fmt::memory_buffer formatted[max_groups];
+    static thread_local bool dispatching = false;
+
+    // a channel that logs from inside its own log call must not overwrite
+    // the text the outer record is still handing out
+    const bool share = !dispatching;
+    dispatching = true;
+    defer { dispatching = !share; };
+
+    const std::string* groups[max_groups];
+    size_t group_count = 0;
+
+    internal::rcu_t::read_guard_t guard;
+    for (auto& channel : *_channels.load(std::memory_order_seq_cst))
     {
         auto level = msg.sevarity;
 
@@ -295,16 +785,102 @@ inline void logger_t::_proecss(const message_t& msg)
         // if so then also check if it should log.
         // or if the logger's level should log.
         // then we can log it to the channel
-        if ((channel->use_sevarity() && channel->should_log(level)) || should_log(level))
+        // records replayed from the backtrace go to every channel
+        if (!msg.backtrace && !((channel->use_sevarity() && channel->should_log(level)) || should_log(level)))
+            continue;
+
+        const auto& signature = channel->format_signature();
+        if (!share || signature.empty())
+        {
+            channel->log(msg);
+            continue;
+        }
+
+        size_t group = 0;
+        while (group < group_count && *groups[group] != signature)
+            ++group;
+
+        if (group < group_count)
+            channel->log_formatted(msg, formatted[group]);
+        else if (group_count == max_groups)
             channel->log(msg);
+        else
+        {
+            // grouped under the signature the text was made with, the
+            // formatter can have been replaced since the lookup above
+            formatted[group].resize(0);
+            if (auto used = channel->format_and_log(msg, formatted[group]))
+                groups[group_count++] = used;
+        }
     }
 }
 
 inline void logger_t::_flush()
 {
-    for (auto& channel : _channels)
+    internal::rcu_t::read_guard_t guard;
+    for (auto& channel : *_channels.load(std::memory_order_seq_cst))
         channel->flush();
 }
 
 // ────────────────────────────────────────────────────────────────────────────────
 } // namespace pride::log
+
+// Registered logger for a string literal name, hashed at compile time so the
+// lookup is a single probe of the registry
+#define PRIDE_LOGGER(name) \
+    ::pride::log::logger_t::get(::pride::log::logger_key_t(std::integral_constant<::pride::hash_t, ::pride::log::logger_key_t(name).value>::value, name))
+
+// Levels below this one are compiled out of the PRIDE_LOG_<LEVEL> macros, the
+// arguments of those statements are not even compiled
+#if !defined(PRIDE_LOG_ACTIVE_LEVEL)
+#    define PRIDE_LOG_ACTIVE_LEVEL PRIDE_LOG_LEVEL_TRACE
+#endif
+
+// Logs with the file, line and function of the statement. The arguments are
+// only evaluated when the logger takes the level.
+#define PRIDE_LOG(logger, level, ...)                                                                          \
+    do                                                                                                         \
+    {                                                                                                          \
+        auto& pride_log_logger = (logger);                                                                     \
+        if (pride_log_logger.should_record(level))                                                             \
+        {                                                                                                      \
+            static constexpr ::pride::log::source_location_t pride_log_source{ __FILE__, __LINE__, __func__ }; \
+            pride_log_logger.log(pride_log_source, level, __VA_ARGS__);                                        \
+        }                                                                                                      \
+    } while (false)
+
+#if PRIDE_LOG_ACTIVE_LEVEL <= PRIDE_LOG_LEVEL_TRACE
+#    define PRIDE_LOG_TRACE(logger, ...) PRIDE_LOG(logger, ::pride::log::sevarity_t::trace, __VA_ARGS__)
+#else
+#    define PRIDE_LOG_TRACE(logger, ...) (void)0
+#endif
+
+#if PRIDE_LOG_ACTIVE_LEVEL <= PRIDE_LOG_LEVEL_DEBUG
+#    define PRIDE_LOG_DEBUG(logger, ...) PRIDE_LOG(logger, ::pride::log::sevarity_t::debug, __VA_ARGS__)
+#else
+#    define PRIDE_LOG_DEBUG(logger, ...) (void)0
+#endif
+
+#if PRIDE_LOG_ACTIVE_LEVEL <= PRIDE_LOG_LEVEL_INFO
+#    define PRIDE_LOG_INFO(logger, ...) PRIDE_LOG(logger, ::pride::log::sevarity_t::info, __VA_ARGS__)
+#else
+#    define PRIDE_LOG_INFO(logger, ...) (void)0
+#endif
+
+#if PRIDE_LOG_ACTIVE_LEVEL <= PRIDE_LOG_LEVEL_WARN
+#    define PRIDE_LOG_WARN(logger, ...) PRIDE_LOG(logger, ::pride::log::sevarity_t::warn, __VA_ARGS__)
+#else
+#    define PRIDE_LOG_WARN(logger, ...) (void)0
+#endif
+
+#if PRIDE_LOG_ACTIVE_LEVEL <= PRIDE_LOG_LEVEL_ERROR
+#    define PRIDE_LOG_ERROR(logger, ...) PRIDE_LOG(logger, ::pride::log::sevarity_t::error, __VA_ARGS__)
+#else
+#    define PRIDE_LOG_ERROR(logger, ...) (void)0
+#endif
+
+#if PRIDE_LOG_ACTIVE_LEVEL <= PRIDE_LOG_LEVEL_CRITICAL
+#    define PRIDE_LOG_CRIT(logger, ...) PRIDE_LOG(logger, ::pride::log::sevarity_t::critical, __VA_ARGS__)
+#else
+#    define PRIDE_LOG_CRIT(logger, ...) (void)0
+#endif
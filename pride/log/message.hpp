@@ -1,6 +1,6 @@
-
 #pragma once
 
+#include "field.hpp"
 #include "fmt.hpp"
 #include "internal/thread.hpp"
 #include "internal/time.hpp"
@@ -10,6 +10,15 @@
 
 namespace pride::log
 {
+// Where a record was logged from. The PRIDE_LOG_* macros keep one in a static
+// for each call site so a record only carries a pointer to it.
+struct source_location_t
+{
+    const char* file{ nullptr };
+    int line{ 0 };
+    const char* function{ nullptr };
+};
+
 struct message_t
 {
     message_t() = default;
@@ -18,18 +27,37 @@ struct message_t
     message_t(const message_t&) = delete;
     message_t& operator=(const message_t&) = delete;
 
+    message_t(message_t&&) = default;
+    message_t& operator=(message_t&&) = default;
+
+    // Prepare the message for a new record. The raw buffer keeps the capacity
+    // it has grown to so a recycled message does not allocate again.
+    void reset(const std::string* logger_names, sevarity_t level);
+
     const std::string* names{ nullptr };
-    sevarity_t sevarity;
+    sevarity_t sevarity{ sevarity_t::off };
     std::chrono::system_clock::time_point time;
-    size_t thread_id;
+    size_t thread_id{ 0 };
+    const source_location_t* source{ nullptr };
+    bool backtrace{ false }; // replayed from the backtrace of the logger
     fmt::memory_buffer raw;
+    field_list_t fields;
 };
 
 inline message_t::message_t(const std::string* names, sevarity_t level)
-    : names(names)
-    , sevarity(level)
 {
+    reset(names, level);
+}
+
+inline void message_t::reset(const std::string* logger_names, sevarity_t level)
+{
+    names = logger_names;
+    sevarity = level;
     time = internal::now();
     thread_id = internal::thread_id();
+    source = nullptr;
+    backtrace = false;
+    raw.resize(0);
+    fields.clear();
 }
 } // namespace pride::log
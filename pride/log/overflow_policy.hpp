@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+namespace pride::log
+{
+// What a producer does when the queue of an async logger or an isolated
+// channel is full
+enum class overflow_policy_t : uint8_t
+{
+    block,           // wait until a worker makes room
+    drop_newest,     // discard the record that is being logged
+    overwrite_oldest // discard the oldest queued record to make room
+};
+} // namespace pride::log
@@ -6,17 +6,26 @@
 #include <string>
 #include <unordered_map>
 
+// Numeric levels for the preprocessor, see PRIDE_LOG_ACTIVE_LEVEL
+#define PRIDE_LOG_LEVEL_TRACE 0
+#define PRIDE_LOG_LEVEL_DEBUG 1
+#define PRIDE_LOG_LEVEL_INFO 2
+#define PRIDE_LOG_LEVEL_WARN 3
+#define PRIDE_LOG_LEVEL_ERROR 4
+#define PRIDE_LOG_LEVEL_CRITICAL 5
+#define PRIDE_LOG_LEVEL_OFF 6
+
 namespace pride::log
 {
 enum class sevarity_t // : uint8_t
 {
-    trace = 0,
-    info = 1,
-    debug = 2,
-    warn = 3,
-    error = 4,
-    critical = 5,
-    off = 6
+    trace = PRIDE_LOG_LEVEL_TRACE,
+    debug = PRIDE_LOG_LEVEL_DEBUG,
+    info = PRIDE_LOG_LEVEL_INFO,
+    warn = PRIDE_LOG_LEVEL_WARN,
+    error = PRIDE_LOG_LEVEL_ERROR,
+    critical = PRIDE_LOG_LEVEL_CRITICAL,
+    off = PRIDE_LOG_LEVEL_OFF
 };
 
 namespace internal
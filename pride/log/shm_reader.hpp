@@ -0,0 +1,188 @@
+#pragma once
+
+#include "../os/shared_memory.hpp"
+#include "internal/shm_format.hpp"
+#include "message.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_set>
+
+namespace pride::log
+{
+// Collector side of channels::shm_ring. Takes the records out of the ring in
+// the order they were logged and frees their space for the writer. Only one
+// reader may drain a ring at a time.
+//
+// Records the writer had no room for still used up a sequence number, the
+// reader counts the gaps as missed. A record with a size that cannot be right
+// (the ring was overwritten by something else) makes the reader skip all that
+// is in the ring.
+class shm_reader_t
+{
+public:
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    explicit shm_reader_t(std::string name)
+        : _name(std::move(name))
+    {}
+
+    shm_reader_t(const shm_reader_t&) = delete;
+    shm_reader_t& operator=(const shm_reader_t&) = delete;
+
+    // True once the ring exists and its header checks out, a collector that
+    // starts before the writer calls it until then
+    bool attach()
+    {
+        if (_header != nullptr)
+            return true;
+        if (!_memory.open(_name))
+            return false;
+
+        auto header = reinterpret_cast<internal::shm::header_t*>(_memory.data());
+        if (_memory.size() < internal::shm::header_size || !internal::shm::valid(*header, _memory.size()))
+        {
+            _memory.close();
+            return false;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        _header = header;
+        _records = _memory.data() + internal::shm::header_size;
+        return true;
+    }
+
+    bool attached() const { return _header != nullptr; }
+    const std::string& name() const { return _name; }
+
+    // Calls fn(const message_t&) for at most `max` records that are in the
+    // ring, oldest first. Returns the number of records.
+    template<typename Fn>
+    size_t drain(Fn&& fn, size_t max = npos)
+    {
+        if (!attach())
+            return 0;
+
+        auto capacity = _header->capacity;
+        auto mask = capacity - 1;
+        auto write = _header->write.load(std::memory_order_acquire);
+        auto read = _header->read.load(std::memory_order_relaxed);
+
+        size_t count = 0;
+        while (read < write && count < max)
+        {
+            auto offset = read & mask;
+            auto at = _records + offset;
+
+            internal::shm::record_t record;
+            std::memcpy(&record, at, internal::shm::wrap_size);
+            if (record.kind == internal::shm::record_kind_t::wrap)
+            {
+                read += capacity - offset;
+                _header->read.store(read, std::memory_order_release);
+                continue;
+            }
+
+            std::memcpy(&record, at, sizeof(record));
+            auto end = sizeof(record) + size_t(record.name_length) + record.file_length + record.function_length + record.length;
+            if (record.kind != internal::shm::record_kind_t::record || record.size < end || record.size > write - read || offset + record.size > capacity)
+            {
+                _corrupt += write - read;
+                _header->read.store(write, std::memory_order_release);
+                break;
+            }
+
+            if (_next_sequence != no_sequence && record.sequence > _next_sequence)
+                _missed += record.sequence - _next_sequence;
+            _next_sequence = record.sequence + 1;
+
+            _fill(record, at + sizeof(record));
+            fn(static_cast<const message_t&>(_msg));
+
+            read += record.size;
+            _header->read.store(read, std::memory_order_release);
+            ++count;
+        }
+        return count;
+    }
+
+    // Blocks until the writer adds a record or `timeout` passed, returns at
+    // once when records are waiting. The writer wakes the reader on Linux,
+    // elsewhere the reader looks every millisecond.
+    void wait(std::chrono::milliseconds timeout)
+    {
+        if (!attach())
+        {
+            std::this_thread::sleep_for(timeout);
+            return;
+        }
+        internal::shm::park(*_header, _header->read.load(std::memory_order_relaxed), timeout);
+    }
+
+    // Bytes waiting in the ring
+    uint64_t pending() const
+    {
+        if (_header == nullptr)
+            return 0;
+        return _header->write.load(std::memory_order_acquire) - _header->read.load(std::memory_order_relaxed);
+    }
+
+    // Records the writer dropped between the ones this reader saw
+    uint64_t missed() const { return _missed; }
+
+    // Bytes skipped because they did not look like records
+    uint64_t corrupt() const { return _corrupt; }
+
+private:
+    static constexpr uint64_t no_sequence = std::numeric_limits<uint64_t>::max();
+
+    // strings the messages point to stay put in node based containers
+    const std::string* _intern(const char* data, size_t size)
+    {
+        return &*_strings.emplace(data, size).first;
+    }
+
+    void _fill(const internal::shm::record_t& record, const char* data)
+    {
+        _msg.names = _intern(data, record.name_length);
+        data += record.name_length;
+
+        _msg.source = nullptr;
+        if (record.file_length > 0 || record.function_length > 0 || record.line > 0)
+        {
+            auto file = _intern(data, record.file_length);
+            auto function = _intern(data + record.file_length, record.function_length);
+            auto& source = _sources[{ file, function, record.line }];
+            source.file = file->c_str();
+            source.function = function->c_str();
+            source.line = static_cast<int>(record.line);
+            _msg.source = &source;
+        }
+        data += record.file_length + record.function_length;
+
+        _msg.sevarity = static_cast<sevarity_t>(record.level);
+        _msg.time = std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(record.time)));
+        _msg.thread_id = static_cast<size_t>(record.thread);
+        _msg.raw.resize(record.length);
+        std::memcpy(_msg.raw.data(), data, record.length);
+    }
+
+    std::string _name;
+    os::shared_memory_t _memory;
+    internal::shm::header_t* _header{ nullptr };
+    const char* _records{ nullptr };
+
+    message_t _msg;
+    std::unordered_set<std::string> _strings;
+    std::map<std::tuple<const std::string*, const std::string*, uint32_t>, source_location_t> _sources;
+    uint64_t _next_sequence{ no_sequence };
+    uint64_t _missed{ 0 };
+    uint64_t _corrupt{ 0 };
+};
+} // namespace pride::log
@@ -0,0 +1,462 @@
+#pragma once
+
+#include "../config/detection/compiler.hpp"
+#include "fmt.hpp"
+#include "formatter.hpp"
+#include "message.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <string_view>
+
+#if defined(__AVX2__)
+#    define PRIDE_LOG_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define PRIDE_LOG_SSE2
+#endif
+
+#if defined(PRIDE_COMPILER_MSVC)
+#    include <intrin.h>
+#elif defined(PRIDE_LOG_SSE2) || defined(PRIDE_LOG_AVX2)
+#    include <immintrin.h>
+#endif
+
+namespace pride::log
+{
+namespace internal
+{
+    inline unsigned first_set_bit(uint32_t mask)
+    {
+#if defined(PRIDE_COMPILER_MSVC)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+    }
+
+    // Bytes that have to be escaped in a JSON string. Logfmt values also have
+    // to be quoted when they contain a space or an equal sign.
+    template<bool Logfmt>
+    inline bool needs_escape(unsigned char c)
+    {
+        return c <= 0x1F || c == '"' || c == '\\' || (Logfmt && (c == ' ' || c == '='));
+    }
+
+    // Offset of the first byte of `data` that needs_escape, or `size` when
+    // there is none. Text is scanned 32 bytes at a time with AVX2, 16 bytes at
+    // a time with SSE2 and the tail one byte at a time.
+    template<bool Logfmt>
+    inline size_t find_escape(const char* data, size_t size)
+    {
+        size_t i = 0;
+#if defined(PRIDE_LOG_AVX2)
+        {
+            const auto control = _mm256_set1_epi8(0x1F);
+            const auto quote = _mm256_set1_epi8('"');
+            const auto backslash = _mm256_set1_epi8('\\');
+            const auto space = _mm256_set1_epi8(' ');
+            const auto equal = _mm256_set1_epi8('=');
+            for (; i + 32 <= size; i += 32)
+            {
+                auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                auto hit = _mm256_cmpeq_epi8(_mm256_max_epu8(v, control), control);
+                hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(v, quote));
+                hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(v, backslash));
+                if constexpr (Logfmt)
+                {
+                    hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(v, space));
+                    hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(v, equal));
+                }
+                if (auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit)))
+                    return i + first_set_bit(mask);
+            }
+        }
+#endif
+#if defined(PRIDE_LOG_SSE2)
+        {
+            const auto control = _mm_set1_epi8(0x1F);
+            const auto quote = _mm_set1_epi8('"');
+            const auto backslash = _mm_set1_epi8('\\');
+            const auto space = _mm_set1_epi8(' ');
+            const auto equal = _mm_set1_epi8('=');
+            for (; i + 16 <= size; i += 16)
+            {
+                auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                auto hit = _mm_cmpeq_epi8(_mm_max_epu8(v, control), control);
+                hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, quote));
+                hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, backslash));
+                if constexpr (Logfmt)
+                {
+                    hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, space));
+                    hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, equal));
+                }
+                if (auto mask = static_cast<uint32_t>(_mm_movemask_epi8(hit)))
+                    return i + first_set_bit(mask);
+            }
+            if (i == size)
+                return size;
+
+            // the tail is scanned as one more vector padded with a byte that
+            // never needs escaping, short strings never take the byte loop
+            char tail[16];
+            std::memset(tail, 'x', sizeof(tail));
+            std::memcpy(tail, data + i, size - i);
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tail));
+            auto hit = _mm_cmpeq_epi8(_mm_max_epu8(v, control), control);
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, quote));
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, backslash));
+            if constexpr (Logfmt)
+            {
+                hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, space));
+                hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, equal));
+            }
+            auto mask = static_cast<uint32_t>(_mm_movemask_epi8(hit));
+            return mask != 0 ? i + first_set_bit(mask) : size;
+        }
+#endif
+        for (; i < size; ++i)
+        {
+            if (needs_escape<Logfmt>(static_cast<unsigned char>(data[i])))
+                return i;
+        }
+        return size;
+    }
+
+    inline size_t find_json_escape(const char* data, size_t size) { return find_escape<false>(data, size); }
+    inline size_t find_logfmt_escape(const char* data, size_t size) { return find_escape<true>(data, size); }
+
+    template<size_t Size>
+    void append_escaped_char(char c, fmt::basic_memory_buffer<char, Size>& buffer)
+    {
+        static constexpr const char* hex = "0123456789abcdef";
+        buffer.push_back('\\');
+        switch (c)
+        {
+        case '"': buffer.push_back('"'); break;
+        case '\\': buffer.push_back('\\'); break;
+        case '\n': buffer.push_back('n'); break;
+        case '\r': buffer.push_back('r'); break;
+        case '\t': buffer.push_back('t'); break;
+        case '\b': buffer.push_back('b'); break;
+        case '\f': buffer.push_back('f'); break;
+        default:
+        {
+            auto byte = static_cast<unsigned char>(c);
+            const char code[] = { 'u', '0', '0', hex[byte >> 4], hex[byte & 0xF] };
+            buffer.append(code, code + sizeof(code));
+        }
+        }
+    }
+
+    // Appends `text` without the quotes, escaped for a JSON string
+    template<size_t Size>
+    void append_json_escaped(std::string_view text, fmt::basic_memory_buffer<char, Size>& buffer)
+    {
+        auto data = text.data();
+        size_t start = 0;
+        while (start < text.size())
+        {
+            auto pos = start + find_json_escape(data + start, text.size() - start);
+            buffer.append(data + start, data + pos);
+            if (pos == text.size())
+                break;
+            append_escaped_char(data[pos], buffer);
+            start = pos + 1;
+        }
+    }
+
+    template<size_t Size>
+    void append_json_string(std::string_view text, fmt::basic_memory_buffer<char, Size>& buffer)
+    {
+        buffer.push_back('"');
+        append_json_escaped(text, buffer);
+        buffer.push_back('"');
+    }
+
+    // Logfmt values are written bare unless they are empty or have a byte
+    // that would break the key=value pairs apart, then they are quoted
+    template<size_t Size>
+    void append_logfmt_value(std::string_view text, fmt::basic_memory_buffer<char, Size>& buffer)
+    {
+        auto pos = find_logfmt_escape(text.data(), text.size());
+        if (pos == text.size() && !text.empty())
+        {
+            buffer.append(text.data(), text.data() + text.size());
+            return;
+        }
+        buffer.push_back('"');
+        buffer.append(text.data(), text.data() + pos);
+        append_json_escaped(text.substr(pos), buffer);
+        buffer.push_back('"');
+    }
+
+    // Logfmt keys can not be quoted, bytes that would break them become '_'
+    template<size_t Size>
+    void append_logfmt_key(std::string_view key, fmt::basic_memory_buffer<char, Size>& buffer)
+    {
+        auto pos = find_logfmt_escape(key.data(), key.size());
+        buffer.append(key.data(), key.data() + pos);
+        for (; pos < key.size(); ++pos)
+            buffer.push_back(needs_escape<true>(static_cast<unsigned char>(key[pos])) ? '_' : key[pos]);
+    }
+
+    // Fewest significant digits, 15 to 17, that read back as the same value.
+    // The default of fmt is %g with 6 and loses digits of larger numbers.
+    template<size_t Size>
+    void append_double(double value, fmt::basic_memory_buffer<char, Size>& buffer)
+    {
+        fmt::basic_memory_buffer<char, 32> text;
+        for (int precision = 15;; ++precision)
+        {
+            text.resize(0);
+            fmt::format_to(text, "{:.{}g}", value, precision);
+            text.push_back('\0');
+            if (precision == 17 || std::strtod(text.data(), nullptr) == value)
+                break;
+        }
+        buffer.append(text.data(), text.data() + text.size() - 1);
+    }
+
+    // UTC time in ISO 8601 with microseconds after a fixed lead. The text up to
+    // the seconds is only formatted again when the second changes.
+    class iso_time_t
+    {
+    public:
+        explicit iso_time_t(std::string_view lead)
+            : _lead(lead)
+        {}
+
+        template<size_t Size>
+        void format(std::chrono::system_clock::time_point time, fmt::basic_memory_buffer<char, Size>& buffer)
+        {
+            auto since_epoch = time.time_since_epoch();
+            auto seconds = std::chrono::duration_cast<std::chrono::seconds>(since_epoch);
+            if (seconds != _seconds || _cached.size() == 0)
+            {
+                _seconds = seconds;
+                auto tm = gm_time(static_cast<std::time_t>(seconds.count()));
+                _cached.resize(0);
+                _cached.append(_lead.data(), _lead.data() + _lead.size());
+                fmt::helper::append_int(tm.tm_year + 1900, _cached);
+                _cached.push_back('-');
+                fmt::helper::pad2(tm.tm_mon + 1, _cached);
+                _cached.push_back('-');
+                fmt::helper::pad2(tm.tm_mday, _cached);
+                _cached.push_back('T');
+                fmt::helper::pad2(tm.tm_hour, _cached);
+                _cached.push_back(':');
+                fmt::helper::pad2(tm.tm_min, _cached);
+                _cached.push_back(':');
+                fmt::helper::pad2(tm.tm_sec, _cached);
+                _cached.push_back('.');
+            }
+            fmt::helper::append_buffer(_cached, buffer);
+
+            auto micros = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(since_epoch - seconds).count());
+            char digits[7];
+            for (int i = 5; i >= 0; --i, micros /= 10)
+                digits[i] = static_cast<char>('0' + micros % 10);
+            digits[6] = 'Z';
+            buffer.append(digits, digits + sizeof(digits));
+        }
+
+    private:
+        const std::string_view _lead;
+        std::chrono::seconds _seconds{ -1 };
+        fmt::basic_memory_buffer<char, 48> _cached;
+    };
+
+    // Text of a record that only depends on its logger, level and thread.
+    // Records written to a channel mostly come from the same few, the text is
+    // only built again when one of them changes.
+    class context_cache_t
+    {
+    public:
+        template<typename Build>
+        const fmt::basic_memory_buffer<char, 128>& get(const message_t& msg, Build&& build)
+        {
+            if (_cached.size() == 0 || msg.sevarity != _level || msg.thread_id != _thread || !_same_names(msg.names))
+            {
+                _level = msg.sevarity;
+                _thread = msg.thread_id;
+                _names = msg.names;
+                _name = msg.names != nullptr ? *msg.names : std::string();
+                _cached.resize(0);
+                build(_cached);
+            }
+            return _cached;
+        }
+
+    private:
+        // a logger name is compared by its text as well, another logger may
+        // live at the address of one that is gone
+        bool _same_names(const std::string* names) const
+        {
+            if (names != _names)
+                return false;
+            return names == nullptr || *names == _name;
+        }
+
+        sevarity_t _level{ sevarity_t::off };
+        size_t _thread{ 0 };
+        const std::string* _names{ nullptr };
+        std::string _name;
+        fmt::basic_memory_buffer<char, 128> _cached;
+    };
+} // namespace internal
+
+// Formats a record as one JSON object per line (JSON Lines):
+// {"time":"2018-08-02T10:41:07.123456Z","level":"info","logger":"app","thread":42,"msg":"text","source":"main.cpp:12","user":"name","id":7}
+// "source" is only written for records logged with a call site, the fields
+// of the record follow it. Floating point fields that are not finite are null.
+class json_formatter_t : public formatter_t
+{
+public:
+    void format(const message_t& msg, fmt::memory_buffer& buffer) override
+    {
+        _time.format(msg.time, buffer);
+        fmt::helper::append_buffer(_context.get(msg, [&msg](auto& text) {
+            _append(R"(","level":")", text);
+            fmt::helper::append_str(internal::to_long_name(msg.sevarity), text);
+            if (msg.names != nullptr)
+            {
+                _append(R"(","logger":)", text);
+                internal::append_json_string(*msg.names, text);
+                _append(R"(,"thread":)", text);
+            }
+            else
+            {
+                _append(R"(","thread":)", text);
+            }
+            fmt::helper::append_int(msg.thread_id, text);
+            _append(R"(,"msg":")", text);
+        }),
+            buffer);
+        internal::append_json_escaped(std::string_view(msg.raw.data(), msg.raw.size()), buffer);
+        buffer.push_back('"');
+
+        if (msg.source != nullptr && msg.source->file != nullptr)
+        {
+            _append(R"(,"source":")", buffer);
+            internal::append_json_escaped(msg.source->file, buffer);
+            buffer.push_back(':');
+            fmt::helper::append_int(msg.source->line, buffer);
+            buffer.push_back('"');
+        }
+
+        for (size_t i = 0; i < msg.fields.size(); ++i)
+        {
+            auto field = msg.fields[i];
+            buffer.push_back(',');
+            internal::append_json_string(field.key, buffer);
+            buffer.push_back(':');
+            switch (field.type)
+            {
+            case field_type_t::i64: fmt::helper::append_int(field.i, buffer); break;
+            case field_type_t::u64: fmt::helper::append_int(field.u, buffer); break;
+            case field_type_t::boolean: _append(field.b ? "true" : "false", buffer); break;
+            case field_type_t::f64:
+                if (std::isfinite(field.f))
+                    internal::append_double(field.f, buffer);
+                else
+                    _append("null", buffer);
+                break;
+            case field_type_t::string: internal::append_json_string(field.text, buffer); break;
+            }
+        }
+        _append("}\n", buffer);
+    }
+
+    const std::string& signature() const override
+    {
+        static const std::string signature("\x01json");
+        return signature;
+    }
+
+private:
+    template<size_t Size>
+    static void _append(std::string_view text, fmt::basic_memory_buffer<char, Size>& buffer)
+    {
+        buffer.append(text.data(), text.data() + text.size());
+    }
+
+    internal::iso_time_t _time{ R"({"time":")" };
+    internal::context_cache_t _context;
+};
+
+// Formats a record as logfmt key=value pairs on one line:
+// time=2018-08-02T10:41:07.123456Z level=info logger=app thread=42 msg="some text" source=main.cpp:12 user=name id=7
+// Values are quoted and escaped like JSON strings when they have to be.
+class logfmt_formatter_t : public formatter_t
+{
+public:
+    void format(const message_t& msg, fmt::memory_buffer& buffer) override
+    {
+        _time.format(msg.time, buffer);
+        fmt::helper::append_buffer(_context.get(msg, [&msg](auto& text) {
+            _append(" level=", text);
+            fmt::helper::append_str(internal::to_long_name(msg.sevarity), text);
+            if (msg.names != nullptr)
+            {
+                _append(" logger=", text);
+                internal::append_logfmt_value(*msg.names, text);
+            }
+            _append(" thread=", text);
+            fmt::helper::append_int(msg.thread_id, text);
+            _append(" msg=", text);
+        }),
+            buffer);
+        internal::append_logfmt_value(std::string_view(msg.raw.data(), msg.raw.size()), buffer);
+
+        if (msg.source != nullptr && msg.source->file != nullptr)
+        {
+            fmt::basic_memory_buffer<char, 128> source;
+            _append(msg.source->file, source);
+            source.push_back(':');
+            fmt::helper::append_int(msg.source->line, source);
+            _append(" source=", buffer);
+            internal::append_logfmt_value(std::string_view(source.data(), source.size()), buffer);
+        }
+
+        for (size_t i = 0; i < msg.fields.size(); ++i)
+        {
+            auto field = msg.fields[i];
+            buffer.push_back(' ');
+            internal::append_logfmt_key(field.key, buffer);
+            buffer.push_back('=');
+            switch (field.type)
+            {
+            case field_type_t::i64: fmt::helper::append_int(field.i, buffer); break;
+            case field_type_t::u64: fmt::helper::append_int(field.u, buffer); break;
+            case field_type_t::f64: internal::append_double(field.f, buffer); break;
+            case field_type_t::boolean: _append(field.b ? "true" : "false", buffer); break;
+            case field_type_t::string: internal::append_logfmt_value(field.text, buffer); break;
+            }
+        }
+        buffer.push_back('\n');
+    }
+
+    const std::string& signature() const override
+    {
+        static const std::string signature("\x01logfmt");
+        return signature;
+    }
+
+private:
+    template<size_t Size>
+    static void _append(std::string_view text, fmt::basic_memory_buffer<char, Size>& buffer)
+    {
+        buffer.append(text.data(), text.data() + text.size());
+    }
+
+    internal::iso_time_t _time{ "time=" };
+    internal::context_cache_t _context;
+};
+} // namespace pride::log
@@ -5,6 +5,8 @@
 #include "../config/detection/os.hpp"
 #include "../config/include/windows.hpp"
 #include "../log/fmt.hpp"
+#include <cerrno>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <exception>
@@ -12,6 +14,19 @@
 #include <string>
 #include <thread>
 #include <tuple>
+#include <utility>
+
+#if defined(PRIDE_OS_WINDOWS)
+#    include <fcntl.h>
+#    include <io.h>
+#    include <sys/stat.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <sys/uio.h>
+#    include <unistd.h>
+#endif
 
 #if !defined(PRIDE_EOL)
 #    if defined(PRIDE_OS_WINDOWS)
@@ -73,7 +88,7 @@ public:
 #if defined(PRIDE_OS_WINDOWS)
         fopen_s(&_file, _name.c_str(), mode);
 #else
-        _file = std::fopen(name.c_str(), mode);
+        _file = std::fopen(_name.c_str(), mode);
 #endif
     }
 
@@ -134,4 +149,463 @@ private:
     FILE* _file = nullptr;
     std::string _name;
 };
+
+// ────────────────────────────────────────────────────────────────────────────────
+
+// File written through its descriptor without any stdio buffering, every
+// write is one system call. Meant for callers that do their own buffering.
+class raw_file_t
+{
+public:
+    explicit raw_file_t() = default;
+    raw_file_t(const raw_file_t&) = delete;
+    raw_file_t& operator=(const raw_file_t&) = delete;
+
+    ~raw_file_t()
+    {
+        close();
+    }
+
+    // Without `append` writes land where write_at puts them, which lets
+    // several writes to the same file be in flight at once
+    bool open(std::string name, bool truncate = false, bool append = true)
+    {
+        close();
+        _name = std::move(name);
+
+        auto flags = O_WRONLY | O_CREAT | (append ? O_APPEND : 0) | (truncate ? O_TRUNC : 0);
+#if defined(PRIDE_OS_WINDOWS)
+        _fd = ::_open(_name.c_str(), flags | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+        _fd = ::open(_name.c_str(), flags | O_CLOEXEC, 0644);
+#endif
+        return _fd >= 0;
+    }
+
+    void close()
+    {
+        if (_fd >= 0)
+        {
+#if defined(PRIDE_OS_WINDOWS)
+            ::_close(_fd);
+#else
+            ::close(_fd);
+#endif
+            _fd = -1;
+        }
+    }
+
+    bool is_open() const { return _fd >= 0; }
+    int descriptor() const { return _fd; }
+    const std::string& name() const { return _name; }
+
+    size_t size() const
+    {
+#if defined(PRIDE_OS_WINDOWS)
+        struct _stat64 st;
+        return _fd >= 0 && ::_fstat64(_fd, &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+#else
+        struct stat st;
+        return _fd >= 0 && ::fstat(_fd, &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+#endif
+    }
+
+    // Reserves disk blocks for the next `size` bytes without changing the size
+    // of the file, appends then never wait on block allocation. Only Linux
+    // can do this, elsewhere it does nothing and returns false.
+    bool preallocate(size_t size)
+    {
+#if defined(PRIDE_OS_LINUX) && defined(FALLOC_FL_KEEP_SIZE)
+        return _fd >= 0 && ::fallocate(_fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(size)) == 0;
+#else
+        return false;
+#endif
+    }
+
+    // Cuts the file at `size`, also releases blocks preallocated past it
+    bool truncate(size_t size)
+    {
+#if defined(PRIDE_OS_WINDOWS)
+        return _fd >= 0 && ::_chsize_s(_fd, static_cast<long long>(size)) == 0;
+#else
+        return _fd >= 0 && ::ftruncate(_fd, static_cast<off_t>(size)) == 0;
+#endif
+    }
+
+    // Writes everything or fails, short writes and interrupts are retried
+    bool write(const char* data, size_t size)
+    {
+        return write(data, size, nullptr, 0);
+    }
+
+    // Writes two blocks with a single gather write where the platform has one
+    bool write(const char* first, size_t first_size, const char* second, size_t second_size)
+    {
+        if (_fd < 0)
+            return false;
+
+#if defined(PRIDE_OS_WINDOWS)
+        return _write_all(first, first_size) && _write_all(second, second_size);
+#else
+        iovec blocks[2] = { { const_cast<char*>(first), first_size }, { const_cast<char*>(second), second_size } };
+        iovec* next = blocks;
+        int count = second_size > 0 ? 2 : 1;
+        while (count > 0)
+        {
+            auto written = ::writev(_fd, next, count);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+
+            auto left = static_cast<size_t>(written);
+            while (count > 0 && left >= next->iov_len)
+            {
+                left -= next->iov_len;
+                ++next;
+                --count;
+            }
+            if (count > 0)
+            {
+                next->iov_base = static_cast<char*>(next->iov_base) + left;
+                next->iov_len -= left;
+            }
+        }
+        return true;
+#endif
+    }
+
+    // Writes everything at `offset` without moving the file position. On
+    // Windows it seeks first, so callers there must not write concurrently.
+    bool write_at(const char* data, size_t size, uint64_t offset)
+    {
+        if (_fd < 0)
+            return false;
+
+#if defined(PRIDE_OS_WINDOWS)
+        return ::_lseeki64(_fd, static_cast<long long>(offset), SEEK_SET) >= 0 && _write_all(data, size);
+#else
+        while (size > 0)
+        {
+            auto written = ::pwrite(_fd, data, size, static_cast<off_t>(offset));
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+            offset += static_cast<uint64_t>(written);
+        }
+        return true;
+#endif
+    }
+
+    // Waits until what was written is on the disk, `data_only` skips metadata
+    // that is not needed to read the data back (fdatasync)
+    bool sync(bool data_only = false)
+    {
+        if (_fd < 0)
+            return false;
+
+#if defined(PRIDE_OS_WINDOWS)
+        (void)data_only;
+        return ::_commit(_fd) == 0;
+#elif defined(PRIDE_OS_LINUX)
+        return (data_only ? ::fdatasync(_fd) : ::fsync(_fd)) == 0;
+#else
+        (void)data_only;
+        return ::fsync(_fd) == 0;
+#endif
+    }
+
+private:
+#if defined(PRIDE_OS_WINDOWS)
+    bool _write_all(const char* data, size_t size)
+    {
+        while (size > 0)
+        {
+            auto written = ::_write(_fd, data, static_cast<unsigned int>(size));
+            if (written < 0)
+                return false;
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+#endif
+
+    int _fd = -1;
+    std::string _name;
+};
+
+// ────────────────────────────────────────────────────────────────────────────────
+
+// Read-write view of a part of a mapped_file_t. Stores into it go to the page
+// cache, which keeps them when the process dies; sync() pushes them to disk.
+class mapped_region_t
+{
+public:
+    mapped_region_t() = default;
+    mapped_region_t(const mapped_region_t&) = delete;
+    mapped_region_t& operator=(const mapped_region_t&) = delete;
+
+    mapped_region_t(mapped_region_t&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    mapped_region_t& operator=(mapped_region_t&& other) noexcept
+    {
+        if (this != &other)
+        {
+            unmap();
+            std::swap(_data, other._data);
+            std::swap(_size, other._size);
+            std::swap(_offset, other._offset);
+#if defined(PRIDE_OS_WINDOWS)
+            std::swap(_mapping, other._mapping);
+#endif
+        }
+        return *this;
+    }
+
+    ~mapped_region_t()
+    {
+        unmap();
+    }
+
+    void unmap()
+    {
+        if (_data == nullptr)
+            return;
+
+#if defined(PRIDE_OS_WINDOWS)
+        ::UnmapViewOfFile(_data);
+        ::CloseHandle(_mapping);
+        _mapping = nullptr;
+#else
+        ::munmap(_data, _size);
+#endif
+        _data = nullptr;
+        _size = 0;
+        _offset = 0;
+    }
+
+    bool is_mapped() const { return _data != nullptr; }
+    char* data() const { return _data; }
+    size_t size() const { return _size; }
+
+    // Where the region starts in the file
+    uint64_t offset() const { return _offset; }
+
+    // Writes `size` bytes from `from` on back to the file, without `wait`
+    // it only starts the write back
+    bool sync(size_t from, size_t size, bool wait = true)
+    {
+        if (_data == nullptr || size == 0)
+            return true;
+
+        // msync wants a page aligned start
+        auto page = from - from % mapped_file_granularity();
+        size += from - page;
+#if defined(PRIDE_OS_WINDOWS)
+        (void)wait;
+        return ::FlushViewOfFile(_data + page, size) != 0;
+#else
+        return ::msync(_data + page, size, wait ? MS_SYNC : MS_ASYNC) == 0;
+#endif
+    }
+
+    // Faults every page in for writing so the first stores into them do not
+    // stop on a page fault. The pages hold zeros, writing zeros keeps them.
+    void touch()
+    {
+        static const size_t page = [] {
+#if defined(PRIDE_OS_WINDOWS)
+            SYSTEM_INFO info;
+            ::GetSystemInfo(&info);
+            return static_cast<size_t>(info.dwPageSize);
+#else
+            return static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+#endif
+        }();
+
+        for (size_t at = 0; at < _size; at += page)
+        {
+            auto byte = static_cast<volatile char*>(_data + at);
+            *byte = *byte;
+        }
+    }
+
+    // Mapping offsets must be multiples of this
+    static size_t mapped_file_granularity()
+    {
+#if defined(PRIDE_OS_WINDOWS)
+        static const size_t granularity = [] {
+            SYSTEM_INFO info;
+            ::GetSystemInfo(&info);
+            return static_cast<size_t>(info.dwAllocationGranularity);
+        }();
+#else
+        static const size_t granularity = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+#endif
+        return granularity;
+    }
+
+private:
+    friend class mapped_file_t;
+
+    char* _data = nullptr;
+    size_t _size = 0;
+    uint64_t _offset = 0;
+#if defined(PRIDE_OS_WINDOWS)
+    HANDLE _mapping = nullptr;
+#endif
+};
+
+// File opened for reading and writing so parts of it can be mapped into
+// memory. The file has to be resized to cover a region before mapping it,
+// stores past its end fault.
+class mapped_file_t
+{
+public:
+    explicit mapped_file_t() = default;
+    mapped_file_t(const mapped_file_t&) = delete;
+    mapped_file_t& operator=(const mapped_file_t&) = delete;
+
+    ~mapped_file_t()
+    {
+        close();
+    }
+
+    bool open(std::string name, bool truncate = false)
+    {
+        close();
+        _name = std::move(name);
+
+        auto flags = O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0);
+#if defined(PRIDE_OS_WINDOWS)
+        _fd = ::_open(_name.c_str(), flags | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+        _fd = ::open(_name.c_str(), flags | O_CLOEXEC, 0644);
+#endif
+        return _fd >= 0;
+    }
+
+    void close()
+    {
+        if (_fd >= 0)
+        {
+#if defined(PRIDE_OS_WINDOWS)
+            ::_close(_fd);
+#else
+            ::close(_fd);
+#endif
+            _fd = -1;
+        }
+    }
+
+    bool is_open() const { return _fd >= 0; }
+    int descriptor() const { return _fd; }
+    const std::string& name() const { return _name; }
+
+    uint64_t size() const
+    {
+#if defined(PRIDE_OS_WINDOWS)
+        struct _stat64 st;
+        return _fd >= 0 && ::_fstat64(_fd, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+#else
+        struct stat st;
+        return _fd >= 0 && ::fstat(_fd, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+#endif
+    }
+
+    // Grows or cuts the file. Growing allocates the blocks where the system
+    // can, so a full disk fails here instead of faulting a later store. Only a
+    // file system without fallocate is grown sparse.
+    bool resize(uint64_t size)
+    {
+        if (_fd < 0)
+            return false;
+
+#if defined(PRIDE_OS_WINDOWS)
+        return ::_chsize_s(_fd, static_cast<long long>(size)) == 0;
+#else
+        auto current = this->size();
+#    if defined(PRIDE_OS_LINUX)
+        if (size > current)
+        {
+            int result;
+            do
+                result = ::fallocate(_fd, 0, static_cast<off_t>(current), static_cast<off_t>(size - current));
+            while (result != 0 && errno == EINTR);
+            if (result == 0)
+                return true;
+            if (errno != EOPNOTSUPP && errno != ENOSYS)
+                return false;
+        }
+#    endif
+        return ::ftruncate(_fd, static_cast<off_t>(size)) == 0;
+#endif
+    }
+
+    // Maps `size` bytes from `offset`, which must be a multiple of
+    // mapped_region_t::mapped_file_granularity(). Unmapped on failure.
+    mapped_region_t map(uint64_t offset, size_t size)
+    {
+        mapped_region_t region;
+        if (_fd < 0 || size == 0)
+            return region;
+
+#if defined(PRIDE_OS_WINDOWS)
+        auto handle = reinterpret_cast<HANDLE>(::_get_osfhandle(_fd));
+        auto end = offset + size;
+        region._mapping = ::CreateFileMappingW(handle, nullptr, PAGE_READWRITE, static_cast<DWORD>(end >> 32), static_cast<DWORD>(end), nullptr);
+        if (region._mapping == nullptr)
+            return region;
+
+        auto view = ::MapViewOfFile(region._mapping, FILE_MAP_WRITE, static_cast<DWORD>(offset >> 32), static_cast<DWORD>(offset), size);
+        if (view == nullptr)
+        {
+            ::CloseHandle(region._mapping);
+            region._mapping = nullptr;
+            return region;
+        }
+        region._data = static_cast<char*>(view);
+#else
+        auto view = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, static_cast<off_t>(offset));
+        if (view == MAP_FAILED)
+            return region;
+        region._data = static_cast<char*>(view);
+#endif
+        region._size = size;
+        region._offset = offset;
+        return region;
+    }
+
+    // Waits until the file is on the disk, stores into mapped regions included
+    bool sync(bool data_only = false)
+    {
+        if (_fd < 0)
+            return false;
+
+#if defined(PRIDE_OS_WINDOWS)
+        (void)data_only;
+        return ::_commit(_fd) == 0;
+#elif defined(PRIDE_OS_LINUX)
+        return (data_only ? ::fdatasync(_fd) : ::fsync(_fd)) == 0;
+#else
+        (void)data_only;
+        return ::fsync(_fd) == 0;
+#endif
+    }
+
+private:
+    int _fd = -1;
+    std::string _name;
+};
 } // namespace pride::os
@@ -0,0 +1,162 @@
+#pragma once
+
+#include "../config/detection/os.hpp"
+#include "../config/include/windows.hpp"
+#include <cerrno>
+#include <cstddef>
+#include <string>
+
+#if !defined(PRIDE_OS_WINDOWS)
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+namespace pride::os
+{
+// Named block of memory that other processes can map as well. On POSIX
+// systems it is a shm_open object, named like "/app-log", that lives on after
+// the processes using it until remove() is called. On Windows it is a named
+// mapping backed by the paging file, gone with the last process holding it.
+class shared_memory_t
+{
+public:
+    explicit shared_memory_t() = default;
+    shared_memory_t(const shared_memory_t&) = delete;
+    shared_memory_t& operator=(const shared_memory_t&) = delete;
+
+    ~shared_memory_t()
+    {
+        close();
+    }
+
+    // Maps the block, creating it with `size` bytes when there is none yet.
+    // An existing block keeps its size. `created` tells which it was.
+    bool create(const std::string& name, size_t size, bool* created = nullptr)
+    {
+        close();
+        bool fresh = false;
+
+#if defined(PRIDE_OS_WINDOWS)
+        auto high = static_cast<DWORD>(static_cast<unsigned long long>(size) >> 32);
+        _mapping = ::CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, high, static_cast<DWORD>(size), name.c_str());
+        if (_mapping == nullptr)
+            return false;
+        fresh = ::GetLastError() != ERROR_ALREADY_EXISTS;
+        if (!_map_view())
+            return false;
+#else
+        auto fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd >= 0)
+        {
+            fresh = true;
+            if (::ftruncate(fd, static_cast<off_t>(size)) != 0)
+            {
+                ::close(fd);
+                ::shm_unlink(name.c_str());
+                return false;
+            }
+        }
+        else if (errno == EEXIST)
+            fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+
+        if (fd < 0 || !_map(fd, size))
+            return false;
+#endif
+        if (created != nullptr)
+            *created = fresh;
+        return true;
+    }
+
+    // Maps a block that exists already
+    bool open(const std::string& name)
+    {
+        close();
+
+#if defined(PRIDE_OS_WINDOWS)
+        _mapping = ::OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+        return _mapping != nullptr && _map_view();
+#else
+        auto fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+        return fd >= 0 && _map(fd, 0);
+#endif
+    }
+
+    void close()
+    {
+        if (_data == nullptr)
+            return;
+
+#if defined(PRIDE_OS_WINDOWS)
+        ::UnmapViewOfFile(_data);
+        ::CloseHandle(_mapping);
+        _mapping = nullptr;
+#else
+        ::munmap(_data, _size);
+#endif
+        _data = nullptr;
+        _size = 0;
+    }
+
+    // Removes the name, mappings that exist stay valid
+    static bool remove(const std::string& name)
+    {
+#if defined(PRIDE_OS_WINDOWS)
+        (void)name;
+        return true;
+#else
+        return ::shm_unlink(name.c_str()) == 0;
+#endif
+    }
+
+    bool is_open() const { return _data != nullptr; }
+    char* data() const { return _data; }
+    size_t size() const { return _size; }
+
+private:
+#if defined(PRIDE_OS_WINDOWS)
+    bool _map_view()
+    {
+        auto view = ::MapViewOfFile(_mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+        MEMORY_BASIC_INFORMATION info;
+        if (view == nullptr || ::VirtualQuery(view, &info, sizeof(info)) == 0)
+        {
+            if (view != nullptr)
+                ::UnmapViewOfFile(view);
+            ::CloseHandle(_mapping);
+            _mapping = nullptr;
+            return false;
+        }
+        _data = static_cast<char*>(view);
+        _size = info.RegionSize;
+        return true;
+    }
+
+    HANDLE _mapping = nullptr;
+#else
+    // maps the whole object and closes `fd`, the mapping keeps it alive
+    bool _map(int fd, size_t size)
+    {
+        // an object whose creator has not sized it yet gets `size` here
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0)
+            size = static_cast<size_t>(st.st_size);
+        else if (size > 0 && ::ftruncate(fd, static_cast<off_t>(size)) != 0)
+            size = 0;
+
+        void* view = size > 0 ? ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        ::close(fd);
+        if (view == MAP_FAILED)
+            return false;
+
+        _data = static_cast<char*>(view);
+        _size = size;
+        return true;
+    }
+#endif
+
+    char* _data = nullptr;
+    size_t _size = 0;
+};
+} // namespace pride::os
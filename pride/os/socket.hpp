@@ -0,0 +1,260 @@
+#pragma once
+
+#include "../config/detection/os.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if !defined(PRIDE_OS_WINDOWS)
+#    include <fcntl.h>
+#    include <netdb.h>
+#    include <netinet/in.h>
+#    include <netinet/tcp.h>
+#    include <sys/socket.h>
+#    include <sys/uio.h>
+#    include <sys/un.h>
+#    include <unistd.h>
+#endif
+
+namespace pride::os
+{
+#if !defined(PRIDE_OS_WINDOWS)
+// Where a socket connects to: a unix domain socket path or a host and port
+struct socket_endpoint_t
+{
+    enum class kind_t : uint8_t
+    {
+        unix_datagram,
+        unix_stream,
+        udp,
+        tcp
+    };
+
+    static socket_endpoint_t unix_datagram(std::string path) { return { kind_t::unix_datagram, std::move(path), 0 }; }
+    static socket_endpoint_t unix_stream(std::string path) { return { kind_t::unix_stream, std::move(path), 0 }; }
+    static socket_endpoint_t udp(std::string host, uint16_t port) { return { kind_t::udp, std::move(host), port }; }
+    static socket_endpoint_t tcp(std::string host, uint16_t port) { return { kind_t::tcp, std::move(host), port }; }
+
+    bool stream() const { return kind == kind_t::unix_stream || kind == kind_t::tcp; }
+
+    kind_t kind;
+    std::string address; // path or host
+    uint16_t port;
+};
+
+// Connected socket that never blocks once connected and never raises
+// SIGPIPE. Connecting blocks, which is only short for local peers.
+class socket_t
+{
+public:
+    enum class status_t : uint8_t
+    {
+        ok,
+        busy,      // the socket buffer is full, try again later
+        too_large, // the first datagram can never be sent
+        broken     // the peer is gone, connect again
+    };
+
+    struct block_t
+    {
+        const char* data;
+        size_t size;
+    };
+
+    struct result_t
+    {
+        size_t count; // datagrams or bytes that went out
+        status_t status;
+    };
+
+    explicit socket_t() = default;
+    socket_t(const socket_t&) = delete;
+    socket_t& operator=(const socket_t&) = delete;
+
+    ~socket_t()
+    {
+        close();
+    }
+
+    bool connect(const socket_endpoint_t& endpoint)
+    {
+        close();
+        _stream = endpoint.stream();
+
+        if (endpoint.kind == socket_endpoint_t::kind_t::unix_datagram || endpoint.kind == socket_endpoint_t::kind_t::unix_stream)
+        {
+            sockaddr_un address;
+            std::memset(&address, 0, sizeof(address));
+            if (endpoint.address.size() >= sizeof(address.sun_path))
+                return false;
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, endpoint.address.data(), endpoint.address.size());
+            return _connect(AF_UNIX, _stream ? SOCK_STREAM : SOCK_DGRAM, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+        }
+
+        addrinfo hints;
+        std::memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = _stream ? SOCK_STREAM : SOCK_DGRAM;
+        addrinfo* found = nullptr;
+        if (::getaddrinfo(endpoint.address.c_str(), std::to_string(endpoint.port).c_str(), &hints, &found) != 0)
+            return false;
+
+        for (auto info = found; info != nullptr && _fd < 0; info = info->ai_next)
+            _connect(info->ai_family, info->ai_socktype, info->ai_addr, info->ai_addrlen);
+        ::freeaddrinfo(found);
+
+        if (_fd >= 0 && endpoint.kind == socket_endpoint_t::kind_t::tcp)
+        {
+            // records are batched already, do not hold them back any longer
+            int on = 1;
+            ::setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        }
+        return _fd >= 0;
+    }
+
+    void close()
+    {
+        if (_fd >= 0)
+        {
+            ::close(_fd);
+            _fd = -1;
+        }
+    }
+
+    bool is_open() const { return _fd >= 0; }
+    int descriptor() const { return _fd; }
+
+    // Sends every block as a datagram of its own, with one sendmmsg where
+    // there is one. `count` is how many went out before `status` stopped it.
+    result_t send_datagrams(const block_t* blocks, size_t count)
+    {
+        size_t sent = 0;
+#    if defined(PRIDE_OS_LINUX)
+        constexpr size_t batch = 64;
+        iovec vectors[batch];
+        mmsghdr messages[batch];
+        while (sent < count)
+        {
+            auto size = std::min(batch, count - sent);
+            std::memset(messages, 0, sizeof(mmsghdr) * size);
+            for (size_t i = 0; i < size; ++i)
+            {
+                vectors[i] = { const_cast<char*>(blocks[sent + i].data), blocks[sent + i].size };
+                messages[i].msg_hdr.msg_iov = &vectors[i];
+                messages[i].msg_hdr.msg_iovlen = 1;
+            }
+
+            auto done = ::sendmmsg(_fd, messages, static_cast<unsigned int>(size), MSG_NOSIGNAL);
+            if (done < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return { sent, _status(errno) };
+            }
+            sent += static_cast<size_t>(done);
+        }
+#    else
+        while (sent < count)
+        {
+            auto done = ::send(_fd, blocks[sent].data, blocks[sent].size, _send_flags);
+            if (done < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return { sent, _status(errno) };
+            }
+            ++sent;
+        }
+#    endif
+        return { sent, status_t::ok };
+    }
+
+    // Writes the blocks one after the other with a gather write, `count` is
+    // how many bytes went out before `status` stopped it
+    result_t send_stream(const block_t* blocks, size_t count)
+    {
+        constexpr size_t batch = 64;
+        size_t sent = 0;
+        size_t first = 0;
+        size_t skip = 0; // of the first block, already sent
+        while (first < count)
+        {
+            iovec vectors[batch];
+            auto size = std::min(batch, count - first);
+            for (size_t i = 0; i < size; ++i)
+                vectors[i] = { const_cast<char*>(blocks[first + i].data), blocks[first + i].size };
+            vectors[0].iov_base = static_cast<char*>(vectors[0].iov_base) + skip;
+            vectors[0].iov_len -= skip;
+
+            msghdr message;
+            std::memset(&message, 0, sizeof(message));
+            message.msg_iov = vectors;
+            message.msg_iovlen = size;
+            auto done = ::sendmsg(_fd, &message, _send_flags);
+            if (done < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return { sent, _status(errno) };
+            }
+
+            sent += static_cast<size_t>(done);
+            auto left = static_cast<size_t>(done) + skip;
+            while (first < count && left >= blocks[first].size)
+                left -= blocks[first++].size;
+            skip = left;
+        }
+        return { sent, status_t::ok };
+    }
+
+private:
+#    if defined(MSG_NOSIGNAL)
+    static constexpr int _send_flags = MSG_NOSIGNAL;
+#    else
+    static constexpr int _send_flags = 0;
+#    endif
+
+    bool _connect(int family, int type, const sockaddr* address, socklen_t size)
+    {
+        auto fd = ::socket(family, type, 0);
+        if (fd < 0)
+            return false;
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+#    if defined(SO_NOSIGPIPE)
+        int on = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#    endif
+
+        int result;
+        do
+            result = ::connect(fd, address, size);
+        while (result != 0 && errno == EINTR);
+        if (result != 0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        _fd = fd;
+        return true;
+    }
+
+    static status_t _status(int error)
+    {
+        if (error == EAGAIN || error == EWOULDBLOCK || error == ENOBUFS)
+            return status_t::busy;
+        if (error == EMSGSIZE)
+            return status_t::too_large;
+        return status_t::broken;
+    }
+
+    int _fd = -1;
+    bool _stream = false;
+};
+#endif
+} // namespace pride::os
@@ -0,0 +1,208 @@
+#include <test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pride::log;
+
+namespace
+{
+size_t count_lines(const std::string& str)
+{
+    size_t lines = 0;
+    for (auto c : str)
+        if (c == '\n')
+            ++lines;
+    return lines;
+}
+
+// Channel that holds the worker inside log() until it is released so the
+// queue can be filled up deterministically.
+class gate_channel_t : public channel_t
+{
+public:
+    void log(const message_t& msg) override
+    {
+        entered = true;
+        while (!released)
+            std::this_thread::yield();
+        messages.push_back(fmt::to_string(msg.raw));
+    }
+    void flush() override {}
+
+    std::atomic<bool> entered{ false };
+    std::atomic<bool> released{ false };
+    std::vector<std::string> messages;
+};
+
+void fill_and_overflow(async_logger_t& logger, gate_channel_t& gate)
+{
+    logger.info("0");
+    while (!gate.entered)
+        std::this_thread::yield();
+
+    for (int i = 1; i <= 5; ++i)
+        logger.info("{}", i);
+
+    gate.released = true;
+    logger.flush();
+}
+} // namespace
+
+TEST_CASE("mpmc queue")
+{
+    internal::mpmc_queue_t<int> queue(3);
+    REQUIRE(queue.capacity() == 4);
+
+    for (int i = 0; i < 4; ++i)
+        REQUIRE(queue.try_push(int(i)));
+    REQUIRE_FALSE(queue.try_push(4));
+    REQUIRE(queue.size() == 4);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        int value = -1;
+        REQUIRE(queue.try_pop(value));
+        REQUIRE(value == i);
+    }
+
+    int value;
+    REQUIRE_FALSE(queue.try_pop(value));
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("Parker")
+{
+    internal::parker_t parker;
+    std::atomic<int> published{ 0 };
+
+    // every round the consumer parks before or after the producer publishes,
+    // it must never sleep through a publish
+    std::thread consumer([&] {
+        for (int round = 1; round <= 1000; ++round)
+            parker.park([&] { return published.load() >= round; });
+    });
+    for (int round = 1; round <= 1000; ++round)
+    {
+        published.store(round);
+        parker.notify();
+        if (round % 100 == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    consumer.join();
+    REQUIRE(published.load() == 1000);
+}
+
+TEST_CASE("Async logger")
+{
+    SECTION("Idle workers wake for the next record")
+    {
+        struct counting_channel_t : public channel_t
+        {
+            void log(const message_t&) override { ++records; }
+            void flush() override {}
+            std::atomic<int> records{ 0 };
+        };
+
+        auto channel = std::make_shared<counting_channel_t>();
+        async_logger_t logger("async-idle", 16, 2);
+        logger.add_channel(channel);
+
+        for (int i = 1; i <= 3; ++i)
+        {
+            // long enough for the workers to park
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            logger.warn("record");
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (channel->records.load() < i && std::chrono::steady_clock::now() < deadline)
+                std::this_thread::yield();
+            REQUIRE(channel->records.load() == i);
+        }
+    }
+
+    SECTION("Flush drains the queue")
+    {
+        std::ostringstream stream;
+        async_logger_t logger("async-flush", 16, 2);
+        logger.add_channel<channels::ostream_mt>(stream).set_pattern("%v");
+
+        for (int i = 0; i < 100; ++i)
+            logger.info("message {}", i);
+        logger.flush();
+
+        REQUIRE(count_lines(stream.str()) == 100);
+    }
+
+    SECTION("Destruction drains the queue")
+    {
+        std::ostringstream stream;
+        {
+            async_logger_t logger("async-destroy", 8);
+            logger.add_channel<channels::ostream_mt>(stream).set_pattern("%v");
+
+            std::vector<std::thread> producers;
+            for (int t = 0; t < 4; ++t)
+            {
+                producers.emplace_back([&logger] {
+                    for (int i = 0; i < 250; ++i)
+                        logger.warn("message {}", i);
+                });
+            }
+
+            for (auto& thread : producers)
+                thread.join();
+        }
+
+        REQUIRE(count_lines(stream.str()) == 1000);
+    }
+}
+
+TEST_CASE("Async logger overflow policies")
+{
+    SECTION("Drop newest")
+    {
+        auto gate = std::make_shared<gate_channel_t>();
+        async_logger_t logger("async-drop", 2);
+        logger.overflow_policy(overflow_policy_t::drop_newest).add_channel(gate);
+        fill_and_overflow(logger, *gate);
+
+        auto stats = logger.stats();
+        REQUIRE(stats.enqueued == 3);
+        REQUIRE(stats.dropped == 3);
+        REQUIRE(stats.overwritten == 0);
+        REQUIRE(gate->messages == std::vector<std::string>{ "0", "1", "2" });
+    }
+
+    SECTION("Overwrite oldest")
+    {
+        auto gate = std::make_shared<gate_channel_t>();
+        async_logger_t logger("async-overwrite", 2);
+        logger.overflow_policy(overflow_policy_t::overwrite_oldest).add_channel(gate);
+        fill_and_overflow(logger, *gate);
+
+        auto stats = logger.stats();
+        REQUIRE(stats.enqueued == 6);
+        REQUIRE(stats.dropped == 0);
+        REQUIRE(stats.overwritten == 3);
+        REQUIRE(gate->messages == std::vector<std::string>{ "0", "4", "5" });
+    }
+
+    SECTION("Block")
+    {
+        std::ostringstream stream;
+        async_logger_t logger("async-block", 2);
+        logger.add_channel<channels::ostream_mt>(stream).set_pattern("%v");
+        for (int i = 0; i < 64; ++i)
+            logger.info("{}", i);
+        logger.flush();
+
+        auto stats = logger.stats();
+        REQUIRE(stats.enqueued == 64);
+        REQUIRE(stats.dropped == 0);
+        REQUIRE(count_lines(stream.str()) == 64);
+    }
+}
@@ -0,0 +1,121 @@
+#include <test.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pride::log;
+
+TEST_CASE("Backtrace")
+{
+    std::ostringstream stream;
+    logger_t logger("backtrace");
+    logger.add_channel<channels::ostream_st>(stream);
+    logger.sevarity(sevarity_t::warn).set_pattern("[%L] %v");
+
+    SECTION("Records below the level are logged ahead of an error")
+    {
+        logger.enable_backtrace(8);
+        logger.debug("step {} of {}", 1, 3);
+        logger.trace("value {:.1f} {}", 2.25, std::string("text"));
+        logger.info("ignored {}", true);
+        REQUIRE(stream.str().empty());
+
+        logger.error("failed");
+        REQUIRE(stream.str() == "[D] step 1 of 3\n[T] value 2.2 text\n[I] ignored true\n[E] failed\n");
+
+        // the ring is empty after a dump
+        stream.str("");
+        logger.error("again");
+        REQUIRE(stream.str() == "[E] again\n");
+    }
+
+    SECTION("Only the last records are kept")
+    {
+        logger.enable_backtrace(2);
+        for (int i = 0; i < 5; ++i)
+            logger.debug("record {}", i);
+
+        logger.dump_backtrace();
+        REQUIRE(stream.str() == "[D] record 3\n[D] record 4\n");
+    }
+
+    SECTION("Records of several threads are kept in the order they were logged")
+    {
+        logger.enable_backtrace(4);
+        for (auto name : { "a", "b" })
+            std::thread([&] {
+                for (int i = 0; i < 3; ++i)
+                    logger.debug("{} {}", name, i);
+            }).join();
+        logger.debug("main");
+
+        logger.dump_backtrace();
+        REQUIRE(stream.str() == "[D] b 0\n[D] b 1\n[D] b 2\n[D] main\n");
+    }
+
+    SECTION("Threads keep records while the backtrace is dumped")
+    {
+        logger.enable_backtrace(16).set_pattern("%v");
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+            threads.emplace_back([&, t] {
+                for (int i = 0; i < 1000; ++i)
+                    logger.debug("{} {}", t, i);
+            });
+        for (int i = 0; i < 20; ++i)
+            logger.dump_backtrace();
+        for (auto& thread : threads)
+            thread.join();
+
+        stream.str("");
+        logger.dump_backtrace();
+        auto dumped = stream.str();
+        REQUIRE(std::count(dumped.begin(), dumped.end(), '\n') == 16);
+    }
+
+    SECTION("Records at the logger level are not kept")
+    {
+        logger.enable_backtrace(4, sevarity_t::critical);
+        logger.warn("logged");
+        logger.debug("kept");
+        logger.error("not a trigger");
+        REQUIRE(stream.str() == "[W] logged\n[E] not a trigger\n");
+
+        logger.crit("trigger");
+        REQUIRE(stream.str() == "[W] logged\n[E] not a trigger\n[D] kept\n[C] trigger\n");
+    }
+
+    SECTION("Macros and compile time format strings are kept with their call site")
+    {
+        logger.enable_backtrace(4).set_pattern("%s %v");
+        PRIDE_LOG_DEBUG(logger, "macro {}", 1);
+        logger.debug(PRIDE_FMT("ct {}"), 2);
+        logger.dump_backtrace();
+        REQUIRE(stream.str() == "backtrace.cpp macro 1\n ct 2\n");
+    }
+
+    SECTION("Nothing is kept without a backtrace")
+    {
+        logger.debug("dropped");
+        logger.dump_backtrace();
+        logger.enable_backtrace(4).disable_backtrace();
+        logger.debug("dropped");
+        logger.error("error");
+        REQUIRE(stream.str() == "[E] error\n");
+    }
+
+    SECTION("Async loggers replay the backtrace in order")
+    {
+        auto async = std::make_shared<async_logger_t>("backtrace.async");
+        async->add_channel<channels::ostream_mt>(stream);
+        async->set_pattern("%v");
+        async->enable_backtrace(4);
+        async->debug("before");
+        async->error("after");
+        async->flush();
+        REQUIRE(stream.str() == "before\nafter\n");
+    }
+}
@@ -0,0 +1,210 @@
+#include <test.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace pride::log;
+
+namespace
+{
+std::string read_file(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream stream;
+    stream << file.rdbuf();
+    return stream.str();
+}
+
+void write_file(const std::string& path, const std::string& content)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << content;
+}
+
+void remove_segments(const std::string& path)
+{
+    for (auto& segment : binary_reader_t(path).segments())
+        std::remove(segment.c_str());
+}
+
+std::vector<std::string> read_all(binary_reader_t& reader)
+{
+    std::vector<std::string> records;
+    reader.read([&](const message_t& msg) { records.emplace_back(msg.raw.data(), msg.raw.size()); });
+    return records;
+}
+} // namespace
+
+TEST_CASE("Binary file channel")
+{
+    const std::string long_text = "The quick brown fox jumps over the lazy dog";
+    const std::string path = "binary-file.plog";
+    remove_segments(path);
+
+    SECTION("Frames are checked with the standard crc32")
+    {
+        REQUIRE(internal::binary::crc("123456789", 9) == 0xCBF43926);
+        REQUIRE(internal::binary::crc("56789", 5, internal::binary::crc("1234", 4)) == 0xCBF43926);
+        REQUIRE(internal::binary::crc(long_text.data(), long_text.size()) == 0x414FA339);
+    }
+
+    SECTION("Records are read back through a formatter")
+    {
+        {
+            logger_t logger("binary");
+            logger.add_channel<channels::binary_file_st>(path);
+            logger.warn("first {}", 1);
+            logger.error("second");
+        }
+
+        std::ostringstream stream;
+        pattern_formatter_t formatter("[%n] [%l] %v");
+        binary_reader_t reader(path);
+        REQUIRE(reader.read(std::chrono::system_clock::time_point::min(), std::chrono::system_clock::time_point::max(), formatter, stream) == 2);
+        REQUIRE(stream.str() == "[binary] [warn] first 1\n[binary] [error] second\n");
+        REQUIRE(reader.segments().size() == 1);
+    }
+
+    SECTION("Time, level, thread and logger are kept")
+    {
+        const auto time = std::chrono::system_clock::from_time_t(1533206467) + std::chrono::microseconds(123456);
+        const std::string name = "binary.fields";
+        {
+            channels::binary_file_st channel(path);
+            message_t msg(&name, sevarity_t::critical);
+            msg.time = time;
+            msg.thread_id = 42;
+            fmt::format_to(msg.raw, "kept");
+            channel.log(msg);
+        }
+
+        binary_reader_t reader(path);
+        size_t count = 0;
+        reader.read([&](const message_t& msg) {
+            ++count;
+            REQUIRE(*msg.names == name);
+            REQUIRE(msg.sevarity == sevarity_t::critical);
+            REQUIRE(msg.time == time);
+            REQUIRE(msg.thread_id == 42);
+            REQUIRE(fmt::to_string(msg.raw) == "kept");
+        });
+        REQUIRE(count == 1);
+    }
+
+    SECTION("Records go into fixed size segments")
+    {
+        {
+            logger_t logger("binary.segments");
+            logger.add_channel<channels::binary_file_st>(path, 4096);
+            logger_t other("binary.other");
+            other.add_channel(logger.channels().front());
+            for (int i = 0; i < 500; ++i)
+            {
+                logger.warn("record {:04}", i);
+                other.warn("other {:04}", i);
+            }
+        }
+
+        binary_reader_t reader(path);
+        auto segments = reader.segments();
+        REQUIRE(segments.size() > 5);
+        for (auto& segment : segments)
+            REQUIRE(read_file(segment).size() < 4096 + 1024);
+
+        std::vector<std::string> names;
+        REQUIRE(reader.read([&](const message_t& msg) { names.push_back(*msg.names); }) == 1000);
+        REQUIRE(names.front() == "binary.segments");
+        REQUIRE(names.back() == "binary.other");
+
+        auto records = read_all(reader);
+        REQUIRE(records[0] == "record 0000");
+        REQUIRE(records[999] == "other 0499");
+    }
+
+    SECTION("A time range is found through the index")
+    {
+        const auto start = std::chrono::system_clock::from_time_t(1533206467);
+        const std::string name = "binary.index";
+        {
+            channels::binary_file_st channel(path, 1024 * 1024, 1024);
+            message_t msg(&name, sevarity_t::info);
+            for (int i = 0; i < 10000; ++i)
+            {
+                msg.time = start + std::chrono::milliseconds(i);
+                msg.raw.resize(0);
+                fmt::format_to(msg.raw, "record {}", i);
+                channel.log(msg);
+            }
+        }
+
+        binary_reader_t reader(path);
+        std::vector<std::string> records;
+        auto count = reader.read(start + std::chrono::milliseconds(5000), start + std::chrono::milliseconds(5009), [&](const message_t& msg) {
+            records.emplace_back(msg.raw.data(), msg.raw.size());
+        });
+        REQUIRE(count == 10);
+        REQUIRE(records.front() == "record 5000");
+        REQUIRE(records.back() == "record 5009");
+        REQUIRE(reader.scanned() < 100);
+
+        // a range outside of the segment is skipped by its footer
+        REQUIRE(reader.read(start + std::chrono::hours(1), start + std::chrono::hours(2), [](const message_t&) {}) == 0);
+        REQUIRE(reader.scanned() == 0);
+    }
+
+    SECTION("Corrupt tails are skipped")
+    {
+        {
+            logger_t logger("binary.corrupt");
+            logger.add_channel<channels::binary_file_st>(path);
+            for (int i = 0; i < 10; ++i)
+                logger.warn("record {}", i);
+        }
+
+        // a crash leaves the segment without its footer and with half a record
+        const auto segment = binary_reader_t(path).segments().front();
+        auto content = read_file(segment);
+        auto cut = content.find("record 9");
+        REQUIRE(cut != std::string::npos);
+        write_file(segment, content.substr(0, cut + 3));
+
+        binary_reader_t reader(path);
+        auto records = read_all(reader);
+        REQUIRE(records.size() == 9);
+        REQUIRE(records.back() == "record 8");
+        REQUIRE(reader.skipped() > 0);
+
+        // a damaged record ends the segment, the ones before it are still read
+        content = read_file(segment);
+        content[content.find("record 5") + 7] = 'X';
+        write_file(segment, content);
+        records = read_all(reader);
+        REQUIRE(records.size() == 5);
+        REQUIRE(records.back() == "record 4");
+    }
+
+    SECTION("A new channel starts a segment after the existing ones")
+    {
+        {
+            logger_t logger("binary.reopen");
+            logger.add_channel<channels::binary_file_st>(path);
+            logger.warn("before");
+        }
+        {
+            auto channel = std::make_shared<channels::binary_file_st>(path);
+            REQUIRE(channel->segment() == 2);
+            logger_t logger("binary.reopen");
+            logger.add_channel(channel);
+            logger.warn("after");
+        }
+
+        binary_reader_t reader(path);
+        REQUIRE(read_all(reader) == std::vector<std::string>{ "before", "after" });
+    }
+
+    remove_segments(path);
+}
@@ -0,0 +1,121 @@
+#include <test.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace pride::log;
+
+namespace
+{
+std::string read_file(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream stream;
+    stream << file.rdbuf();
+    return stream.str();
+}
+} // namespace
+
+TEST_CASE("Buffered file channel")
+{
+    const std::string path = "buffered-file.log";
+
+    SECTION("Records are written in large batches")
+    {
+        auto channel = std::make_shared<channels::buffered_file_st>(path, true, 4096);
+        logger_t logger("buffered-batches");
+        logger.add_channel(channel).set_pattern("%v");
+
+        for (int i = 0; i < 1000; ++i)
+            logger.warn("record number {:04}", i); // 19 bytes with the new line
+        REQUIRE(channel->submissions() == 4);
+
+        logger.flush();
+        REQUIRE(channel->submissions() == 5);
+
+        auto text = read_file(path);
+        REQUIRE(text.size() == 19000);
+        REQUIRE(text.compare(0, 19, "record number 0000\n") == 0);
+        REQUIRE(text.compare(text.size() - 19, 19, "record number 0999\n") == 0);
+    }
+
+    SECTION("Records larger than the buffer go out in one gather write")
+    {
+        auto channel = std::make_shared<channels::buffered_file_st>(path, true, 64);
+        logger_t logger("buffered-large");
+        logger.add_channel(channel).set_pattern("%v");
+
+        logger.warn("small");
+        logger.warn("{}", std::string(100, 'x'));
+        REQUIRE(channel->submissions() == 1);
+        REQUIRE(read_file(path) == "small\n" + std::string(100, 'x') + "\n");
+    }
+
+    SECTION("Flush on level")
+    {
+        auto channel = std::make_shared<channels::buffered_file_st>(path, true);
+        channel->flush_on(sevarity_t::error);
+        logger_t logger("buffered-level");
+        logger.add_channel(channel).set_pattern("%v");
+
+        logger.warn("kept");
+        REQUIRE(read_file(path).empty());
+        logger.error("written");
+        REQUIRE(read_file(path) == "kept\nwritten\n");
+    }
+
+    SECTION("Flush interval")
+    {
+        auto channel = std::make_shared<channels::buffered_file_mt>(path, true);
+        channel->flush_every(std::chrono::milliseconds(5));
+        logger_t logger("buffered-interval");
+        logger.add_channel(channel).set_pattern("%v");
+
+        logger.warn("eventually");
+        for (int i = 0; i < 200 && read_file(path).empty(); ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        REQUIRE(read_file(path) == "eventually\n");
+    }
+
+    SECTION("A failed write keeps the buffer and drops what does not fit")
+    {
+        auto channel = std::make_shared<channels::buffered_file_st>("missing-directory/buffered-file.log", true, 64);
+        logger_t logger("buffered-failed");
+        logger.add_channel(channel).set_pattern("%v");
+
+        for (int i = 0; i < 6; ++i)
+            logger.warn("record {}", i); // 9 bytes with the new line
+        REQUIRE(channel->submissions() == 0);
+
+        logger.warn("{}", std::string(20, 'x'));
+        REQUIRE(channel->failures() == 1);
+        REQUIRE(channel->dropped() == 1);
+
+        // the buffered records are still there, so the next large record
+        // goes to the file with them again and the flush tries them once more
+        logger.warn("{}", std::string(20, 'x'));
+        REQUIRE(channel->failures() == 2);
+        REQUIRE(channel->dropped() == 2);
+
+        logger.flush();
+        REQUIRE(channel->submissions() == 3);
+        REQUIRE(channel->failures() == 3);
+        REQUIRE(channel->dropped() == 2);
+    }
+
+    SECTION("Destruction writes what is left")
+    {
+        {
+            logger_t logger("buffered-destroy");
+            logger.add_channel<channels::buffered_file_st>(path, true).set_pattern("%v");
+            logger.warn("last words");
+        }
+        REQUIRE(read_file(path) == "last words\n");
+    }
+
+    std::remove(path.c_str());
+}
@@ -0,0 +1,121 @@
+#include <test.hpp>
+
+#include <memory>
+#include <sstream>
+#include <string>
+
+using namespace pride::log;
+
+namespace
+{
+// Pattern formatter that counts how often it runs, an empty pattern opts out
+// of sharing
+class counting_formatter_t : public formatter_t
+{
+public:
+    counting_formatter_t(const std::string& pattern, size_t& count)
+        : _pattern(pattern, "\n")
+        , _count(count)
+        , _shared(!pattern.empty())
+    {}
+
+    void format(const message_t& msg, fmt::memory_buffer& buffer) override
+    {
+        ++_count;
+        _pattern.format(msg, buffer);
+    }
+
+    const std::string& signature() const override { return _shared ? _pattern.signature() : formatter_t::signature(); }
+
+private:
+    pattern_formatter_t _pattern;
+    size_t& _count;
+    bool _shared;
+};
+
+std::shared_ptr<channels::ostream_st> make_channel(std::ostringstream& stream, const std::string& pattern, size_t& count)
+{
+    auto channel = std::make_shared<channels::ostream_st>(stream);
+    channel->formatter(std::make_unique<counting_formatter_t>(pattern, count));
+    return channel;
+}
+} // namespace
+
+TEST_CASE("Channels sharing a format signature")
+{
+    size_t count = 0;
+    std::ostringstream first, second, third;
+    logger_t logger("fan-out");
+
+    SECTION("Format once for identical patterns")
+    {
+        logger.add_channel(make_channel(first, "[%l] %v", count))
+            .add_channel(make_channel(second, "[%l] %v", count))
+            .add_channel(make_channel(third, "[%l] %v", count));
+
+        logger.warn("message {}", 1);
+        logger.error("message {}", 2);
+
+        REQUIRE(count == 2);
+        REQUIRE(first.str() == "[warn] message 1\n[error] message 2\n");
+        REQUIRE(second.str() == first.str());
+        REQUIRE(third.str() == first.str());
+    }
+
+    SECTION("Format once per distinct pattern")
+    {
+        logger.add_channel(make_channel(first, "[%l] %v", count))
+            .add_channel(make_channel(second, "%v", count))
+            .add_channel(make_channel(third, "[%l] %v", count));
+
+        logger.warn("message");
+
+        REQUIRE(count == 2);
+        REQUIRE(first.str() == "[warn] message\n");
+        REQUIRE(second.str() == "message\n");
+        REQUIRE(third.str() == "[warn] message\n");
+    }
+
+    SECTION("Text is grouped under the formatter that made it")
+    {
+        // replaces its own formatter the moment the logger reads its
+        // signature, as another thread setting a pattern could
+        struct replaced_formatter_t : public pattern_formatter_t
+        {
+            replaced_formatter_t(channel_t& channel)
+                : pattern_formatter_t("[%l] %v", "\n")
+                , channel(channel)
+            {}
+
+            const std::string& signature() const override
+            {
+                if (!replaced)
+                {
+                    replaced = true;
+                    channel.pattern("%v");
+                }
+                return pattern_formatter_t::signature();
+            }
+
+            channel_t& channel;
+            mutable bool replaced = false;
+        };
+
+        auto replaced = std::make_shared<channels::ostream_st>(first);
+        replaced->formatter(std::make_unique<replaced_formatter_t>(*replaced));
+        logger.add_channel(replaced).add_channel(make_channel(second, "[%l] %v", count));
+
+        logger.warn("message");
+
+        REQUIRE(first.str() == "message\n");
+        REQUIRE(second.str() == "[warn] message\n");
+    }
+
+    SECTION("Formatters without a signature are never shared")
+    {
+        logger.add_channel(make_channel(first, "", count)).add_channel(make_channel(second, "", count));
+        logger.warn("message");
+
+        REQUIRE(count == 2);
+    }
+}
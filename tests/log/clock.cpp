@@ -0,0 +1,111 @@
+#include <test.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace pride::log;
+
+namespace
+{
+// Distance between a record stamped now and the system clock
+std::chrono::microseconds skew()
+{
+    auto before = std::chrono::system_clock::now();
+    message_t msg(nullptr, sevarity_t::info);
+    auto after = std::chrono::system_clock::now();
+
+    if (msg.time < before)
+        return std::chrono::duration_cast<std::chrono::microseconds>(before - msg.time);
+    if (msg.time > after)
+        return std::chrono::duration_cast<std::chrono::microseconds>(msg.time - after);
+    return std::chrono::microseconds(0);
+}
+} // namespace
+
+TEST_CASE("Clock sources")
+{
+    SECTION("Records are stamped with the system clock by default")
+    {
+        REQUIRE(clock_source() == clock_source_t::precise);
+        REQUIRE(skew() == std::chrono::microseconds(0));
+    }
+
+    SECTION("The coarse clock is within a scheduler tick")
+    {
+        if (clock_source(clock_source_t::coarse))
+        {
+            REQUIRE(clock_source() == clock_source_t::coarse);
+            REQUIRE(skew() < std::chrono::milliseconds(20));
+        }
+    }
+
+    SECTION("The cycle counter gives wall time")
+    {
+        if (clock_source(clock_source_t::tsc))
+        {
+            REQUIRE(clock_source() == clock_source_t::tsc);
+            for (int i = 0; i < 100; ++i)
+                REQUIRE(skew() < std::chrono::milliseconds(1));
+
+            // a new anchor is taken once the last one is older than the interval
+            internal::tsc_clock.resync_interval(std::chrono::milliseconds(1));
+            for (int i = 0; i < 20; ++i)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                REQUIRE(skew() < std::chrono::milliseconds(1));
+            }
+            internal::tsc_clock.resync_interval(internal::tsc_clock_t::default_resync_interval);
+        }
+        else
+            REQUIRE(clock_source() == clock_source_t::precise);
+    }
+
+    SECTION("The cycle counter is calibrated once")
+    {
+        if (internal::tsc_clock_t::supported())
+        {
+            internal::tsc_clock_t clock;
+            REQUIRE_FALSE(clock.calibrated());
+
+            // without a rate it reads the system clock
+            auto before = std::chrono::system_clock::now();
+            REQUIRE(clock.now() >= before);
+
+            std::thread other([&] { clock.calibrate(); });
+            clock.calibrate();
+            other.join();
+            REQUIRE(clock.calibrated());
+
+            auto start = std::chrono::steady_clock::now();
+            clock.calibrate();
+            REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(5));
+            REQUIRE(std::chrono::abs(clock.now() - std::chrono::system_clock::now()) < std::chrono::milliseconds(1));
+        }
+    }
+
+    SECTION("Formatters render the time of the record")
+    {
+        for (auto source : { clock_source_t::coarse, clock_source_t::tsc })
+        {
+            if (!clock_source(source))
+                continue;
+
+            std::ostringstream stream;
+            logger_t logger("clock");
+            logger.add_channel<channels::ostream_st>(stream).set_pattern("%E");
+
+            auto before = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+            logger.warn("stamped");
+            auto after = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+
+            auto seconds = std::strtoll(stream.str().c_str(), nullptr, 10);
+            REQUIRE(seconds >= before - 1);
+            REQUIRE(seconds <= after);
+        }
+    }
+
+    clock_source(clock_source_t::precise);
+}
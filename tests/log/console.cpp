@@ -0,0 +1,93 @@
+#include <test.hpp>
+
+#include <cstdio>
+#include <string>
+
+using namespace pride::log;
+
+namespace
+{
+struct temporary_stream
+{
+    static FILE* stream()
+    {
+        static FILE* file = std::tmpfile();
+        return file;
+    }
+};
+
+using test_console_t = channels::internal::console<temporary_stream, internal::null_mutex>;
+
+long written()
+{
+    return std::ftell(temporary_stream::stream());
+}
+} // namespace
+
+TEST_CASE("Console channel modes")
+{
+    auto start = written();
+    logger_t logger("console-modes");
+
+    SECTION("Unbuffered writes every record")
+    {
+        logger.add_channel<test_console_t>().set_pattern("%v");
+        logger.warn("12345");
+        REQUIRE(written() - start == 6);
+        logger.warn("12345");
+        REQUIRE(written() - start == 12);
+    }
+
+    SECTION("Buffered holds records until flushed")
+    {
+        auto channel = std::make_shared<test_console_t>();
+        channel->buffered().pattern("%v");
+        logger.add_channel(channel);
+
+        logger.warn("12345");
+        logger.warn("12345");
+        REQUIRE(written() == start);
+
+        logger.flush();
+        REQUIRE(written() - start == 12);
+    }
+
+    SECTION("Buffered writes out when full")
+    {
+        auto channel = std::make_shared<test_console_t>();
+        channel->buffered(16).pattern("%v");
+        logger.add_channel(channel);
+
+        logger.warn("12345");
+        logger.warn("12345");
+        REQUIRE(written() == start);
+        logger.warn("12345");
+        REQUIRE(written() - start == 12);
+
+        logger.warn("{}", std::string(20, 'x'));
+        REQUIRE(written() - start == 39);
+    }
+
+    SECTION("Buffered writes out at the flush level")
+    {
+        auto channel = std::make_shared<test_console_t>();
+        channel->buffered().flush_on(sevarity_t::error).pattern("%v");
+        logger.add_channel(channel);
+
+        logger.warn("12345");
+        REQUIRE(written() == start);
+        logger.error("12345");
+        REQUIRE(written() - start == 12);
+    }
+
+    SECTION("Switching back to unbuffered writes out what is held")
+    {
+        auto channel = std::make_shared<test_console_t>();
+        channel->buffered().pattern("%v");
+        logger.add_channel(channel);
+
+        logger.warn("12345");
+        channel->mode(channels::console_mode_t::unbuffered);
+        REQUIRE(written() - start == 6);
+    }
+}
@@ -0,0 +1,179 @@
+#include <test.hpp>
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pride::log;
+
+namespace
+{
+struct point_t
+{
+    int x;
+    int y;
+};
+
+size_t count_lines(const std::string& str)
+{
+    size_t lines = 0;
+    for (auto c : str)
+        if (c == '\n')
+            ++lines;
+    return lines;
+}
+} // namespace
+
+namespace pride::log::fmt
+{
+template<>
+struct formatter<point_t>
+{
+    template<typename ParseContext>
+    constexpr auto parse(ParseContext& ctx)
+    {
+        return ctx.begin();
+    }
+
+    template<typename FormatContext>
+    auto format(const point_t& point, FormatContext& ctx)
+    {
+        return format_to(ctx.begin(), "({}, {})", point.x, point.y);
+    }
+};
+} // namespace pride::log::fmt
+
+TEST_CASE("Deferred argument codec")
+{
+    using namespace deferred;
+
+    const std::string name = "name";
+    const char* text = "text";
+    const auto values = std::make_tuple(deferred::internal::capture(-42), deferred::internal::capture(7u), deferred::internal::capture(1.5), deferred::internal::capture('c'),
+        deferred::internal::capture(true), deferred::internal::capture(name), deferred::internal::capture(text), deferred::internal::capture(point_t{ 1, 2 }));
+    constexpr auto sequence = std::make_index_sequence<8>();
+
+    std::vector<char> data(deferred::internal::encoded_size(values, sequence));
+    REQUIRE(deferred::internal::encode(data.data(), values, sequence) == data.data() + data.size());
+
+    const auto& types = deferred::internal::arg_types<int, unsigned, double, char, bool, std::string, const char*, point_t>::value;
+    decoded_arg_t args[8];
+    REQUIRE(decode_args(data.data(), data.size(), types, 8, args));
+    REQUIRE_FALSE(decode_args(data.data(), data.size() - 1, types, 8, args));
+
+    fmt::memory_buffer out;
+    render(out, "{} {:03} {:.2f} {} {} {} {{{}}} {}", args, 8);
+    REQUIRE(fmt::to_string(out) == "-42 007 1.50 c true name {text} (1, 2)");
+
+    out.resize(0);
+    render(out, "{1:>4}|{0}|{9}", args, 8);
+    REQUIRE(fmt::to_string(out) == "   7|-42|");
+
+    // a spec too long for the stack copy still formats like the live logger
+    const auto long_spec = "{5:>6." + std::string(70, '0') + "3}";
+    out.resize(0);
+    render(out, long_spec, args, 8);
+    REQUIRE(fmt::to_string(out) == fmt::format(long_spec, 0, 1, 2, 3, 4, name));
+}
+
+TEST_CASE("Deferred logger")
+{
+    SECTION("Records are formatted on the backend thread")
+    {
+        std::ostringstream stream;
+        deferred_logger_t logger("deferred-format");
+        logger.add_channel<channels::ostream_mt>(stream).set_pattern("%v");
+
+        for (int i = 0; i < 3; ++i)
+            PRIDE_LOG_DEFERRED(logger, sevarity_t::warn, "message {} of {}", i, std::string("three"));
+        logger.flush();
+
+        REQUIRE(stream.str() == "message 0 of three\nmessage 1 of three\nmessage 2 of three\n");
+    }
+
+    SECTION("Records carry the source of their statement")
+    {
+        std::ostringstream stream;
+        deferred_logger_t logger("deferred-source");
+        logger.add_channel<channels::ostream_mt>(stream).set_pattern("%s:%# %! %v");
+
+        const int line = __LINE__ + 1;
+        PRIDE_LOG_DEFERRED(logger, sevarity_t::warn, "here");
+        logger.flush();
+
+        REQUIRE(stream.str() == fmt::format("deferred.cpp:{} {} here\n", line, __func__));
+    }
+
+    SECTION("Records below the level are not captured")
+    {
+        std::ostringstream stream;
+        deferred_logger_t logger("deferred-level");
+        logger.add_channel<channels::ostream_mt>(stream).set_pattern("%v");
+        logger.sevarity(sevarity_t::error);
+
+        PRIDE_LOG_DEFERRED(logger, sevarity_t::warn, "dropped {}", 1);
+        PRIDE_LOG_DEFERRED(logger, sevarity_t::error, "kept {}", 2);
+        logger.flush();
+
+        REQUIRE(stream.str() == "kept 2\n");
+    }
+
+    SECTION("Every thread gets its own ring")
+    {
+        std::ostringstream stream;
+        {
+            deferred_logger_t logger("deferred-threads");
+            logger.add_channel<channels::ostream_mt>(stream).set_pattern("%v");
+
+            std::vector<std::thread> producers;
+            for (int t = 0; t < 4; ++t)
+            {
+                producers.emplace_back([&logger, t] {
+                    for (int i = 0; i < 500; ++i)
+                        PRIDE_LOG_DEFERRED(logger, sevarity_t::warn, "thread {} message {}", t, i);
+                });
+            }
+
+            for (auto& thread : producers)
+                thread.join();
+        }
+
+        REQUIRE(count_lines(stream.str()) == 2000);
+    }
+
+    SECTION("Binary output decodes to the same text")
+    {
+        const std::string path = "deferred-binary.log";
+        const std::string pattern = "[%n] [%l] %v";
+        {
+            deferred_logger_t logger("deferred-binary");
+            logger.binary_output(path);
+            PRIDE_LOG_DEFERRED(logger, sevarity_t::warn, "value {:x} at {}", 255, 1.25);
+            PRIDE_LOG_DEFERRED(logger, sevarity_t::error, "name {}", "pride");
+        }
+        const int line = __LINE__ - 2;
+
+        deferred::stream_reader_t reader(path);
+        REQUIRE(reader.good());
+        REQUIRE(reader.name() == "deferred-binary");
+
+        pattern_formatter_t formatter(pattern, "\n");
+        fmt::memory_buffer out;
+        message_t msg;
+        while (reader.next(msg))
+            formatter.format(msg, out);
+
+        REQUIRE(fmt::to_string(out) == "[deferred-binary] [warn] value ff at 1.25\n[deferred-binary] [error] name pride\n");
+
+        // the source survives the stream
+        deferred::stream_reader_t sources(path);
+        pattern_formatter_t source_formatter("%s:%# %!", "\n");
+        out.resize(0);
+        while (sources.next(msg))
+            source_formatter.format(msg, out);
+        REQUIRE(fmt::to_string(out) == fmt::format("deferred.cpp:{0} {1}\ndeferred.cpp:{2} {1}\n", line - 1, __func__, line));
+        std::remove(path.c_str());
+    }
+}
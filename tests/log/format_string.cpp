@@ -0,0 +1,56 @@
+#include <test.hpp>
+
+#include <sstream>
+#include <string>
+
+using namespace pride::log;
+
+namespace
+{
+template<typename Format, typename... Args>
+std::string format(Format, const Args&... args)
+{
+    fmt::memory_buffer buffer;
+    Format::format(buffer, args...);
+    return fmt::to_string(buffer);
+}
+} // namespace
+
+TEST_CASE("Compile time format strings")
+{
+    SECTION("Parsed at compile time")
+    {
+        constexpr auto format = PRIDE_FMT("a {} b {:>4} {{c}}");
+        constexpr auto program = decltype(format)::program;
+        static_assert(program.error == internal::format_string::error_t::none);
+        static_assert(program.arg_count == 2);
+        static_assert(program.segments[1].arg == 0 && !program.segments[1].has_spec);
+        static_assert(program.segments[3].arg == 1 && program.segments[3].has_spec);
+
+        constexpr auto broken_format = PRIDE_FMT("a {");
+        constexpr auto broken = decltype(broken_format)::program;
+        static_assert(broken.error == internal::format_string::error_t::unmatched_open_brace);
+    }
+
+    SECTION("Output matches fmt")
+    {
+        const std::string str = "string";
+        REQUIRE(format(PRIDE_FMT("plain text")) == "plain text");
+        REQUIRE(format(PRIDE_FMT("{} {} {} {}"), 42, -7L, 3u, 'c') == "42 -7 3 c");
+        REQUIRE(format(PRIDE_FMT("{} {} {}"), str, "literal", true) == "string literal true");
+        REQUIRE(format(PRIDE_FMT("{{{}}}"), 1) == "{1}");
+        REQUIRE(format(PRIDE_FMT("{:08x}|{:>6}|{:.2f}"), 255, str, 3.14159) == fmt::format("{:08x}|{:>6}|{:.2f}", 255, str, 3.14159));
+        REQUIRE(format(PRIDE_FMT("{1} {0} {1:*^5}"), 1, 2) == "2 1 **2**");
+        REQUIRE(format(PRIDE_FMT("{}"), 2.5) == fmt::format("{}", 2.5));
+    }
+
+    SECTION("Logger entry points")
+    {
+        std::ostringstream stream;
+        auto logger = logger_t::make_new("ct-format");
+        logger->add_channel<channels::ostream_st>(stream).set_pattern("%v");
+        logger->info(PRIDE_FMT("value {:03}"), 7);
+        logger->warn(PRIDE_FMT("no arguments"));
+        REQUIRE(stream.str() == "value 007\nno arguments\n");
+    }
+}
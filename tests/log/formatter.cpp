@@ -0,0 +1,172 @@
+#include <test.hpp>
+
+#include <support/log/flag_formatter.hpp>
+
+#include <chrono>
+#include <ctime>
+#include <initializer_list>
+#include <sstream>
+#include <string>
+
+using namespace pride::log;
+
+namespace
+{
+std::string format(pattern_formatter_t& formatter, message_t& msg, std::chrono::system_clock::time_point time)
+{
+    msg.time = time;
+    fmt::memory_buffer buffer;
+    formatter.format(msg, buffer);
+    return fmt::to_string(buffer);
+}
+
+std::string expected(const char* pattern, std::chrono::system_clock::time_point time)
+{
+    auto tm = internal::local_time(std::chrono::system_clock::to_time_t(time));
+    char text[128];
+    return std::string(text, std::strftime(text, sizeof(text), pattern, &tm));
+}
+} // namespace
+
+TEST_CASE("Pattern formatter time cache")
+{
+    const std::string name = "time";
+    message_t msg(&name, sevarity_t::warn);
+    fmt::format_to(msg.raw, "message");
+
+    using namespace std::chrono;
+    const auto start = system_clock::time_point(seconds(1536000000)) + milliseconds(7);
+
+    SECTION("Date and time flags follow the second of every record")
+    {
+        pattern_formatter_t formatter("%Y-%m-%d %H:%M:%S.%e %v", "");
+
+        REQUIRE(format(formatter, msg, start) == expected("%Y-%m-%d %H:%M:%S", start) + ".007 message");
+
+        auto later = start + milliseconds(500);
+        REQUIRE(format(formatter, msg, later) == expected("%Y-%m-%d %H:%M:%S", later) + ".507 message");
+
+        auto next = start + seconds(1) + milliseconds(2);
+        REQUIRE(format(formatter, msg, next) == expected("%Y-%m-%d %H:%M:%S", next) + ".009 message");
+
+        // records are not always in order, an older second renders again
+        REQUIRE(format(formatter, msg, start) == expected("%Y-%m-%d %H:%M:%S", start) + ".007 message");
+    }
+
+    SECTION("Sub second flags are padded to their width")
+    {
+        pattern_formatter_t formatter("%e|%f|%F", "");
+        auto time = start + microseconds(42) + nanoseconds(5);
+        auto text = format(formatter, msg, time_point_cast<system_clock::duration>(time));
+
+        auto ticks = duration_cast<nanoseconds>(time_point_cast<system_clock::duration>(time).time_since_epoch()).count() % 1000000000;
+        REQUIRE(text == fmt::format("{:03}|{:06}|{:09}", ticks / 1000000, ticks / 1000, ticks));
+    }
+
+    SECTION("Process id and offset from UTC")
+    {
+        pattern_formatter_t formatter("%P %z", "");
+        auto offset = expected("%z", start);
+        REQUIRE(offset.size() == 5);
+
+        REQUIRE(format(formatter, msg, start) == std::to_string(internal::process_id()) + ' ' + offset.substr(0, 3) + ':' + offset.substr(3));
+    }
+}
+
+namespace
+{
+template<typename Formatter>
+std::string render(Formatter& formatter, message_t& msg, std::chrono::system_clock::time_point time)
+{
+    msg.time = time;
+    fmt::memory_buffer buffer;
+    formatter.format(msg, buffer);
+    return fmt::to_string(buffer);
+}
+
+// Every time in `times` through the compiled formatters and the flag objects
+// they replaced, the output has to be the same to the byte
+template<typename Static>
+void require_same(const char* pattern, Static& compiled, message_t& msg, std::initializer_list<std::chrono::system_clock::time_point> times)
+{
+    pattern_formatter_t program(pattern);
+    internal::flag_pattern_formatter_t reference(pattern);
+    REQUIRE(program.signature() == reference.signature());
+    REQUIRE(compiled.signature() == reference.signature());
+
+    for (auto time : times)
+    {
+        auto expected = render(reference, msg, time);
+        REQUIRE(render(program, msg, time) == expected);
+        REQUIRE(render(compiled, msg, time) == expected);
+    }
+}
+} // namespace
+
+TEST_CASE("Compiled patterns")
+{
+    const std::string name = "compiled";
+    static const source_location_t source{ "src/log/main.cpp", 42, "main" };
+    message_t msg(&name, sevarity_t::error);
+    msg.thread_id = 1234;
+    fmt::format_to(msg.raw, "message {}", 7);
+
+    using namespace std::chrono;
+    const auto start = system_clock::time_point(seconds(1536000000)) + microseconds(7005);
+    const auto times = { start, start + milliseconds(250), start + seconds(1), start, start + hours(13) + nanoseconds(999) };
+
+#define PATTERN(literal)                                                       \
+    do                                                                         \
+    {                                                                          \
+        static_pattern_formatter_t compiled(PRIDE_PATTERN(literal));           \
+        require_same(literal, compiled, msg, times);                           \
+    } while (false)
+
+    SECTION("Every flag renders as before")
+    {
+        PATTERN("%+");
+        PATTERN("[%Y-%m-%d %H:%M:%S.%e] [%l] %v");
+        PATTERN("%n|%l|%L|%t|%P|%i|%v");
+        PATTERN("%a %A %b %B %c %C %Y %D %m %d");
+        PATTERN("%H %I %M %S %e %f %F %E %p %r %R %T %z");
+        PATTERN("%@ %g %s %# %!");
+    }
+
+    SECTION("Source flags follow the record")
+    {
+        msg.source = &source;
+        PATTERN("%@ %g %s %# %!");
+        msg.source = nullptr;
+    }
+
+    SECTION("Literal text and unknown flags")
+    {
+        PATTERN("");
+        PATTERN("plain text");
+        PATTERN("%%");
+        PATTERN("100%");
+        PATTERN("%q%Y%w-%v%");
+        PATTERN("a%Pb%zc");
+        PATTERN("%Y%+%Y");
+        PATTERN("x %+ y %+");
+    }
+
+    SECTION("Indent")
+    {
+        indent_t indent;
+        PATTERN("%i%v");
+    }
+
+#undef PATTERN
+
+    SECTION("Channels take a compiled pattern")
+    {
+        std::ostringstream stream;
+        logger_t logger("compiled");
+        logger.add_channel<channels::ostream_st>(stream).set_pattern(PRIDE_PATTERN("[%L] %v"));
+        logger.warn("once");
+        logger.set_pattern(PRIDE_PATTERN("%l: %v"));
+        logger.warn("twice");
+        REQUIRE(stream.str() == "[W] once" + std::string(internal::pattern::default_eol) + "warn: twice" + internal::pattern::default_eol);
+    }
+}
@@ -0,0 +1,209 @@
+#include <test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pride::log;
+
+namespace
+{
+// Channel that holds every record until it is opened, like a sink whose
+// output hangs
+class gated_channel : public base_channel<std::mutex>
+{
+public:
+    void open()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_gate_mutex);
+            _open = true;
+        }
+        _gate_cv.notify_all();
+    }
+
+    // waits until a record is held at the gate
+    void wait_for_stall()
+    {
+        while (!_stalled.load())
+            std::this_thread::yield();
+    }
+
+    std::string text()
+    {
+        std::lock_guard<std::mutex> lock(_gate_mutex);
+        return _text;
+    }
+
+protected:
+    void _process(const message_t&, const fmt::memory_buffer& formatted) override
+    {
+        std::unique_lock<std::mutex> lock(_gate_mutex);
+        _stalled = true;
+        _gate_cv.wait(lock, [this] { return _open; });
+        _text.append(formatted.data(), formatted.size());
+    }
+
+    void _flush() override {}
+
+private:
+    std::mutex _gate_mutex;
+    std::condition_variable _gate_cv;
+    bool _open{ false };
+    std::atomic<bool> _stalled{ false };
+    std::string _text;
+};
+
+class throwing_channel : public base_channel<std::mutex>
+{
+protected:
+    void _process(const message_t&, const fmt::memory_buffer&) override
+    {
+        throw std::runtime_error("unavailable");
+    }
+
+    void _flush() override {}
+};
+} // namespace
+
+TEST_CASE("Isolated channel")
+{
+    SECTION("Records reach the channel it runs")
+    {
+        std::ostringstream stream;
+        auto isolated = std::make_shared<channels::isolated>(std::make_shared<channels::ostream_mt>(stream));
+        logger_t logger("isolated");
+        logger.add_channel(isolated).set_pattern("[%n] %v");
+
+        for (int i = 0; i < 3; ++i)
+            logger.warn("record {}", i);
+        logger.flush();
+        REQUIRE(stream.str() == "[isolated] record 0\n[isolated] record 1\n[isolated] record 2\n");
+
+        auto stats = isolated->stats();
+        REQUIRE(stats.written == 3);
+        REQUIRE(stats.queue_depth == 0);
+        REQUIRE(stats.dropped == 0);
+    }
+
+    SECTION("A stalled channel does not hold up the others")
+    {
+        std::ostringstream stream;
+        auto gated = std::make_shared<gated_channel>();
+        auto isolated = std::make_shared<channels::isolated>(gated, 16);
+        isolated->flush_timeout(std::chrono::milliseconds(20));
+
+        logger_t logger("isolated.stalled");
+        logger.add_channel(isolated).add_channel<channels::ostream_st>(stream).set_pattern("%v");
+
+        logger.warn("first");
+        gated->wait_for_stall();
+        for (int i = 0; i < 100; ++i)
+            logger.warn("record {}", i);
+
+        // the flush gives up on the stalled channel
+        logger.flush();
+        REQUIRE(stream.str().size() == 6 + 100 * 10 - 10);
+
+        auto stats = isolated->stats();
+        REQUIRE(stats.queue_depth == 16);
+        REQUIRE(stats.dropped == 100 - 16);
+        REQUIRE(stats.written == 0);
+
+        gated->open();
+        isolated->flush_timeout(std::chrono::milliseconds(0));
+        logger.flush();
+        REQUIRE(isolated->stats().written == 17);
+        REQUIRE(gated->text().compare(0, 15, "first\nrecord 0\n") == 0);
+        REQUIRE(isolated->stats().max_latency >= std::chrono::milliseconds(10));
+    }
+
+    SECTION("The oldest records make room for new ones")
+    {
+        auto gated = std::make_shared<gated_channel>();
+        auto isolated = std::make_shared<channels::isolated>(gated, 4, overflow_policy_t::overwrite_oldest);
+        logger_t logger("isolated.overwrite");
+        logger.add_channel(isolated).set_pattern("%v");
+
+        logger.warn("0");
+        gated->wait_for_stall();
+        for (int i = 1; i < 10; ++i)
+            logger.warn("{}", i);
+
+        gated->open();
+        logger.flush();
+        REQUIRE(gated->text() == "0\n6\n7\n8\n9\n");
+        REQUIRE(isolated->stats().overwritten == 5);
+    }
+
+    SECTION("Records outlive the logger that logged them")
+    {
+        auto gated = std::make_shared<gated_channel>();
+        auto isolated = std::make_shared<channels::isolated>(gated);
+        {
+            logger_t logger("isolated.gone");
+            logger.add_channel(isolated).set_pattern("[%n] %v");
+            logger.warn("first");
+            gated->wait_for_stall();
+            logger.warn("second");
+        }
+
+        gated->open();
+        isolated->flush();
+        REQUIRE(gated->text() == "[isolated.gone] first\n[isolated.gone] second\n");
+    }
+
+    SECTION("Names of loggers that come and go are copied again after they are dropped")
+    {
+        std::ostringstream stream;
+        auto isolated = std::make_shared<channels::isolated>(std::make_shared<channels::ostream_mt>(stream));
+        std::string expected;
+
+        // more names than the channel keeps, flushed in batches so the
+        // worker drops them while the next loggers log
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 2; ++t)
+            threads.emplace_back([&, t] {
+                for (int i = 0; i < 400; ++i)
+                {
+                    logger_t logger(fmt::format("isolated.{}.{}", t, i));
+                    logger.add_channel(isolated).set_pattern("%n");
+                    logger.warn("");
+                    if (i % 50 == 0)
+                        logger.flush();
+                }
+            });
+        for (auto& thread : threads)
+            thread.join();
+        isolated->flush();
+
+        std::istringstream lines(stream.str());
+        size_t count = 0;
+        int next[2] = { 0, 0 };
+        for (std::string line; std::getline(lines, line); ++count)
+        {
+            auto t = line[9] - '0';
+            REQUIRE(line == fmt::format("isolated.{}.{}", t, next[t]++));
+        }
+        REQUIRE(count == 800);
+    }
+
+    SECTION("Failures are counted")
+    {
+        auto isolated = std::make_shared<channels::isolated>(std::make_shared<throwing_channel>());
+        logger_t logger("isolated.failed");
+        logger.add_channel(isolated);
+
+        logger.warn("lost");
+        logger.error("lost");
+        logger.flush();
+        REQUIRE(isolated->stats().failed == 2);
+        REQUIRE(isolated->stats().written == 0);
+    }
+}
@@ -0,0 +1,154 @@
+#include <test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pride::log;
+
+namespace
+{
+size_t count_lines(const std::string& text, const std::string& needle)
+{
+    size_t count = 0;
+    for (auto pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1))
+        ++count;
+    return count;
+}
+} // namespace
+
+TEST_CASE("Rate limiting and sampling")
+{
+    std::ostringstream stream;
+    logger_t logger("limits");
+    logger.add_channel<channels::ostream_st>(stream);
+    logger.set_pattern("%v");
+
+    SECTION("One in every N records of a call site is logged")
+    {
+        limits_t limits;
+        limits.sample = 4;
+        limits.report = std::chrono::milliseconds(0);
+        logger.limits(limits);
+
+        for (int i = 0; i < 10; ++i)
+            logger.warn("sampled {}", i);
+        REQUIRE(stream.str() == "sampled 0\nsuppressed 3 similar messages\nsampled 4\nsuppressed 3 similar messages\nsampled 8\n");
+    }
+
+    SECTION("Call sites are limited on their own")
+    {
+        limits_t limits;
+        limits.rate = 1;
+        limits.burst = 2;
+        limits.report = std::chrono::milliseconds(0);
+        logger.limits(limits);
+
+        for (int i = 0; i < 100; ++i)
+        {
+            logger.warn("first {}", i);
+            logger.warn("second {}", i);
+        }
+        REQUIRE(count_lines(stream.str(), "first") == 2);
+        REQUIRE(count_lines(stream.str(), "second") == 2);
+    }
+
+    SECTION("Macros are keyed on their statement")
+    {
+        limits_t limits;
+        limits.sample = 1000;
+        limits.report = std::chrono::milliseconds(0);
+        logger.limits(limits);
+
+        for (int i = 0; i < 10; ++i)
+        {
+            PRIDE_LOG_WARN(logger, "record {}", i);
+            PRIDE_LOG_WARN(logger, "record {}", i);
+        }
+        REQUIRE(stream.str() == "record 0\nrecord 0\n");
+    }
+
+    SECTION("Plain strings are keyed on the literal or their text")
+    {
+        limits_t limits;
+        limits.sample = 1000;
+        limits.report = std::chrono::milliseconds(0);
+        logger.limits(limits);
+
+        for (int i = 0; i < 10; ++i)
+        {
+            logger.warn("started");
+            logger.warn(std::string("connection lost"));
+            logger.warn(std::string("connection lost to ") + std::to_string(i % 2));
+            logger.warn(42);
+        }
+
+        // numbers have no key, the two texts of the third line count apart
+        std::string expected = "started\nconnection lost\nconnection lost to 0\n42\nconnection lost to 1\n";
+        for (int i = 1; i < 10; ++i)
+            expected += "42\n";
+        REQUIRE(stream.str() == expected);
+    }
+
+    SECTION("Exempt levels are never limited")
+    {
+        limits_t limits;
+        limits.sample = 1000;
+        limits.exempt = sevarity_t::error;
+        limits.report = std::chrono::milliseconds(0);
+        logger.limits(limits);
+
+        for (int i = 0; i < 3; ++i)
+            logger.error("error {}", i);
+        REQUIRE(stream.str() == "error 0\nerror 1\nerror 2\n");
+    }
+
+    SECTION("Quiet call sites report their suppressed records")
+    {
+        auto locked = std::make_shared<channels::ostream_mt>(stream);
+        locked->pattern("%v");
+        logger_t reported("limits.report");
+        reported.add_channel(locked);
+
+        limits_t limits;
+        limits.sample = 10;
+        limits.report = std::chrono::milliseconds(10);
+        reported.limits(limits);
+
+        for (int i = 0; i < 5; ++i)
+            reported.warn("noisy {}", i);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        reported.clear_limits();
+        reported.flush();
+        REQUIRE(stream.str() == "noisy 0\nsuppressed 4 similar messages: noisy {}\n");
+    }
+
+    SECTION("Admission is safe from many threads")
+    {
+        limits_t limits;
+        limits.sample = 8;
+        limits.report = std::chrono::milliseconds(0);
+
+        auto counted = std::make_shared<channels::ostream_mt>(stream);
+        counted->pattern("%v");
+        logger_t shared("limits.threads");
+        shared.add_channel(counted).limits(limits);
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&] {
+                for (int i = 0; i < 800; ++i)
+                    shared.warn("threaded {}", i);
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        REQUIRE(count_lines(stream.str(), "threaded") == 400);
+    }
+}
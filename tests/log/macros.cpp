@@ -0,0 +1,86 @@
+// trace statements are compiled out of this file
+#define PRIDE_LOG_ACTIVE_LEVEL PRIDE_LOG_LEVEL_DEBUG
+
+#include <test.hpp>
+
+#include <sstream>
+#include <string>
+
+using namespace pride::log;
+
+namespace
+{
+int evaluated = 0;
+
+int evaluate()
+{
+    return ++evaluated;
+}
+
+int log_from_helper(logger_t& logger)
+{
+    PRIDE_LOG_WARN(logger, "from helper");
+    return __LINE__ - 1;
+}
+} // namespace
+
+TEST_CASE("Logging macros")
+{
+    std::ostringstream stream;
+    logger_t logger("macros");
+    logger.add_channel<channels::ostream_st>(stream);
+    evaluated = 0;
+
+    SECTION("Levels below the active level are compiled out")
+    {
+        logger.sevarity(sevarity_t::trace);
+        PRIDE_LOG_TRACE(logger, "{}", evaluate());
+        PRIDE_LOG_DEBUG(logger, "{}", evaluate());
+
+        REQUIRE(evaluated == 1);
+        REQUIRE(stream.str().find("] 1") != std::string::npos);
+    }
+
+    SECTION("Arguments are not evaluated when the logger rejects the level")
+    {
+        logger.sevarity(sevarity_t::warn);
+        PRIDE_LOG_DEBUG(logger, "{}", evaluate());
+        PRIDE_LOG_INFO(logger, "{}", evaluate());
+        REQUIRE(evaluated == 0);
+        REQUIRE(stream.str().empty());
+
+        PRIDE_LOG_ERROR(logger, "{}", evaluate());
+        REQUIRE(evaluated == 1);
+    }
+
+    SECTION("Pattern flags print the call site")
+    {
+        logger.set_pattern("%s:%# %! %v");
+        auto line = log_from_helper(logger);
+        REQUIRE(stream.str() == "macros.cpp:" + std::to_string(line) + " log_from_helper from helper\n");
+
+        stream.str("");
+        logger.set_pattern("%@|%g");
+        log_from_helper(logger);
+        REQUIRE(stream.str() == std::string(__FILE__) + ":" + std::to_string(line) + "|" + __FILE__ + "\n");
+    }
+
+    SECTION("Records logged without a macro have no call site")
+    {
+        logger.set_pattern("[%@%s%#%!] %v");
+        logger.warn("plain");
+        REQUIRE(stream.str() == "[] plain\n");
+    }
+
+    SECTION("Every level name matches its severity")
+    {
+        logger.sevarity(sevarity_t::trace).set_pattern("%l %L");
+        logger.trace(1);
+        logger.debug(2);
+        logger.info(3);
+        logger.warn(4);
+        logger.error(5);
+        logger.crit(6);
+        REQUIRE(stream.str() == "trace T\ndebug D\ninfo I\nwarn W\nerror E\ncrit C\n");
+    }
+}
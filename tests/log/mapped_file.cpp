@@ -0,0 +1,175 @@
+#include <test.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !defined(PRIDE_OS_WINDOWS)
+#    include <csignal>
+#    include <sys/resource.h>
+#endif
+
+using namespace pride::log;
+
+namespace
+{
+std::string read_file(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream stream;
+    stream << file.rdbuf();
+    return stream.str();
+}
+
+std::string numbered_records(int count)
+{
+    std::string text;
+    for (int i = 0; i < count; ++i)
+        text += fmt::format("record number {:04}\n", i);
+    return text;
+}
+} // namespace
+
+TEST_CASE("Memory mapped file channel")
+{
+    const std::string path = "mapped-file.log";
+    const auto chunk = pride::os::mapped_region_t::mapped_file_granularity();
+
+    SECTION("Records are in the file before the channel closes")
+    {
+        auto channel = std::make_shared<channels::mapped_file_st>(path, true, chunk);
+        logger_t logger("mapped-live");
+        logger.add_channel(channel).set_pattern("%v");
+
+        for (int i = 0; i < 1000; ++i)
+            logger.warn("record number {:04}", i);
+        REQUIRE(channel->size() == 19000);
+        REQUIRE(channel->dropped() == 0);
+
+        // the page cache already has them, the rest up to the chunk end is zeros
+        auto text = read_file(path);
+        REQUIRE(text.size() % chunk == 0);
+        REQUIRE(text.compare(0, 19000, numbered_records(1000)) == 0);
+        REQUIRE(text.find_first_not_of('\0', 19000) == std::string::npos);
+
+        logger.flush();
+    }
+
+    SECTION("Closing cuts the file after the last record")
+    {
+        {
+            auto channel = std::make_shared<channels::mapped_file_st>(path, true, chunk);
+            logger_t logger("mapped-close");
+            logger.add_channel(channel).set_pattern("%v");
+            for (int i = 0; i < 1000; ++i)
+                logger.warn("record number {:04}", i);
+        }
+        REQUIRE(read_file(path) == numbered_records(1000));
+    }
+
+    SECTION("Records larger than a chunk")
+    {
+        const std::string large(chunk * 2 + 100, 'x');
+        {
+            auto channel = std::make_shared<channels::mapped_file_st>(path, true, chunk);
+            logger_t logger("mapped-large");
+            logger.add_channel(channel).set_pattern("%v");
+            logger.warn("small");
+            logger.warn("{}", large);
+            logger.warn("tail");
+        }
+        REQUIRE(read_file(path) == "small\n" + large + "\ntail\n");
+    }
+
+    SECTION("A file left by a crash is continued after its last record")
+    {
+        {
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            file << "before\n" << std::string(chunk * 2 - 7, '\0');
+        }
+
+        {
+            auto channel = std::make_shared<channels::mapped_file_st>(path, false, chunk);
+            logger_t logger("mapped-crash");
+            logger.add_channel(channel).set_pattern("%v");
+            logger.warn("after");
+        }
+        REQUIRE(read_file(path) == "before\nafter\n");
+    }
+
+#if !defined(PRIDE_OS_WINDOWS)
+    SECTION("A record dropped because the file could not grow leaves no bytes behind")
+    {
+        auto record = [](int i) { return std::string(999, static_cast<char>('a' + i)); };
+        std::string expected;
+        {
+            // the file may not grow past two chunks for a while
+            rlimit old;
+            ::getrlimit(RLIMIT_FSIZE, &old);
+            auto handler = std::signal(SIGXFSZ, SIG_IGN);
+            rlimit limit = old;
+            limit.rlim_cur = chunk * 2;
+            ::setrlimit(RLIMIT_FSIZE, &limit);
+
+            auto channel = std::make_shared<channels::mapped_file_st>(path, true, chunk);
+            logger_t logger("mapped-full");
+            logger.add_channel(channel).set_pattern("%v");
+
+            int i = 0;
+            for (; channel->dropped() == 0; ++i)
+            {
+                logger.warn("{}", record(i));
+                if (channel->dropped() == 0)
+                    expected += record(i) + "\n";
+            }
+            REQUIRE(channel->size() == expected.size());
+
+            ::setrlimit(RLIMIT_FSIZE, &old);
+            std::signal(SIGXFSZ, handler);
+
+            // the preparer may still fail once before it sees the new limit
+            for (int accepted = 0; accepted < 2; ++i)
+            {
+                auto dropped = channel->dropped();
+                logger.warn("{}", record(i));
+                if (channel->dropped() == dropped)
+                {
+                    expected += record(i) + "\n";
+                    ++accepted;
+                }
+            }
+            REQUIRE(channel->size() == expected.size());
+        }
+        REQUIRE(read_file(path) == expected);
+    }
+#endif
+
+    SECTION("Threads share the channel")
+    {
+        {
+            auto channel = std::make_shared<channels::mapped_file_mt>(path, true, chunk);
+            logger_t logger("mapped-threads");
+            logger.add_channel(channel).set_pattern("%v");
+
+            std::vector<std::thread> threads;
+            for (int t = 0; t < 4; ++t)
+                threads.emplace_back([&logger] {
+                    for (int i = 0; i < 500; ++i)
+                        logger.warn("0123456789");
+                });
+            for (auto& thread : threads)
+                thread.join();
+            logger.flush();
+        }
+
+        std::string expected;
+        for (int i = 0; i < 2000; ++i)
+            expected += "0123456789\n";
+        REQUIRE(read_file(path) == expected);
+    }
+
+    std::remove(path.c_str());
+}
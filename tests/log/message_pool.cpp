@@ -0,0 +1,47 @@
+#include <test.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pride::log;
+
+TEST_CASE("Message pool")
+{
+    static const std::string name = "pool";
+
+    SECTION("Records are recycled with their capacity")
+    {
+        const message_t* address;
+        size_t capacity;
+        {
+            auto msg = internal::message_pool_t::acquire(&name, sevarity_t::info);
+            fmt::format_to(msg->raw, "{}", std::string(4096, 'x'));
+            address = msg.get();
+            capacity = msg->raw.capacity();
+        }
+
+        auto msg = internal::message_pool_t::acquire(&name, sevarity_t::warn);
+        REQUIRE(msg.get() == address);
+        REQUIRE(msg->raw.size() == 0);
+        REQUIRE(msg->raw.capacity() == capacity);
+        REQUIRE(msg->sevarity == sevarity_t::warn);
+    }
+
+    SECTION("Records released on another thread return to their owner")
+    {
+        auto msg = internal::message_pool_t::acquire(&name, sevarity_t::info);
+        auto address = msg.get();
+        std::thread([&msg] { msg.reset(); }).join();
+
+        // the local free list is used up before the returned records
+        std::vector<message_ptr> held;
+        bool recycled = false;
+        for (int i = 0; i < 64 && !recycled; ++i)
+        {
+            held.push_back(internal::message_pool_t::acquire(&name, sevarity_t::info));
+            recycled = held.back().get() == address;
+        }
+        REQUIRE(recycled);
+    }
+}
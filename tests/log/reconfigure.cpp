@@ -0,0 +1,136 @@
+#include <test.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace pride::log;
+
+namespace
+{
+class counting_channel_t : public base_channel<std::mutex>
+{
+public:
+    std::atomic<size_t> count{ 0 };
+
+protected:
+    void _process(const message_t&, const fmt::memory_buffer&) override { count.fetch_add(1); }
+    void _flush() override {}
+};
+
+struct tracked_t
+{
+    explicit tracked_t(std::atomic<int>& destroyed)
+        : destroyed(destroyed)
+    {}
+    ~tracked_t() { destroyed.fetch_add(1); }
+
+    std::atomic<int>& destroyed;
+};
+} // namespace
+
+TEST_CASE("Reconfiguring loggers while logging")
+{
+    auto& rcu = internal::rcu_t::instance();
+
+    SECTION("Channels are added and removed")
+    {
+        logger_t logger("reconfigure");
+        auto first = std::make_shared<counting_channel_t>();
+        auto second = std::make_shared<counting_channel_t>();
+
+        logger.add_channel(first).add_channel(second);
+        logger.warn("both");
+        logger.remove_channel(first);
+        logger.warn("second");
+
+        REQUIRE(logger.channels().size() == 1);
+        REQUIRE(first->count == 1);
+        REQUIRE(second->count == 2);
+    }
+
+    SECTION("Retired objects wait for readers")
+    {
+        std::atomic<int> destroyed{ 0 };
+        std::atomic<bool> entered{ false };
+        std::atomic<bool> release{ false };
+
+        std::thread reader([&] {
+            internal::rcu_t::read_guard_t guard;
+            entered = true;
+            while (!release)
+                std::this_thread::yield();
+        });
+        while (!entered)
+            std::this_thread::yield();
+
+        rcu.retire(new tracked_t(destroyed));
+        rcu.reclaim();
+        REQUIRE(destroyed == 0);
+
+        release = true;
+        reader.join();
+        rcu.reclaim();
+        REQUIRE(destroyed == 1);
+        REQUIRE(rcu.pending() == 0);
+    }
+
+    SECTION("Read sections nest")
+    {
+        std::atomic<int> destroyed{ 0 };
+        {
+            internal::rcu_t::read_guard_t outer;
+            {
+                internal::rcu_t::read_guard_t inner;
+            }
+            rcu.retire(new tracked_t(destroyed));
+            REQUIRE(destroyed == 0);
+        }
+        rcu.reclaim();
+        REQUIRE(destroyed == 1);
+    }
+
+    SECTION("Configuration changes under load")
+    {
+        auto logger = logger_t::make_new("reconfigure.load");
+        auto counter = std::make_shared<counting_channel_t>();
+        logger->add_channel(counter).sevarity(sevarity_t::warn);
+
+        std::atomic<bool> done{ false };
+        std::vector<std::thread> producers;
+        for (int i = 0; i < 4; ++i)
+        {
+            producers.emplace_back([&] {
+                while (!done)
+                {
+                    logger->warn("record {}", 1);
+                    logger->info("maybe {}", 2);
+                }
+            });
+        }
+
+        for (int i = 0; i < 200; ++i)
+        {
+            auto extra = std::make_shared<counting_channel_t>();
+            logger->add_channel(extra);
+            logger->set_pattern(i % 2 ? "%v" : "[%l] %v");
+            logger->sevarity(i % 2 ? sevarity_t::info : sevarity_t::warn);
+            counter->sevarity(i % 2 ? sevarity_t::trace : sevarity_t::warn).use_sevarity(i % 3 == 0);
+            logger->remove_channel(extra);
+        }
+
+        while (counter->count < 1000)
+            std::this_thread::yield();
+        done = true;
+        for (auto& producer : producers)
+            producer.join();
+
+        REQUIRE(counter->count > 0);
+        REQUIRE(logger->channels().size() == 1);
+
+        rcu.reclaim();
+        REQUIRE(rcu.pending() == 0);
+    }
+}
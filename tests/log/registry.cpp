@@ -0,0 +1,107 @@
+#include <test.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pride::log;
+
+TEST_CASE("Logger registry")
+{
+    SECTION("Created loggers can be found by name")
+    {
+        auto logger = logger_t::create("registry.lookup");
+        std::string name = "registry.lookup";
+
+        REQUIRE(logger_t::get(name) == logger.get());
+        REQUIRE(logger_t::get("registry.lookup") == logger.get());
+        REQUIRE(PRIDE_LOGGER("registry.lookup") == logger.get());
+        REQUIRE(logger->name() == "registry.lookup");
+    }
+
+    SECTION("Unknown names are not found")
+    {
+        REQUIRE(logger_t::get("registry.missing") == nullptr);
+        REQUIRE(logger_t::get(std::string("registry.missing")) == nullptr);
+    }
+
+    SECTION("Keys are computed at compile time")
+    {
+        constexpr logger_key_t key("registry.key");
+        static_assert(key.value == logger_key_t("registry.key").value);
+        static_assert(key.value != logger_key_t("registry.other").value);
+        REQUIRE(logger_key_t(std::string_view("registry.key")).value == key.value);
+    }
+
+    SECTION("Keys are compared on their name as well as their hash")
+    {
+        auto logger = logger_t::create("registry.compared");
+        constexpr logger_key_t key("registry.compared");
+
+        REQUIRE(logger_t::get(key) == logger.get());
+        REQUIRE(logger_t::get(logger_key_t(key.value, "registry.impostor")) == nullptr);
+
+        // a buffer longer than the name it holds
+        char buffer[64] = "registry.compared";
+        REQUIRE(logger_t::get(buffer) == logger.get());
+    }
+
+    SECTION("Names with the same hash are both registered")
+    {
+        // a 64 bit collision cannot be searched for, the keys are forced
+        auto& registry = internal::registry_t::instance();
+        auto first = logger_t::make_new("registry.collide.first");
+        auto second = logger_t::make_new("registry.collide.second");
+        registry.insert(logger_key_t(42, "registry.collide.first"), first);
+        registry.insert(logger_key_t(42, "registry.collide.second"), second);
+
+        REQUIRE(registry.find(logger_key_t(42, "registry.collide.first")) == first.get());
+        REQUIRE(registry.find(logger_key_t(42, "registry.collide.second")) == second.get());
+        REQUIRE(registry.find(logger_key_t(42, "registry.collide.third")) == nullptr);
+    }
+
+    SECTION("A logger with the same name replaces the old one")
+    {
+        auto first = logger_t::create("registry.replace");
+        auto second = logger_t::create("registry.replace");
+
+        REQUIRE(first != second);
+        REQUIRE(logger_t::get("registry.replace") == second.get());
+    }
+
+    SECTION("Lookups run while loggers are registered")
+    {
+        auto logger = logger_t::create("registry.concurrent");
+
+        std::atomic<bool> done{ false };
+        std::atomic<size_t> misses{ 0 };
+        std::vector<std::thread> readers;
+        for (int i = 0; i < 4; ++i)
+        {
+            readers.emplace_back([&] {
+                while (!done.load())
+                {
+                    if (PRIDE_LOGGER("registry.concurrent") != logger.get())
+                        misses.fetch_add(1);
+                }
+            });
+        }
+
+        // enough to grow the table a few times
+        for (int i = 0; i < 500; ++i)
+            logger_t::create("registry.filler." + std::to_string(i));
+
+        done = true;
+        for (auto& reader : readers)
+            reader.join();
+
+        REQUIRE(misses.load() == 0);
+        for (int i = 0; i < 500; ++i)
+        {
+            auto name = "registry.filler." + std::to_string(i);
+            REQUIRE(logger_t::get(name) != nullptr);
+            REQUIRE(logger_t::get(name)->name() == name);
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#include <test.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace pride::log;
+
+namespace
+{
+bool exists(const std::string& path)
+{
+    return std::ifstream(path).good();
+}
+
+std::string read_file(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream stream;
+    stream << file.rdbuf();
+    return stream.str();
+}
+
+void remove_all(const std::string& path)
+{
+    for (size_t i = 0; i < 6; ++i)
+        std::remove(channels::internal::history_name(path, i).c_str());
+}
+} // namespace
+
+TEST_CASE("Rotating file channel")
+{
+    SECTION("History names keep the extension")
+    {
+        using channels::internal::history_name;
+        REQUIRE(history_name("logs/app.log", 0) == "logs/app.log");
+        REQUIRE(history_name("logs/app.log", 2) == "logs/app.2.log");
+        REQUIRE(history_name("logs/app", 1) == "logs/app.1");
+        REQUIRE(history_name("logs.d/app", 1) == "logs.d/app.1");
+        REQUIRE(history_name(".log", 1) == ".log.1");
+    }
+
+    SECTION("Rolls over on size and keeps max files")
+    {
+        const std::string path = "rotating-size.log";
+        remove_all(path);
+        {
+            logger_t logger("rotating-size");
+            logger.add_channel<channels::rotating_file_st>(path, 100, 2).set_pattern("%v");
+
+            // 10 bytes a record, 10 records a file
+            for (int i = 0; i < 35; ++i)
+                logger.warn("record {:02}", i);
+        }
+
+        REQUIRE(read_file(path) == "record 30\nrecord 31\nrecord 32\nrecord 33\nrecord 34\n");
+        REQUIRE(read_file(channels::internal::history_name(path, 1)).compare(0, 10, "record 20\n") == 0);
+        REQUIRE(read_file(channels::internal::history_name(path, 1)).size() == 100);
+        REQUIRE(read_file(channels::internal::history_name(path, 2)).compare(0, 10, "record 10\n") == 0);
+        REQUIRE_FALSE(exists(channels::internal::history_name(path, 3)));
+        REQUIRE_FALSE(exists(path + ".next"));
+        remove_all(path);
+    }
+
+    SECTION("Rolls over on the hour")
+    {
+        const std::string path = "rotating-hourly.log";
+        remove_all(path);
+        {
+            auto channel = std::make_shared<channels::rotating_file_st>(path, 0, 3, channels::rotation_interval_t::hourly);
+            channel->pattern("%v");
+
+            const std::string name = "rotating-hourly";
+            message_t msg(&name, sevarity_t::warn);
+            auto log = [&](const char* text, std::chrono::system_clock::time_point time) {
+                msg.raw.resize(0);
+                fmt::format_to(msg.raw, "{}", text);
+                msg.time = time;
+                channel->log(msg);
+            };
+
+            auto now = std::chrono::system_clock::now();
+            log("first", now);
+            log("second", now + std::chrono::hours(1));
+            log("third", now + std::chrono::hours(1) + std::chrono::seconds(1));
+            log("fourth", now + std::chrono::hours(2));
+        }
+
+        REQUIRE(read_file(path) == "fourth\n");
+        REQUIRE(read_file(channels::internal::history_name(path, 1)) == "second\nthird\n");
+        REQUIRE(read_file(channels::internal::history_name(path, 2)) == "first\n");
+        remove_all(path);
+    }
+}
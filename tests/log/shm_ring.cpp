@@ -0,0 +1,236 @@
+#include <test.hpp>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !defined(PRIDE_OS_WINDOWS)
+#    include <sys/wait.h>
+#    include <unistd.h>
+#endif
+
+using namespace pride::log;
+
+namespace
+{
+std::string ring_name(const char* test)
+{
+#if defined(PRIDE_OS_WINDOWS)
+    return fmt::format("pride-test-{}", test);
+#else
+    return fmt::format("/pride-test-{}-{}", test, ::getpid());
+#endif
+}
+
+std::vector<std::string> drain_text(shm_reader_t& reader, const char* pattern = "%n %l %v")
+{
+    pattern_formatter_t formatter(pattern, "");
+    std::vector<std::string> lines;
+    fmt::memory_buffer buffer;
+    reader.drain([&](const message_t& msg) {
+        buffer.resize(0);
+        formatter.format(msg, buffer);
+        lines.emplace_back(buffer.data(), buffer.size());
+    });
+    return lines;
+}
+} // namespace
+
+TEST_CASE("Shared memory ring channel")
+{
+    SECTION("Records reach the reader with their logger, level and source")
+    {
+        auto name = ring_name("records");
+        auto channel = std::make_shared<channels::shm_ring_st>(name, 4096);
+        REQUIRE(channel->is_open());
+        logger_t logger("ring-records");
+        logger.add_channel(channel);
+
+        logger.warn("first {}", 1);
+        logger.error("second");
+        PRIDE_LOG_WARN(logger, "from a macro");
+
+        shm_reader_t reader(name);
+        REQUIRE(reader.attach());
+        auto lines = drain_text(reader, "%n %l %v%s");
+        REQUIRE(lines.size() == 3);
+        REQUIRE(lines[0] == "ring-records warn first 1");
+        REQUIRE(lines[1] == "ring-records error second");
+        REQUIRE(lines[2] == "ring-records warn from a macroshm_ring.cpp");
+        REQUIRE(reader.pending() == 0);
+        REQUIRE(drain_text(reader).empty());
+
+        channels::shm_ring_st::remove(name);
+    }
+
+    SECTION("A full ring drops the newest records and the reader sees the gap")
+    {
+        auto name = ring_name("full");
+        auto channel = std::make_shared<channels::shm_ring_st>(name, 512);
+        logger_t logger("ring-full");
+        logger.add_channel(channel);
+
+        for (int i = 0; i < 20; ++i)
+            logger.warn("record number {:04}", i);
+        REQUIRE(channel->dropped() > 0);
+
+        shm_reader_t reader(name);
+        auto kept = drain_text(reader).size();
+        REQUIRE(kept + channel->dropped() == 20);
+
+        logger.warn("after the drain");
+        auto lines = drain_text(reader);
+        REQUIRE(lines.size() == 1);
+        REQUIRE(lines[0] == "ring-full warn after the drain");
+        REQUIRE(reader.missed() == channel->dropped());
+
+        channels::shm_ring_st::remove(name);
+    }
+
+    SECTION("Records wrap around the end of the ring")
+    {
+        auto name = ring_name("wrap");
+        auto channel = std::make_shared<channels::shm_ring_st>(name, 1024);
+        logger_t logger("ring-wrap");
+        logger.add_channel(channel);
+        shm_reader_t reader(name);
+
+        std::vector<std::string> lines;
+        for (int i = 0; i < 1000; ++i)
+        {
+            logger.warn("record {} {}", i, std::string(static_cast<size_t>(i % 50), 'x'));
+            if (i % 7 == 0)
+                for (auto& line : drain_text(reader, "%v"))
+                    lines.push_back(line);
+        }
+        for (auto& line : drain_text(reader, "%v"))
+            lines.push_back(line);
+
+        REQUIRE(channel->dropped() == 0);
+        REQUIRE(reader.missed() == 0);
+        REQUIRE(lines.size() == 1000);
+        for (int i = 0; i < 1000; ++i)
+            REQUIRE(lines[static_cast<size_t>(i)] == fmt::format("record {} {}", i, std::string(static_cast<size_t>(i % 50), 'x')));
+
+        channels::shm_ring_st::remove(name);
+    }
+
+    SECTION("Records over half the ring are dropped, records up to half of it wrap")
+    {
+        for (auto policy : { overflow_policy_t::drop_newest, overflow_policy_t::block })
+        {
+            auto name = ring_name("half");
+            channels::shm_ring_st::remove(name);
+            auto channel = std::make_shared<channels::shm_ring_st>(name, 1024, policy);
+            logger_t logger("ring-half");
+            logger.add_channel(channel);
+            shm_reader_t reader(name);
+
+            // 464 bytes each, the ring is left at 928
+            logger.warn(std::string(400, 'a'));
+            logger.warn(std::string(400, 'a'));
+            REQUIRE(drain_text(reader, "%v").size() == 2);
+
+            // 512 bytes, wraps to the start of the ring
+            logger.warn(std::string(448, 'b'));
+            REQUIRE(channel->dropped() == 0);
+            REQUIRE(drain_text(reader, "%v") == std::vector<std::string>{ std::string(448, 'b') });
+
+            // 520 bytes, one record more than half the ring
+            logger.warn(std::string(460, 'c'));
+            REQUIRE(channel->dropped() == 1);
+            logger.warn("after");
+            REQUIRE(drain_text(reader, "%v") == std::vector<std::string>{ "after" });
+            REQUIRE(reader.missed() == 1);
+
+            channels::shm_ring_st::remove(name);
+        }
+    }
+
+    SECTION("A new channel carries on after the records left in the ring")
+    {
+        auto name = ring_name("reopen");
+        {
+            auto channel = std::make_shared<channels::shm_ring_st>(name, 4096);
+            logger_t logger("ring-reopen");
+            logger.add_channel(channel);
+            logger.warn("before");
+        }
+        {
+            auto channel = std::make_shared<channels::shm_ring_st>(name, 4096);
+            logger_t logger("ring-reopen");
+            logger.add_channel(channel);
+            logger.warn("after");
+        }
+
+        shm_reader_t reader(name);
+        auto lines = drain_text(reader, "%v");
+        REQUIRE(lines == std::vector<std::string>{ "before", "after" });
+        REQUIRE(reader.missed() == 0);
+
+        channels::shm_ring_st::remove(name);
+    }
+
+    SECTION("A waiting reader is woken by the next record")
+    {
+        auto name = ring_name("wait");
+        auto channel = std::make_shared<channels::shm_ring_mt>(name, 4096);
+        logger_t logger("ring-wait");
+        logger.add_channel(channel).set_pattern("%v");
+
+        shm_reader_t reader(name);
+        REQUIRE(reader.attach());
+
+        std::thread writer([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            logger.warn("woken");
+        });
+        auto start = std::chrono::steady_clock::now();
+        while (reader.pending() == 0 && std::chrono::steady_clock::now() - start < std::chrono::seconds(10))
+            reader.wait(std::chrono::seconds(10));
+        writer.join();
+
+        // on Linux the writer wakes the reader, elsewhere it looks every millisecond
+        REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+        REQUIRE(drain_text(reader, "%v") == std::vector<std::string>{ "woken" });
+
+        // with records waiting it returns at once
+        logger.warn("waiting");
+        start = std::chrono::steady_clock::now();
+        reader.wait(std::chrono::seconds(10));
+        REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+
+        channels::shm_ring_mt::remove(name);
+    }
+
+#if !defined(PRIDE_OS_WINDOWS)
+    SECTION("Records logged before the writer process dies are collected")
+    {
+        auto name = ring_name("crash");
+        auto child = ::fork();
+        REQUIRE(child >= 0);
+        if (child == 0)
+        {
+            auto channel = std::make_shared<channels::shm_ring_st>(name, 64 * 1024);
+            logger_t logger("ring-crash");
+            logger.add_channel(channel);
+            for (int i = 0; i < 100; ++i)
+                logger.warn("record {}", i);
+            ::_exit(0); // no destructors, no flush
+        }
+
+        int status = 0;
+        ::waitpid(child, &status, 0);
+
+        shm_reader_t reader(name);
+        REQUIRE(reader.attach());
+        auto lines = drain_text(reader, "%v");
+        REQUIRE(lines.size() == 100);
+        REQUIRE(lines.front() == "record 0");
+        REQUIRE(lines.back() == "record 99");
+
+        channels::shm_ring_st::remove(name);
+    }
+#endif
+}
@@ -0,0 +1,355 @@
+#include <test.hpp>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !defined(PRIDE_OS_WINDOWS)
+#    include <arpa/inet.h>
+#    include <netinet/in.h>
+#    include <poll.h>
+#    include <sys/socket.h>
+#    include <sys/un.h>
+#    include <unistd.h>
+#endif
+
+using namespace pride::log;
+
+#if !defined(PRIDE_OS_WINDOWS)
+namespace
+{
+// Bound socket standing in for a collector, streams are accepted on receive
+class listener_t
+{
+public:
+    listener_t(int family, int type, const std::string& path = "")
+        : _type(type)
+        , _path(path)
+    {
+        _fd = ::socket(family, type, 0);
+        if (family == AF_UNIX)
+        {
+            ::unlink(path.c_str());
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, path.data(), path.size());
+            ::bind(_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        }
+        else
+        {
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            ::bind(_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+            socklen_t size = sizeof(address);
+            ::getsockname(_fd, reinterpret_cast<sockaddr*>(&address), &size);
+            _port = ntohs(address.sin_port);
+        }
+        if (type == SOCK_STREAM)
+            ::listen(_fd, 4);
+    }
+
+    ~listener_t()
+    {
+        if (_peer >= 0)
+            ::close(_peer);
+        ::close(_fd);
+        if (!_path.empty())
+            ::unlink(_path.c_str());
+    }
+
+    uint16_t port() const { return _port; }
+
+    // datagrams received until none came for a while
+    std::vector<std::string> datagrams()
+    {
+        std::vector<std::string> received;
+        char buffer[65536];
+        while (_wait(_fd))
+        {
+            auto size = ::recv(_fd, buffer, sizeof(buffer), 0);
+            if (size < 0)
+                break;
+            received.emplace_back(buffer, static_cast<size_t>(size));
+        }
+        return received;
+    }
+
+    // bytes of the stream received until none came for a while
+    std::string stream()
+    {
+        if (_peer < 0 && _wait(_fd))
+            _peer = ::accept(_fd, nullptr, nullptr);
+
+        std::string received;
+        char buffer[65536];
+        while (_peer >= 0 && _wait(_peer))
+        {
+            auto size = ::recv(_peer, buffer, sizeof(buffer), 0);
+            if (size <= 0)
+                break;
+            received.append(buffer, static_cast<size_t>(size));
+        }
+        return received;
+    }
+
+private:
+    static bool _wait(int fd)
+    {
+        pollfd poll{ fd, POLLIN, 0 };
+        return ::poll(&poll, 1, 200) > 0;
+    }
+
+    int _fd = -1;
+    int _peer = -1;
+    int _type;
+    std::string _path;
+    uint16_t _port = 0;
+};
+
+std::string socket_path(const char* test)
+{
+    return fmt::format("/tmp/pride-test-{}-{}.sock", test, ::getpid());
+}
+
+// splits RFC 6587 octet counted frames
+std::vector<std::string> octet_frames(std::string_view stream)
+{
+    std::vector<std::string> frames;
+    while (!stream.empty())
+    {
+        auto space = stream.find(' ');
+        auto size = static_cast<size_t>(std::stoul(std::string(stream.substr(0, space))));
+        frames.emplace_back(stream.substr(space + 1, size));
+        stream.remove_prefix(space + 1 + size);
+    }
+    return frames;
+}
+} // namespace
+
+TEST_CASE("Socket channel")
+{
+    SECTION("Records are batched into unix datagrams")
+    {
+        auto path = socket_path("datagram");
+        listener_t listener(AF_UNIX, SOCK_DGRAM, path);
+        auto channel = std::make_shared<channels::socket_st>(pride::os::socket_endpoint_t::unix_datagram(path), channels::socket_framing_t::newline);
+        REQUIRE(channel->connected());
+        logger_t logger("socket-datagram");
+        logger.add_channel(channel).set_pattern("%v");
+
+        for (int i = 0; i < 100; ++i)
+            logger.warn("record {}", i);
+        REQUIRE(channel->batches() == 0);
+
+        // the receive queue of a unix datagram socket is short, what does not
+        // fit stays with the channel until the next flush
+        std::vector<std::string> received;
+        for (int round = 0; round < 100 && received.size() < 100; ++round)
+        {
+            logger.flush();
+            for (auto& datagram : listener.datagrams())
+                received.push_back(datagram);
+        }
+        REQUIRE(received.size() == 100);
+        for (int i = 0; i < 100; ++i)
+            REQUIRE(received[static_cast<size_t>(i)] == fmt::format("record {}\n", i));
+        REQUIRE(channel->sent() == 100);
+        REQUIRE(channel->batches() < 100);
+        REQUIRE(channel->dropped() == 0);
+    }
+
+    SECTION("Records at the flush_on level go out right away")
+    {
+        auto path = socket_path("flush-on");
+        listener_t listener(AF_UNIX, SOCK_DGRAM, path);
+        auto channel = std::make_shared<channels::socket_st>(pride::os::socket_endpoint_t::unix_datagram(path), channels::socket_framing_t::newline);
+        channel->flush_on(sevarity_t::error);
+        logger_t logger("socket-flush-on");
+        logger.add_channel(channel).set_pattern("%v");
+
+        logger.warn("kept");
+        REQUIRE(listener.datagrams().empty());
+        logger.error("sent");
+        REQUIRE(listener.datagrams() == std::vector<std::string>{ "kept\n", "sent\n" });
+    }
+
+    SECTION("flush_every sends from the background")
+    {
+        auto path = socket_path("flush-every");
+        listener_t listener(AF_UNIX, SOCK_DGRAM, path);
+        auto channel = std::make_shared<channels::socket_mt>(pride::os::socket_endpoint_t::unix_datagram(path), channels::socket_framing_t::newline);
+        channel->flush_every(std::chrono::milliseconds(10));
+        logger_t logger("socket-flush-every");
+        logger.add_channel(channel).set_pattern("%v");
+
+        logger.warn("later");
+        REQUIRE(listener.datagrams() == std::vector<std::string>{ "later\n" });
+        REQUIRE(channel->sent() == 1);
+    }
+
+    SECTION("RFC 5424 records carry priority, time, host, process and logger")
+    {
+        auto path = socket_path("rfc5424");
+        listener_t listener(AF_UNIX, SOCK_DGRAM, path);
+        auto channel = std::make_shared<channels::socket_st>(pride::os::socket_endpoint_t::unix_datagram(path));
+        channel->app_name("pride test").facility(16);
+        logger_t logger("socket-rfc");
+        logger.add_channel(channel);
+
+        logger.warn("first {}", 1);
+        logger.error("second");
+        logger.flush();
+
+        auto received = listener.datagrams();
+        REQUIRE(received.size() == 2);
+
+        // <PRI>1 TIMESTAMP HOST APP PROCID MSGID - MSG
+        auto fields = [](const std::string& record) {
+            std::vector<std::string> parts;
+            size_t start = 0;
+            for (int i = 0; i < 6; ++i)
+            {
+                auto end = record.find(' ', start);
+                parts.push_back(record.substr(start, end - start));
+                start = end + 1;
+            }
+            parts.push_back(record.substr(start));
+            return parts;
+        };
+
+        auto first = fields(received[0]);
+        REQUIRE(first[0] == "<132>1"); // local0 and warning
+        REQUIRE(first[1].size() == 27);
+        REQUIRE(first[1][10] == 'T');
+        REQUIRE(first[1].back() == 'Z');
+        REQUIRE(first[2] != "-");
+        REQUIRE(first[3] == "pride_test");
+        REQUIRE(first[4] == std::to_string(::getpid()));
+        REQUIRE(first[5] == "socket-rfc");
+        REQUIRE(first[6] == "- first 1");
+
+        auto second = fields(received[1]);
+        REQUIRE(second[0] == "<131>1");
+        REQUIRE(second[6] == "- second");
+    }
+
+    SECTION("The MSGID follows a logger replaced at the same address")
+    {
+        auto path = socket_path("msgid");
+        listener_t listener(AF_UNIX, SOCK_DGRAM, path);
+        auto channel = std::make_shared<channels::socket_st>(pride::os::socket_endpoint_t::unix_datagram(path));
+
+        std::string names = "first";
+        message_t msg(&names, sevarity_t::warn);
+        channel->log(msg);
+        names = "second";
+        channel->log(msg);
+        channel->flush();
+
+        auto received = listener.datagrams();
+        REQUIRE(received.size() == 2);
+        REQUIRE(received[0].find(" first - ") != std::string::npos);
+        REQUIRE(received[1].find(" second - ") != std::string::npos);
+    }
+
+    SECTION("Stream sockets frame RFC 5424 records with their length")
+    {
+        auto path = socket_path("stream");
+        listener_t listener(AF_UNIX, SOCK_STREAM, path);
+        auto channel = std::make_shared<channels::socket_st>(pride::os::socket_endpoint_t::unix_stream(path));
+        logger_t logger("socket-stream");
+        logger.add_channel(channel);
+
+        for (int i = 0; i < 50; ++i)
+            logger.warn("record {}", i);
+        logger.flush();
+
+        auto frames = octet_frames(listener.stream());
+        REQUIRE(frames.size() == 50);
+        for (int i = 0; i < 50; ++i)
+        {
+            REQUIRE(frames[static_cast<size_t>(i)].rfind("<12>1 ", 0) == 0);
+            REQUIRE(frames[static_cast<size_t>(i)].find(fmt::format(" socket-stream - record {}", i)) != std::string::npos);
+        }
+    }
+
+    SECTION("Loopback TCP and UDP")
+    {
+        listener_t tcp(AF_INET, SOCK_STREAM);
+        listener_t udp(AF_INET, SOCK_DGRAM);
+        auto tcp_channel = std::make_shared<channels::socket_st>(pride::os::socket_endpoint_t::tcp("127.0.0.1", tcp.port()), channels::socket_framing_t::newline);
+        auto udp_channel = std::make_shared<channels::socket_st>(pride::os::socket_endpoint_t::udp("127.0.0.1", udp.port()), channels::socket_framing_t::newline);
+        logger_t logger("socket-loopback");
+        logger.add_channel(tcp_channel).add_channel(udp_channel).set_pattern("%v");
+
+        logger.warn("one");
+        logger.warn("two");
+        logger.flush();
+
+        REQUIRE(tcp.stream() == "one\ntwo\n");
+        REQUIRE(udp.datagrams() == std::vector<std::string>{ "one\n", "two\n" });
+    }
+
+    SECTION("Records wait under the budget while the peer is down")
+    {
+        auto path = socket_path("down");
+        ::unlink(path.c_str());
+        auto channel = std::make_shared<channels::socket_st>(pride::os::socket_endpoint_t::unix_datagram(path), channels::socket_framing_t::newline);
+        channel->budget(100).reconnect_backoff(std::chrono::milliseconds(50), std::chrono::milliseconds(100));
+        REQUIRE_FALSE(channel->connected());
+        logger_t logger("socket-down");
+        logger.add_channel(channel).set_pattern("%v");
+
+        // 10 bytes a record, ten fit the budget
+        for (int i = 0; i < 15; ++i)
+            logger.warn("record {:02}", i);
+        logger.flush();
+        REQUIRE(channel->dropped() == 5);
+        REQUIRE(channel->sent() == 0);
+
+        listener_t listener(AF_UNIX, SOCK_DGRAM, path);
+        logger.flush(); // too soon, still backing off
+        REQUIRE_FALSE(channel->connected());
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        logger.flush();
+        REQUIRE(channel->connected());
+
+        auto received = listener.datagrams();
+        REQUIRE(received.size() == 10);
+        for (int i = 0; i < 10; ++i)
+            REQUIRE(received[static_cast<size_t>(i)] == fmt::format("record {:02}\n", i));
+        REQUIRE(channel->sent() == 10);
+    }
+
+    SECTION("The channel connects again after the peer went away")
+    {
+        auto path = socket_path("reconnect");
+        auto channel = std::make_shared<channels::socket_st>(pride::os::socket_endpoint_t::unix_stream(path), channels::socket_framing_t::newline);
+        channel->reconnect_backoff(std::chrono::milliseconds(1), std::chrono::milliseconds(1));
+        logger_t logger("socket-reconnect");
+        logger.add_channel(channel).set_pattern("%v");
+
+        {
+            listener_t listener(AF_UNIX, SOCK_STREAM, path);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            logger.warn("first");
+            logger.flush();
+            REQUIRE(listener.stream() == "first\n");
+        }
+
+        // the first send after the peer closed fails and the record stays
+        logger.warn("second");
+        logger.flush();
+        REQUIRE_FALSE(channel->connected());
+
+        listener_t listener(AF_UNIX, SOCK_STREAM, path);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        logger.flush();
+        REQUIRE(listener.stream() == "second\n");
+        REQUIRE(channel->reconnects() == 1);
+    }
+}
+#endif
@@ -0,0 +1,152 @@
+#include <test.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <string>
+
+using namespace pride::log;
+
+namespace
+{
+std::string escape(const std::string& text)
+{
+    fmt::memory_buffer buffer;
+    internal::append_json_string(text, buffer);
+    return fmt::to_string(buffer);
+}
+
+std::string format(formatter_t& formatter, const message_t& msg)
+{
+    fmt::memory_buffer buffer;
+    formatter.format(msg, buffer);
+    return fmt::to_string(buffer);
+}
+
+void stamp(message_t& msg)
+{
+    msg.time = std::chrono::system_clock::from_time_t(1533206467) + std::chrono::microseconds(123456);
+    msg.thread_id = 42;
+}
+} // namespace
+
+TEST_CASE("Structured fields")
+{
+    SECTION("Fields are copied into the record")
+    {
+        field_list_t fields;
+        {
+            std::string user = "name";
+            fields.add({ { "user", user }, { "id", 7 }, { "size", 3u }, { "ratio", 0.5 }, { "ok", true } });
+        }
+        REQUIRE(fields.size() == 5);
+        REQUIRE(fields[0].key == "user");
+        REQUIRE(fields[0].type == field_type_t::string);
+        REQUIRE(fields[0].text == "name");
+        REQUIRE(fields[1].type == field_type_t::i64);
+        REQUIRE(fields[1].i == 7);
+        REQUIRE(fields[2].type == field_type_t::u64);
+        REQUIRE(fields[2].u == 3);
+        REQUIRE(fields[3].type == field_type_t::f64);
+        REQUIRE(fields[3].f == 0.5);
+        REQUIRE(fields[4].type == field_type_t::boolean);
+        REQUIRE(fields[4].b);
+
+        fields.clear();
+        REQUIRE(fields.empty());
+    }
+
+    SECTION("Escaping finds every special byte at any offset")
+    {
+        for (size_t size = 0; size < 80; ++size)
+        {
+            for (size_t at = 0; at < size; ++at)
+            {
+                for (char special : { '"', '\\', '\n', '\x01', '\x1f' })
+                {
+                    std::string text(size, 'a');
+                    text[at] = special;
+                    REQUIRE(internal::find_json_escape(text.data(), text.size()) == at);
+                }
+                std::string text(size, 'a');
+                text[at] = '=';
+                REQUIRE(internal::find_json_escape(text.data(), text.size()) == size);
+                REQUIRE(internal::find_logfmt_escape(text.data(), text.size()) == at);
+            }
+            std::string text(size, '\x7f');
+            REQUIRE(internal::find_json_escape(text.data(), text.size()) == size);
+        }
+    }
+
+    SECTION("Strings are escaped as JSON")
+    {
+        REQUIRE(escape("") == "\"\"");
+        REQUIRE(escape("plain text") == "\"plain text\"");
+        REQUIRE(escape("a \"quote\" and a \\") == "\"a \\\"quote\\\" and a \\\\\"");
+        REQUIRE(escape("tab\tline\nreturn\r") == "\"tab\\tline\\nreturn\\r\"");
+        REQUIRE(escape(std::string("\x01\x1f\b\f", 4)) == "\"\\u0001\\u001f\\b\\f\"");
+        REQUIRE(escape(std::string(40, 'x') + "\"" + std::string(40, 'y') + "\n") == "\"" + std::string(40, 'x') + "\\\"" + std::string(40, 'y') + "\\n\"");
+        REQUIRE(escape("utf-8 \xc3\xa9") == "\"utf-8 \xc3\xa9\"");
+    }
+
+    SECTION("JSON lines")
+    {
+        const std::string name = "app";
+        message_t msg(&name, sevarity_t::warn);
+        stamp(msg);
+        fmt::format_to(msg.raw, "said \"{}\"", "hi");
+        json_formatter_t formatter;
+        REQUIRE(format(formatter, msg) == "{\"time\":\"2018-08-02T10:41:07.123456Z\",\"level\":\"warn\",\"logger\":\"app\",\"thread\":42,\"msg\":\"said \\\"hi\\\"\"}\n");
+
+        static constexpr source_location_t source{ "src/main.cpp", 12, "main" };
+        msg.source = &source;
+        msg.fields.add({ { "user", "a b" }, { "id", -7 }, { "ratio", 0.5 }, { "ok", false }, { "nan", std::nan("") } });
+        REQUIRE(format(formatter, msg) == "{\"time\":\"2018-08-02T10:41:07.123456Z\",\"level\":\"warn\",\"logger\":\"app\",\"thread\":42,\"msg\":\"said \\\"hi\\\"\",\"source\":\"src/main.cpp:12\",\"user\":\"a b\",\"id\":-7,\"ratio\":0.5,\"ok\":false,\"nan\":null}\n");
+    }
+
+    SECTION("Doubles keep every digit they need")
+    {
+        const std::string name = "app";
+        message_t msg(&name, sevarity_t::info);
+        stamp(msg);
+        msg.fields.add({ { "a", 1234567.25 }, { "b", 0.1 }, { "c", 123456789012345678.0 }, { "d", 3.0 }, { "e", -2.5e-300 } });
+        const std::string fields = "\"a\":1234567.25,\"b\":0.1,\"c\":1.2345678901234568e+17,\"d\":3,\"e\":-2.5e-300}\n";
+
+        json_formatter_t json;
+        auto text = format(json, msg);
+        REQUIRE(text.substr(text.size() - fields.size()) == fields);
+
+        logfmt_formatter_t logfmt;
+        text = format(logfmt, msg);
+        REQUIRE(text.find(" a=1234567.25 b=0.1 c=1.2345678901234568e+17 d=3 e=-2.5e-300\n") != std::string::npos);
+    }
+
+    SECTION("Logfmt")
+    {
+        const std::string name = "app";
+        message_t msg(&name, sevarity_t::info);
+        stamp(msg);
+        fmt::format_to(msg.raw, "done");
+        msg.fields.add({ { "user", "a b" }, { "empty", "" }, { "id", 7u }, { "ok", true }, { "bad key", "x=y" } });
+        logfmt_formatter_t formatter;
+        REQUIRE(format(formatter, msg) == "time=2018-08-02T10:41:07.123456Z level=info logger=app thread=42 msg=done user=\"a b\" empty=\"\" id=7 ok=true bad_key=\"x=y\"\n");
+    }
+
+    SECTION("Loggers attach fields to records")
+    {
+        std::ostringstream stream;
+        logger_t logger("structured");
+        logger.add_channel<channels::ostream_st>(stream);
+        logger.set_formatter<logfmt_formatter_t>();
+
+        logger.log(sevarity_t::warn, { { "id", 1 } }, "first {}", 1);
+        logger.with({ { "user", "name" }, { "id", 2 } }).error("second");
+        logger.with({ { "id", 3 } }).debug("filtered");
+
+        auto text = stream.str();
+        REQUIRE(text.find("msg=\"first 1\" id=1\n") != std::string::npos);
+        REQUIRE(text.find("msg=second user=name id=2\n") != std::string::npos);
+        REQUIRE(text.find("filtered") == std::string::npos);
+    }
+}
@@ -0,0 +1,138 @@
+#include <test.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pride::log;
+
+namespace
+{
+std::string read_file(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream stream;
+    stream << file.rdbuf();
+    return stream.str();
+}
+} // namespace
+
+TEST_CASE("io_uring file channel")
+{
+    const std::string path = "uring-file.log";
+
+    // the same behaviour is expected from io_uring and from the writer threads
+    for (bool use_uring : { true, false })
+    {
+        SECTION(use_uring ? "Records reach the file in order (io_uring)" : "Records reach the file in order (threads)")
+        {
+            auto channel = std::make_shared<channels::uring_file_st>(path, true, 4096, 4, use_uring);
+            logger_t logger("uring-order");
+            logger.add_channel(channel).set_pattern("%v");
+            if (!use_uring)
+                REQUIRE_FALSE(channel->uses_uring());
+
+            for (int i = 0; i < 1000; ++i)
+                logger.warn("record number {:04}", i); // 19 bytes with the new line
+            logger.flush();
+
+            // 19000 bytes fill four buffers, the rest goes out on flush
+            REQUIRE(channel->submissions() == 5);
+            REQUIRE(channel->failures() == 0);
+
+            std::string expected;
+            for (int i = 0; i < 1000; ++i)
+                expected += fmt::format("record number {:04}\n", i);
+            REQUIRE(read_file(path) == expected);
+        }
+
+        SECTION(use_uring ? "Records larger than a buffer (io_uring)" : "Records larger than a buffer (threads)")
+        {
+            auto channel = std::make_shared<channels::uring_file_st>(path, true, 64, 2, use_uring);
+            logger_t logger("uring-large");
+            logger.add_channel(channel).set_pattern("%v");
+
+            logger.warn("small");
+            logger.warn("{}", std::string(300, 'x'));
+            logger.warn("tail");
+            logger.flush();
+            REQUIRE(read_file(path) == "small\n" + std::string(300, 'x') + "\ntail\n");
+        }
+
+        SECTION(use_uring ? "Appends to what is there (io_uring)" : "Appends to what is there (threads)")
+        {
+            {
+                std::ofstream file(path, std::ios::binary | std::ios::trunc);
+                file << "before\n";
+            }
+
+            {
+                auto channel = std::make_shared<channels::uring_file_st>(path, false, 4096, 2, use_uring);
+                logger_t logger("uring-append");
+                logger.add_channel(channel).set_pattern("%v");
+                logger.warn("after");
+            }
+            REQUIRE(read_file(path) == "before\nafter\n");
+        }
+    }
+
+    SECTION("Flush on level submits without waiting for the buffer to fill")
+    {
+        auto channel = std::make_shared<channels::uring_file_st>(path, true);
+        channel->flush_on(sevarity_t::error);
+        logger_t logger("uring-level");
+        logger.add_channel(channel).set_pattern("%v");
+
+        logger.warn("kept");
+        REQUIRE(channel->submissions() == 0);
+        logger.error("submitted");
+        REQUIRE(channel->submissions() == 1);
+
+        for (int i = 0; i < 200 && read_file(path).empty(); ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        REQUIRE(read_file(path) == "kept\nsubmitted\n");
+    }
+
+    SECTION("Flush interval")
+    {
+        auto channel = std::make_shared<channels::uring_file_mt>(path, true);
+        channel->flush_every(std::chrono::milliseconds(5));
+        logger_t logger("uring-interval");
+        logger.add_channel(channel).set_pattern("%v");
+
+        logger.warn("eventually");
+        for (int i = 0; i < 200 && read_file(path).empty(); ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        REQUIRE(read_file(path) == "eventually\n");
+    }
+
+    SECTION("Threads share the channel")
+    {
+        auto channel = std::make_shared<channels::uring_file_mt>(path, true, 1024, 3);
+        logger_t logger("uring-threads");
+        logger.add_channel(channel).set_pattern("%v");
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+            threads.emplace_back([&logger] {
+                for (int i = 0; i < 500; ++i)
+                    logger.warn("0123456789");
+            });
+        for (auto& thread : threads)
+            thread.join();
+        logger.flush();
+
+        REQUIRE(read_file(path) == [] {
+            std::string text;
+            for (int i = 0; i < 2000; ++i)
+                text += "0123456789\n";
+            return text;
+        }());
+    }
+
+    std::remove(path.c_str());
+}
@@ -0,0 +1,129 @@
+#include <pride/pride.hpp>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// Drains the shared memory ring of a service logging through
+// channels::shm_ring and writes the records with one of the pride channels, so
+// the service itself never touches the disk.
+//
+//   log-collect /app-log -s buffered -o app.log -p "[%Y-%m-%d %T.%e] [%l] %v"
+//   log-collect /app-log -s binary -o app.plog
+//   log-collect /app-log --once            (drain what is there and stop)
+
+namespace
+{
+std::atomic<bool> stopping{ false };
+
+void stop(int)
+{
+    stopping = true;
+}
+
+pride::log::channel_t::ptr make_sink(const std::string& kind, const std::string& output)
+{
+    using namespace pride::log;
+
+    if (kind == "stdout")
+        return std::make_shared<channels::stdout_st>();
+    if (output.empty())
+        return nullptr;
+
+    if (kind == "file")
+        return std::make_shared<channels::basic_file_st>(output);
+    if (kind == "buffered")
+        return std::make_shared<channels::buffered_file_st>(output);
+    if (kind == "uring")
+        return std::make_shared<channels::uring_file_st>(output);
+    if (kind == "mapped")
+        return std::make_shared<channels::mapped_file_st>(output);
+    if (kind == "rotating")
+        return std::make_shared<channels::rotating_file_st>(output, 64 * 1024 * 1024, 8);
+    if (kind == "binary")
+        return std::make_shared<channels::binary_file_st>(output);
+    return nullptr;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    using namespace pride;
+
+    std::string ring;
+    std::string sink = "stdout";
+    std::string output;
+    std::string pattern = "%+";
+    bool once = false;
+
+    auto cli = (cli::value("ring", ring) % "name of the shared memory ring, /app-log",
+        cli::option("-s", "--sink") & cli::value("sink", sink) % "stdout, file, buffered, uring, mapped, rotating or binary",
+        cli::option("-o", "--output") & cli::value("output", output) % "file the sink writes to",
+        cli::option("-p", "--pattern") & cli::value("pattern", pattern) % "pattern used to format each record",
+        cli::option("--once").set(once) % "drain the ring once and exit");
+
+    if (!cli::parse(argc, argv, cli))
+    {
+        std::cerr << cli::make_man_page(cli, "log-collect");
+        return 1;
+    }
+
+    auto channel = make_sink(sink, output);
+    if (channel == nullptr)
+    {
+        std::cerr << "log-collect: unknown sink '" << sink << "' or no output given\n";
+        return 1;
+    }
+    channel->pattern(pattern);
+
+    std::signal(SIGINT, stop);
+    std::signal(SIGTERM, stop);
+
+    log::shm_reader_t reader(ring);
+    while (!reader.attach())
+    {
+        if (once || stopping)
+        {
+            std::cerr << "log-collect: no ring named '" << ring << "'\n";
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    // keep draining, flush the sink whenever the ring runs dry
+    log::internal::backoff_t backoff;
+    uint64_t count = 0;
+    bool flushed = true;
+    while (!stopping)
+    {
+        auto drained = reader.drain([&](const log::message_t& msg) { channel->log(msg); });
+        count += drained;
+        if (drained > 0)
+        {
+            flushed = false;
+            backoff.reset();
+            continue;
+        }
+
+        if (!flushed)
+        {
+            channel->flush();
+            flushed = true;
+        }
+        if (once)
+            break;
+
+        // the writer wakes a parked reader, the timeout only bounds how long
+        // a stop request waits
+        if (backoff.is_sleeping())
+            reader.wait(std::chrono::milliseconds(250));
+        else
+            backoff.pause();
+    }
+    channel->flush();
+
+    std::cerr << "log-collect: " << count << " records, " << reader.missed() << " missed\n";
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include <pride/pride.hpp>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+// Turns a binary log written by deferred_logger_t::binary_output back into the
+// text the pattern formatter would have produced.
+//
+//   log-decode app.bin -p "[%Y-%m-%d %T.%e] [%l] %v" -o app.log
+
+int main(int argc, char* argv[])
+{
+    using namespace pride;
+
+    std::string input;
+    std::string output;
+    std::string pattern = "%+";
+
+    auto cli = (cli::value("input", input) % "binary log to decode",
+        cli::option("-p", "--pattern") & cli::value("pattern", pattern) % "pattern used to format each record",
+        cli::option("-o", "--output") & cli::value("output", output) % "write to a file instead of stdout");
+
+    if (!cli::parse(argc, argv, cli))
+    {
+        std::cerr << cli::make_man_page(cli, "log-decode");
+        return 1;
+    }
+
+    log::deferred::stream_reader_t reader(input);
+    if (!reader.good())
+    {
+        std::cerr << "log-decode: '" << input << "' is not a binary log\n";
+        return 1;
+    }
+
+    auto file = output.empty() ? stdout : std::fopen(output.c_str(), "wb");
+    if (file == nullptr)
+    {
+        std::cerr << "log-decode: could not open '" << output << "'\n";
+        return 1;
+    }
+
+    log::pattern_formatter_t formatter(pattern);
+    log::message_t msg;
+    log::fmt::memory_buffer buffer;
+    size_t count = 0;
+    while (reader.next(msg))
+    {
+        buffer.resize(0);
+        formatter.format(msg, buffer);
+        std::fwrite(buffer.data(), 1, buffer.size(), file);
+        ++count;
+    }
+
+    if (file != stdout)
+        std::fclose(file);
+
+    std::cerr << "log-decode: " << count << " records\n";
+    return 0;
+}